@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _number_utils_H
+#define _number_utils_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Number parsing and formatting for literals and CONVERT, independent of the locale and without
+// allocating.  Parsing reads the number at the start of s (after any spaces) and ignores what
+// follows it, as sscanf does, and *end (if not NULL) is set to just past the number.
+
+// false if s doesn't start with a number or it doesn't fit in an int / int64_t
+bool sql_parse_int(const char *s, int *value, const char **end);
+bool sql_parse_int64(const char *s, int64_t *value, const char **end);
+
+// decimal or exponent notation, INF, INFINITY, and NAN (correctly rounded, so formatting a
+// double with 17 significant digits and parsing it gives the same double)
+bool sql_parse_double(const char *s, double *value, const char **end);
+
+// the buffers given to the format functions must be at least this long
+#define SQL_INT_BUFFER_SIZE 24
+#define SQL_DOUBLE_BUFFER_SIZE 328
+
+// writes value and a '\0' to buffer and returns the length (as printf "%d" / "%" PRId64)
+size_t sql_format_int(char *buffer, int value);
+size_t sql_format_int64(char *buffer, int64_t value);
+
+// as printf "%f" (six decimals, rounded half to even from the exact value of the double)
+size_t sql_format_double(char *buffer, double value);
+
+#endif
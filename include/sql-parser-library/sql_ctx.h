@@ -8,6 +8,7 @@
 #include "the-macro-library/macro_map.h"
 #include "sql-parser-library/named_pointer.h"
 #include "sql-parser-library/sql_node.h"
+#include <stdint.h>
 
 struct sql_ctx_s;
 typedef struct sql_ctx_s sql_ctx_t;
@@ -23,6 +24,9 @@ typedef struct sql_ctx_spec_s sql_ctx_spec_t;
 struct sql_ctx_spec_update_s;
 typedef struct sql_ctx_spec_update_s sql_ctx_spec_update_t;
 
+struct sql_ctx_aggregate_s;
+typedef struct sql_ctx_aggregate_s sql_ctx_aggregate_t;
+
 struct sql_ctx_message_s;
 typedef struct sql_ctx_message_s sql_ctx_message_t;
 
@@ -40,6 +44,22 @@ void *sql_ctx_get_callback(sql_ctx_t *ctx, const char *name);
 const char *sql_ctx_get_callback_name(sql_ctx_t *ctx, void *callback);
 const char *sql_ctx_get_callback_description(sql_ctx_t *ctx, void *callback);
 
+// set the row used by column callbacks (use this rather than assigning ctx->row when the
+// same row pointer is reused for different data)
+void sql_ctx_set_row(sql_ctx_t *ctx, void *row);
+
+// Evaluation allocates its results from ctx->pool, which also holds the tokens, AST, and compiled
+// trees.  Between sql_ctx_begin_scratch and sql_ctx_end_scratch, ctx->pool is a scratch pool
+// instead, which sql_ctx_reset_scratch clears (after each row or batch, once its results aren't
+// needed) so a scan runs in constant memory.  Compile before sql_ctx_begin_scratch.
+void sql_ctx_begin_scratch(sql_ctx_t *ctx);
+void sql_ctx_reset_scratch(sql_ctx_t *ctx);
+void sql_ctx_end_scratch(sql_ctx_t *ctx);
+
+// the pool for memory which must outlive the current row (messages, aggregate states), which is
+// ctx->pool unless a scratch pool is in use
+aml_pool_t *sql_ctx_plan_pool(sql_ctx_t *ctx);
+
 // register and check reserved keywords
 void sql_ctx_reserve_keyword(sql_ctx_t *ctx, const char *keyword);
 bool sql_ctx_is_reserved_keyword(sql_ctx_t *ctx, const char *keyword);
@@ -70,12 +90,36 @@ struct sql_ctx_s {
 
     // TODO: Consider moving this to sql_data_ctx_t with own pool
     void *row;
+    // incremented by sql_ctx_set_row, cached per-row results are only reused for the same row_id
+    size_t row_id;
+    // the generation of ctx->row when a row is decoded into again without sql_ctx_set_row (as
+    // sql_json_row_decode does), also part of the key of cached per-row results (NULL if unused)
+    size_t (*row_generation)(void *row);
+
+    // the pool ctx->pool replaced while a scratch pool is in use (NULL otherwise)
+    aml_pool_t *plan_pool;
+
+    // the memos of a tree shared by several threads, indexed by sql_node_memo_t.index (each thread
+    // evaluates with its own ctx, see sql_plan.h).  Other memos are used from the nodes.
+    sql_node_memo_t *memos;
+    size_t num_memos;
 };
 
+// the dictionary code of a column's value in ctx->row (see sql_ctx_column_t)
+typedef uint32_t (*sql_ctx_code_cb)(sql_ctx_t *ctx, sql_ctx_column_t *column);
+
 struct sql_ctx_column_s {
     char *name;           // Column name
     sql_data_type_t type; // Column type (e.g., SQL_TYPE_INT, SQL_TYPE_STRING)
-    sql_node_cb func; // Function pointer to extract column value
+    sql_node_cb func; // Function pointer to extract column value (the column is value.custom of f)
+
+    // Optional dictionary encoding of a STRING column: every value is one of the dictionary_size
+    // strings in dictionary, and code returns the index of the row's value (dictionary_size or
+    // more for NULL).  func must still return the value.  Predicates on the column alone are
+    // evaluated once per entry by rewrite_dictionary_predicates, so a row only looks up its code.
+    const char **dictionary;
+    uint32_t dictionary_size;
+    sql_ctx_code_cb code;
 };
 
 // all fields must be set (even if same as input)
@@ -96,6 +140,26 @@ struct sql_ctx_spec_s {
     const char *description;         // Brief description of the function
 
     sql_ctx_update_cb update; // Function to get updates to the node
+
+    sql_ctx_aggregate_t *aggregate; // Aggregate form across rows (NULL for scalar functions)
+};
+
+/*
+    The aggregate form of a function (used in a SELECT list, see sql_select.h).  f is the call
+    after apply_type_conversions, so its parameters are already converted and its data_type is
+    the type finalize returns.  The state is state_size bytes owned by the caller, the callbacks
+    must not keep pointers into the row (copy strings into the state or ctx->pool).
+*/
+struct sql_ctx_aggregate_s {
+    size_t num_parameters;  // the call is an aggregate when it has this many parameters
+    size_t state_size;
+
+    void (*init)(sql_ctx_t *ctx, sql_node_t *f, void *state);
+    // evaluates the parameters of f for ctx->row and adds them to the state
+    void (*accumulate)(sql_ctx_t *ctx, sql_node_t *f, void *state);
+    // adds other (a state built from different rows) to state
+    void (*merge)(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other);
+    sql_node_t *(*finalize)(sql_ctx_t *ctx, sql_node_t *f, void *state);
 };
 
 // initialization
@@ -114,10 +178,13 @@ void sql_register_like(sql_ctx_t *ctx);
 
 void sql_register_convert(sql_ctx_t *ctx);
 
+void sql_register_approx_count_distinct(sql_ctx_t *ctx);
+void sql_register_approx_percentile(sql_ctx_t *ctx);
 void sql_register_avg(sql_ctx_t *ctx);
 void sql_register_coalesce(sql_ctx_t *ctx);
 void sql_register_concat(sql_ctx_t *ctx);
 void sql_register_convert_tz(sql_ctx_t *ctx);
+void sql_register_count(sql_ctx_t *ctx);
 void sql_register_date_trunc(sql_ctx_t *ctx);
 void sql_register_extract(sql_ctx_t *ctx);
 void sql_register_length(sql_ctx_t *ctx);
@@ -142,6 +209,7 @@ void register_ctx(sql_ctx_t *ctx) {
     sql_register_comparison(ctx);
     sql_register_convert_tz(ctx);
     sql_register_concat(ctx);
+    sql_register_count(ctx);
     sql_register_date_trunc(ctx);
     sql_register_extract(ctx);
     sql_register_is_boolean(ctx);
@@ -150,6 +218,8 @@ void register_ctx(sql_ctx_t *ctx) {
     sql_register_like(ctx);
     sql_register_convert(ctx);
     sql_register_avg(ctx);
+    sql_register_approx_count_distinct(ctx);
+    sql_register_approx_percentile(ctx);
     sql_register_length(ctx);
     sql_register_lower_upper(ctx);
     sql_register_min_max(ctx);
@@ -161,16 +231,29 @@ void register_ctx(sql_ctx_t *ctx) {
 }
 
 sql_node_t *sql_eval(sql_ctx_t *ctx, sql_node_t *f);
+// a memo for a node which several parents share (its index is set by sql_plan_compile)
+sql_node_memo_t *sql_memo_init(sql_ctx_t *ctx);
 sql_node_t *sql_bool_init(sql_ctx_t *ctx, bool value, bool is_null);
 // parameters, data_type are not set in sql_list_init
 sql_node_t *sql_list_init(sql_ctx_t *ctx, size_t num_elements, bool is_null);
 
 sql_node_t *sql_int_init(sql_ctx_t *ctx, int value, bool is_null);
 sql_node_t *sql_double_init(sql_ctx_t *ctx, double value, bool is_null);
+// the value is copied to the ctx's pool (NULL for an empty string)
 sql_node_t *sql_string_init(sql_ctx_t *ctx, const char *value, bool is_null);
+// as sql_string_init for the first length bytes of value
+sql_node_t *sql_string_init_length(sql_ctx_t *ctx, const char *value, size_t length, bool is_null);
+// A string node which refers to value rather than copying it, for values which outlive the node
+// (allocated from the ctx's pool, inside another node's value, or constant).  value[length] must
+// be '\0'.
+sql_node_t *sql_string_view_init(sql_ctx_t *ctx, const char *value, size_t length);
 sql_node_t *sql_compound_init(sql_ctx_t *ctx, const char *value, bool is_null);
 sql_node_t *sql_datetime_init(sql_ctx_t *ctx, time_t epoch, bool is_null);
 sql_node_t *sql_function_init(sql_ctx_t *ctx, const char *name);
+// builds a comparison, operator, or logical node bound to the spec registered as name
+// (returns NULL if there is no such spec or the parameters don't fit it)
+sql_node_t *sql_operation_init(sql_ctx_t *ctx, sql_token_type_t token_type, const char *name,
+                               sql_node_t **parameters, size_t num_parameters);
 
 void apply_type_conversions(sql_ctx_t *context, sql_node_t *node);
 
@@ -180,6 +263,37 @@ sql_node_t *copy_nodes(sql_ctx_t *ctx, sql_node_t *node);
 void simplify_func_tree(sql_ctx_t *context, sql_node_t *node );
 void simplify_logical_expressions(sql_node_t *node);
 
+// rewrite passes (see sql_optimizer.h), each returns the number of rewrites it made
+size_t fold_constant_expressions(sql_ctx_t *ctx, sql_node_t *node);
+size_t flatten_logical_expressions(sql_ctx_t *ctx, sql_node_t *node);
+size_t simplify_boolean_expressions(sql_ctx_t *ctx, sql_node_t *node);
+// simplify_boolean_expressions as the AND / OR specs evaluate (NULL if any term is): only a FALSE
+// term of an AND at the top of a filter (or in such an AND) decides it
+size_t simplify_filter_booleans(sql_ctx_t *ctx, sql_node_t *node);
+// pushes NOT down to the leaves (De Morgan, inverted comparisons, NOT IN / NOT LIKE / ...)
+size_t push_down_negations(sql_ctx_t *ctx, sql_node_t *node);
+// the forms of simplify_boolean_expressions, push_down_negations, and merge_range_predicates for a
+// value expression (a SELECT item, an aggregate argument, a GROUP BY or ORDER BY key), where NULL
+// and FALSE are different results, so nothing is folded to FALSE or IS NOT NULL
+size_t simplify_value_booleans(sql_ctx_t *ctx, sql_node_t *node);
+size_t push_down_value_negations(sql_ctx_t *ctx, sql_node_t *node);
+size_t merge_value_range_predicates(sql_ctx_t *ctx, sql_node_t *node);
+// shares identical subtrees between their parents and caches their result per row,
+// the tree is a DAG afterwards so this must be the last rewrite
+size_t share_common_subexpressions(sql_ctx_t *ctx, sql_node_t *node);
+// true if both converted trees compute the same value (columns match case-insensitively)
+bool sql_same_expression(sql_node_t *a, sql_node_t *b);
+// rewrites EXTRACT / DATE_TRUNC predicates on DATETIME columns into epoch ranges on the column,
+// returns the number of predicates rewritten
+size_t rewrite_date_predicates(sql_ctx_t *ctx, sql_node_t *node);
+// merges comparison / BETWEEN / IN predicates on the same column within AND / OR chains,
+// an unsatisfiable filter becomes the literal FALSE (returns the number of rewrites)
+size_t merge_range_predicates(sql_ctx_t *ctx, sql_node_t *node);
+// evaluates each predicate which only reads one dictionary encoded column against every entry of
+// the dictionary, and replaces it by a lookup of the row's code in the results (the tree can't be
+// rewritten by the other passes afterwards, returns the number of predicates replaced)
+size_t rewrite_dictionary_predicates(sql_ctx_t *ctx, sql_node_t *node);
+
 sql_data_type_t sql_determine_common_type(sql_data_type_t type1, sql_data_type_t type2);
 sql_node_t *sql_convert(sql_ctx_t *context, sql_node_t *param, sql_data_type_t target_type);
 
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_dependencies_H
+#define _sql_dependencies_H
+
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_select.h"
+
+// The columns a query reads, as indexes into ctx->columns (in the order of ctx->columns, see
+// ctx->columns[i].type for the type of each).  A scan can decode the filter columns of a row,
+// evaluate the WHERE clause, and only decode the output columns of the rows which match.
+typedef struct {
+    size_t *filter;       // read by the WHERE clause
+    size_t num_filter;
+    size_t *output;       // read by the SELECT list (GROUP BY, HAVING, aggregates), not by WHERE
+    size_t num_output;
+} sql_dependencies_t;
+
+// Reports the columns of a converted WHERE tree and a compiled select (either may be NULL).  The
+// result is allocated from ctx->pool.
+sql_dependencies_t *sql_dependencies(sql_ctx_t *ctx, sql_node_t *where, sql_select_t *select);
+
+// Sets used[i] for each column of ctx->columns read by a converted tree (used has
+// ctx->column_count entries), for expressions compiled elsewhere (such as ORDER BY keys)
+void sql_mark_columns(sql_ctx_t *ctx, sql_node_t *node, bool *used);
+
+#endif /* _sql_dependencies_H */
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_group_by_H
+#define _sql_group_by_H
+
+#include "sql-parser-library/sql_select.h"
+
+struct sql_group_by_s;
+typedef struct sql_group_by_s sql_group_by_t;
+
+// Hash aggregation for a compiled query (sql_select_compile).  Each row is added to the group of
+// its GROUP BY keys, a query without GROUP BY has exactly one group (even for no rows).  NULL keys
+// form a group of their own and strings are grouped case-insensitively (as = compares them).
+//
+// max_memory limits the bytes used by the hash table, the keys, and the accumulator states
+// (0 for no limit).  The table has its own pool, released by sql_group_by_destroy.
+sql_group_by_t *sql_group_by_init(sql_ctx_t *ctx, sql_select_t *select, size_t max_memory);
+void sql_group_by_destroy(sql_group_by_t *group_by);
+
+// Adds ctx->row to its group, returns false (with an error on ctx) if creating the group would
+// exceed max_memory.  The keys of a new group are copied to the table's pool, so the scratch pool
+// of ctx (sql_ctx_begin_scratch) can be reset after each batch of rows, as sql_parallel_aggregate
+// does after each morsel.
+bool sql_group_by_accumulate(sql_ctx_t *ctx, sql_group_by_t *group_by);
+
+// Splits the groups by the hash of their keys into num_partitions (call once, after the last
+// accumulate).  A group is in the same partition of every table built for the same query.
+void sql_group_by_partition(sql_group_by_t *group_by, size_t num_partitions);
+
+// Adds the groups of src (built from different rows for the same query) to group_by, merging the
+// states of groups found in both.  Only the given partition of src is merged if it was partitioned.
+// Returns false (with an error on ctx) if a new group would exceed max_memory.  Partitions of the
+// same tables can be merged at the same time into different tables (with a ctx per thread).
+bool sql_group_by_merge(sql_ctx_t *ctx, sql_group_by_t *group_by, sql_group_by_t *src, size_t partition);
+
+size_t sql_group_by_num_groups(sql_group_by_t *group_by);
+size_t sql_group_by_memory_used(sql_group_by_t *group_by);
+
+// Finalizes a group (0 to num_groups - 1, in the order the groups were first seen) into results
+// (sql_select_num_items entries).  Returns false if HAVING doesn't hold for the group.
+bool sql_group_by_result(sql_ctx_t *ctx, sql_group_by_t *group_by, size_t group, sql_node_t **results);
+
+#endif /* _sql_group_by_H */
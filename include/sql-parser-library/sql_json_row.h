@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_json_row_H
+#define _sql_json_row_H
+
+#include "sql-parser-library/sql_ctx.h"
+
+/*
+    Rows which are JSON objects.
+
+        {"id": 7, "name": "Alice", "price": 9.5, "created": "2024-01-01T10:00:00Z"}
+
+    A schema is built from the columns of a context, and maps each key to
+    its column with a hash table built once.  Decoding an object reads it
+    once, recording where the value of each column is and skipping the
+    values of other keys (strings and nested values a block of bytes at a
+    time, looking only for quotes, backslashes, and brackets).  The getter
+    the schema installs on the columns finds a column's value by index and
+    converts it to the column's type the first time it's read for the
+    object, so a column the filter never reaches (after AND short circuits)
+    is never converted.
+
+    A key is the name of a column exactly (JSON keys are case sensitive).  A
+    missing key, a null, or a value which doesn't convert to the column's type
+    (an object for an INT) is NULL.  Numbers and numeric strings convert to
+    INT and DOUBLE, true, false, numbers, and "true" / "false" / "1" / "0" to
+    BOOL, date strings and epoch seconds to DATETIME, and anything other than
+    a string to STRING as its JSON text.
+*/
+
+typedef struct sql_json_schema_s sql_json_schema_t;
+typedef struct sql_json_row_s sql_json_row_t;
+
+// A schema for the columns of ctx (allocated from its pool).  The func of every column is set to
+// the getter, so this must be called before queries are converted to nodes, and ctx->row must be
+// a sql_json_row_t of this schema when they are evaluated.
+sql_json_schema_t *sql_json_schema_init(sql_ctx_t *ctx);
+
+// A row to decode objects into.  Each thread needs its own.
+sql_json_row_t *sql_json_row_init(sql_json_schema_t *schema);
+void sql_json_row_destroy(sql_json_row_t *row);
+
+// Restricts decoding to the columns with used[i] set (used has an entry per column of the schema's
+// ctx, or is NULL for all of them, the default).  The keys of other columns are skipped like keys
+// which aren't columns, so their values are NULL.
+void sql_json_row_use_columns(sql_json_row_t *row, const bool *used);
+
+// Decodes the object in the length bytes at json (which needn't be NUL terminated) into row,
+// replacing the previous values.  Returns false (with every column NULL) if it isn't an object.
+// Reading stops once every column in use has been found, so the rest of the object is only checked
+// to end with '}' (and a later duplicate of a key is ignored).  The values are read from json
+// as they are used, so it must not change until the next decode.  Each decode bumps a generation
+// of the row which the cached results of shared subexpressions are keyed on (with ctx->row and
+// ctx->row_id), so they aren't reused for the next object even if ctx->row isn't set again.
+bool sql_json_row_decode(sql_json_row_t *row, const char *json, size_t length);
+
+// the decoded value of a column (index into the columns of the schema's ctx)
+sql_node_t *sql_json_row_value(sql_json_row_t *row, size_t index);
+
+#endif /* _sql_json_row_H */
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_ndjson_H
+#define _sql_ndjson_H
+
+#include "sql-parser-library/sql_plan.h"
+#include "sql-parser-library/sql_json_row.h"
+
+/*
+    Scanning newline delimited JSON, an object per line.
+
+        {"id": 1, "name": "Alice", "amount": 12.5}
+        {"id": 2, "name": "Bob", "amount": 7.25}
+
+    A file is memory mapped and split into chunks which workers claim one at
+    a time.  A chunk holds the lines which start in it, so a worker finds its
+    first line by looking back for the newline before the chunk and reads the
+    last one past the end of the chunk, and no line is read twice.  Each line
+    is decoded into a sql_json_row_t of the worker's own, restricted to the
+    columns the plan reads, and evaluated with an exec context of its own,
+    which is reset after each batch of lines.
+*/
+
+typedef struct sql_ndjson_s sql_ndjson_t;
+
+// Maps the file at path read only.  Returns NULL (with errno set) if it can't be opened or mapped.
+sql_ndjson_t *sql_ndjson_open(const char *path);
+void sql_ndjson_close(sql_ndjson_t *file);
+
+// the contents of the file (NULL if it's empty)
+const char *sql_ndjson_data(sql_ndjson_t *file);
+size_t sql_ndjson_size(sql_ndjson_t *file);
+
+// Called for each line which matches the WHERE clause of the plan with the line (without its
+// newline) and an exec context whose row is the decoded sql_json_row_t (so sql_exec_project can be
+// used).  Only the columns the plan reads are decoded, others are NULL.  line - data is the offset
+// of the line, for ordering.  Return false to stop the scan.
+typedef bool (*sql_ndjson_match_cb)(void *arg, sql_exec_t *exec, const char *line, size_t length);
+
+typedef struct {
+    size_t num_threads;  // 0 for the number of online processors
+    size_t chunk_size;   // bytes claimed by a worker at a time (0 for 4MB)
+    size_t batch_size;   // lines evaluated between resets of the exec context (0 for 1024)
+} sql_ndjson_options_t;
+
+// Evaluates the WHERE clause of a plan over the lines of the size bytes at data (a mapped file or
+// any other buffer), calling match for each matching line from several threads at once.  The plan
+// must be compiled on the ctx of schema.  Blank lines and lines which aren't JSON objects are
+// skipped.  options may be NULL for the defaults.  Returns false (with the errors on ctx) if
+// evaluating a line fails.
+bool sql_ndjson_scan(sql_ctx_t *ctx, sql_plan_t *plan, sql_json_schema_t *schema, const char *data,
+                     size_t size, sql_ndjson_match_cb match, void *match_arg, sql_ndjson_options_t *options);
+
+#endif /* _sql_ndjson_H */
@@ -7,6 +7,7 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include <string.h>
 #include "a-memory-library/aml_pool.h"
 
 typedef enum {
@@ -56,6 +57,15 @@ typedef struct sql_node_s sql_node_t;
 struct sql_ctx_s;
 struct sql_ctx_spec_s;
 
+// the result of a shared subexpression for the current row (see share_common_subexpressions)
+typedef struct sql_node_memo_s {
+    void *row;
+    size_t row_id;
+    size_t generation;  // of the row (see sql_ctx_t.row_generation)
+    sql_node_t *result;
+    size_t index;  // of the memo in ctx->memos when the tree is shared (see sql_plan.h)
+} sql_node_memo_t;
+
 // callback function to resolve a row
 typedef sql_node_t * (*sql_node_cb)(struct sql_ctx_s *ctx, sql_node_t *f);
 
@@ -72,13 +82,32 @@ struct sql_node_s {
         bool bool_value;
         int int_value;
         double double_value;
-        const char *string_value;
+        struct {
+            // always NUL terminated, and may point into another value (SUBSTR, TRIM) rather
+            // than a copy of it
+            const char *string_value;
+            size_t string_length;  // set by sql_string_init (see sql_node_string_length)
+        };
         time_t epoch;  // for date time
         void *custom;  // for custom data types (typically setup when func is assigned)
     } value;
 
     sql_node_t **parameters;
     size_t num_parameters;
+
+    sql_node_memo_t *memo;  // set when the node is shared by several parents
 };
 
+// the length of a string node's value, computing it for a node whose string_value was set
+// directly (string_length is 0 for those unless the string is empty)
+static inline size_t sql_node_string_length(const sql_node_t *node) {
+    const char *s = node->value.string_value;
+    if (node->value.string_length || !s || !*s)
+        return node->value.string_length;
+    return strlen(s);
+}
+
+// true for literal, compound literal, NULL, number, and list nodes
+bool is_literal(sql_node_t *node);
+
 #endif
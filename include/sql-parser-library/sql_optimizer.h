@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_optimizer_H
+#define _sql_optimizer_H
+
+#include "sql-parser-library/sql_ctx.h"
+#include <stdint.h>
+
+// a rewrite pass returns the number of rewrites it made (0 means the tree was left alone)
+typedef size_t (*sql_optimizer_pass_cb)(sql_ctx_t *ctx, sql_node_t *node);
+
+typedef struct {
+    const char *name;
+    sql_optimizer_pass_cb pass;
+    bool enabled;
+    bool final;   // runs once after the other passes reach a fixpoint
+
+    // statistics (accumulated across calls to sql_optimize)
+    size_t runs;
+    size_t rewrites;
+    uint64_t nanoseconds;
+} sql_optimizer_pass_t;
+
+typedef struct {
+    sql_ctx_t *ctx;
+
+    sql_optimizer_pass_t *passes;
+    size_t num_passes;
+    size_t size;
+
+    // the passes are repeated until none of them rewrites the tree or max_iterations is reached
+    size_t max_iterations;
+
+    // from the last call to sql_optimize
+    size_t iterations;
+    bool fixpoint;
+} sql_optimizer_t;
+
+// an optimizer without any passes
+sql_optimizer_t *sql_optimizer_init(sql_ctx_t *ctx);
+
+// an optimizer with the standard passes (in order)
+//   fold_constants     - evaluate functions whose parameters are all literals
+//   push_negations     - push NOT down to the leaves (push_down_negations)
+//   date_ranges        - EXTRACT / DATE_TRUNC predicates to epoch ranges (rewrite_date_predicates)
+//   flatten_logical    - AND(AND(a, b), c) => AND(a, b, c)
+//   merge_ranges       - merge predicates on the same column (merge_range_predicates)
+//   simplify_booleans  - remove TRUE / FALSE literals from AND / OR
+// followed by the final passes
+//   dictionary_codes     - predicates on a dictionary encoded column to a lookup of the row's code
+//                          (rewrite_dictionary_predicates)
+//   share_subexpressions - evaluate repeated subtrees once per row (share_common_subexpressions)
+sql_optimizer_t *sql_optimizer_default(sql_ctx_t *ctx);
+
+// The standard passes for a value expression (a SELECT item, an aggregate argument, a GROUP BY or
+// ORDER BY key) rather than a filter.  A filter treats NULL like FALSE, so the default passes fold
+// an impossible range to FALSE, covering ranges to IS NOT NULL, and NOT (x IN ...) to NOT IN, none
+// of which hold where NULL is a value of its own.  These passes keep every NULL result.
+sql_optimizer_t *sql_optimizer_value(sql_ctx_t *ctx);
+
+void sql_optimizer_add_pass(sql_optimizer_t *opt, const char *name, sql_optimizer_pass_cb pass);
+
+// a final pass runs once (in the order added) after the fixpoint, for passes that other
+// passes can't run after
+void sql_optimizer_add_final_pass(sql_optimizer_t *opt, const char *name, sql_optimizer_pass_cb pass);
+
+// returns false if there is no pass with the given name
+bool sql_optimizer_enable_pass(sql_optimizer_t *opt, const char *name, bool enabled);
+
+void sql_optimizer_set_max_iterations(sql_optimizer_t *opt, size_t max_iterations);
+
+// rewrites node in place and returns it
+sql_node_t *sql_optimize(sql_optimizer_t *opt, sql_node_t *node);
+
+void sql_optimizer_print_stats(sql_optimizer_t *opt);
+
+#endif /* _sql_optimizer_H */
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_order_by_H
+#define _sql_order_by_H
+
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_ast.h"
+
+struct sql_order_by_s;
+typedef struct sql_order_by_s sql_order_by_t;
+
+// Compiles the ORDER BY keys, LIMIT, and OFFSET of an AST from build_ast and prepares to collect
+// rows.  Each row kept is a copy of row_size bytes given to sql_order_by_add (the row itself, or
+// an index or id to fetch it by).  A key which is an alias of the SELECT list or a position in it
+// (ORDER BY 2) sorts by that item.  NULLs sort last for ASC and first for DESC unless NULLS FIRST /
+// NULLS LAST is given, strings sort ignoring case, and rows with equal keys stay in the order they
+// were added.  Returns NULL (with an error on ctx) if a key can't be compiled, is a position outside
+// the SELECT list, or names neither a column nor an alias.  The rows have their own pool, released
+// by sql_order_by_destroy.
+sql_order_by_t *sql_order_by_init(sql_ctx_t *ctx, sql_ast_node_t *ast, size_t row_size);
+void sql_order_by_destroy(sql_order_by_t *order_by);
+
+// Adds ctx->row (call for each row which matches the WHERE clause), keeping row_size bytes of row
+// if it may be in the result.  With LIMIT only OFFSET + LIMIT rows are kept.  Returns false once
+// no later row can be in the result (LIMIT without ORDER BY), so the scan can stop.
+bool sql_order_by_add(sql_ctx_t *ctx, sql_order_by_t *order_by, const void *row);
+
+// sorts the rows kept (call once, after the last sql_order_by_add)
+void sql_order_by_finish(sql_order_by_t *order_by);
+
+// the rows in order, OFFSET rows already skipped
+size_t sql_order_by_num_rows(sql_order_by_t *order_by);
+const void *sql_order_by_row(sql_order_by_t *order_by, size_t row);
+
+#endif /* _sql_order_by_H */
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_parallel_aggregate_H
+#define _sql_parallel_aggregate_H
+
+#include "sql-parser-library/sql_group_by.h"
+
+struct sql_parallel_aggregate_s;
+typedef struct sql_parallel_aggregate_s sql_parallel_aggregate_t;
+
+// returns the row (set as ctx->row for the column callbacks) at index, it is called from several
+// threads at once and the row must stay valid until the next call from the same thread
+typedef void *(*sql_row_source_cb)(void *arg, size_t index);
+
+typedef struct {
+    size_t num_threads;  // 0 for the number of online processors
+    size_t morsel_size;  // rows a worker claims at a time (0 for 16384)
+    size_t max_memory;   // of each worker's table and each merged partition (0 for no limit)
+} sql_parallel_options_t;
+
+// Runs the WHERE, GROUP BY, HAVING, and aggregates of an AST from build_ast over rows 0 to
+// num_rows - 1 with a pool of worker threads.  ctx must be set up (columns and registered
+// functions) and isn't changed by the workers.  options may be NULL for the defaults.  Returns
+// NULL (with the errors on ctx) if the query can't be compiled or a table exceeds max_memory.
+sql_parallel_aggregate_t *sql_parallel_aggregate(sql_ctx_t *ctx, sql_ast_node_t *ast,
+                                                 sql_row_source_cb source, void *arg, size_t num_rows,
+                                                 sql_parallel_options_t *options);
+void sql_parallel_aggregate_destroy(sql_parallel_aggregate_t *parallel);
+
+// the query compiled on ctx (for sql_select_num_items)
+sql_select_t *sql_parallel_aggregate_select(sql_parallel_aggregate_t *parallel);
+
+size_t sql_parallel_aggregate_num_groups(sql_parallel_aggregate_t *parallel);
+
+// The groups are merged in partitions (one per thread, or one without GROUP BY) split by the hash
+// of their keys, the number of groups in each shows how evenly the merge was spread.
+size_t sql_parallel_aggregate_num_partitions(sql_parallel_aggregate_t *parallel);
+size_t sql_parallel_aggregate_partition_groups(sql_parallel_aggregate_t *parallel, size_t partition);
+
+// Finalizes a group (0 to num_groups - 1, in no particular order) into results, returns false if
+// HAVING doesn't hold for the group.  Call from one thread at a time.
+bool sql_parallel_aggregate_result(sql_ctx_t *ctx, sql_parallel_aggregate_t *parallel, size_t group,
+                                   sql_node_t **results);
+
+#endif /* _sql_parallel_aggregate_H */
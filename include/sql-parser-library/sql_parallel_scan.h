@@ -0,0 +1,31 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_parallel_scan_H
+#define _sql_parallel_scan_H
+
+#include "sql-parser-library/sql_plan.h"
+#include "sql-parser-library/sql_parallel_aggregate.h"
+
+// Called for each row which matches the WHERE clause of the plan with the index of the row and an
+// exec context whose row is the matching row (so sql_exec_project can be used).  Return false to
+// stop the scan.
+typedef bool (*sql_scan_match_cb)(void *arg, sql_exec_t *exec, size_t index);
+
+typedef struct {
+    size_t num_threads;  // 0 for the number of online processors
+    size_t morsel_size;  // rows scanned as a unit of work (0 for 16384)
+    bool ordered;        // report the matches in row order
+} sql_parallel_scan_options_t;
+
+// Evaluates the WHERE clause of a plan over rows 0 to num_rows - 1 with a pool of worker threads,
+// calling match for each matching row.  Unordered, match is called by the worker which found the
+// row as soon as it's found, from several threads at once.  Ordered, match is called one row at a
+// time in row order.  options may be NULL for the defaults.  Returns false (with the errors on
+// ctx, the ctx the plan was compiled on) if evaluating a row fails.
+bool sql_parallel_scan(sql_ctx_t *ctx, sql_plan_t *plan, sql_row_source_cb source, void *source_arg,
+                       size_t num_rows, sql_scan_match_cb match, void *match_arg,
+                       sql_parallel_scan_options_t *options);
+
+#endif /* _sql_parallel_scan_H */
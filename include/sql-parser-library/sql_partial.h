@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_partial_H
+#define _sql_partial_H
+
+#include "sql-parser-library/sql_ctx.h"
+
+// A column whose value is known before any row is read (such as a partition key)
+typedef struct {
+    const char *name;
+    sql_node_t *value;   // a literal (a NULL literal if the column is NULL), converted to the column's type
+} sql_column_binding_t;
+
+// Returns a copy of a converted WHERE tree with the bound columns replaced by their values and
+// simplified (sql_optimizer_default, with AND / OR folded as they evaluate, see sql_partial.c).
+// The result is the literal TRUE when every row matches, FALSE when none can (a NULL filter is
+// returned as FALSE), or the residual predicate over the unbound columns, which gives the same
+// result as where for every row.  where is not modified.
+sql_node_t *sql_partial_eval(sql_ctx_t *ctx, sql_node_t *where,
+                             sql_column_binding_t *bindings, size_t num_bindings);
+
+// true if node is the literal TRUE / FALSE (as returned by sql_partial_eval)
+bool sql_is_bool_literal(sql_node_t *node, bool value);
+
+#endif /* _sql_partial_H */
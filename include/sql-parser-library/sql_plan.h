@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_plan_H
+#define _sql_plan_H
+
+#include "sql-parser-library/sql_select.h"
+
+struct sql_plan_s;
+typedef struct sql_plan_s sql_plan_t;
+
+struct sql_exec_s;
+typedef struct sql_exec_s sql_exec_t;
+
+// Compiles the WHERE clause and SELECT list of an AST from build_ast (converted, type checked, and
+// optimized) into a plan which isn't changed once compiled, so it can be evaluated from several
+// threads at once, each with an exec context of its own.  The plan is allocated from ctx->pool;
+// ctx must outlive it and not be changed while exec contexts use it.  Returns NULL (with an error
+// on ctx) if the query can't be compiled.
+sql_plan_t *sql_plan_compile(sql_ctx_t *ctx, sql_ast_node_t *ast);
+
+// the compiled WHERE clause (NULL if there is none) and SELECT list (NULL without one)
+sql_node_t *sql_plan_where(sql_plan_t *plan);
+sql_select_t *sql_plan_select(sql_plan_t *plan);
+
+// The state of one thread evaluating a plan: a copy of the plan's ctx with its own row, errors,
+// warnings, memos, and a scratch pool which everything evaluated is allocated from.
+sql_exec_t *sql_exec_init(sql_plan_t *plan);
+void sql_exec_destroy(sql_exec_t *exec);
+
+// the ctx to evaluate the plan's trees with (and read the errors of evaluation from)
+sql_ctx_t *sql_exec_ctx(sql_exec_t *exec);
+
+// sets the row and returns true if it matches the WHERE clause (always without one)
+bool sql_exec_matches(sql_exec_t *exec, void *row);
+
+// evaluates the SELECT list for the row of the last sql_exec_matches (see sql_select_project)
+bool sql_exec_project(sql_exec_t *exec, sql_select_value_t *row);
+
+// Releases everything evaluated since the last reset (the errors and warnings are kept), so a scan
+// resetting after each row or batch runs in constant memory.
+void sql_exec_reset(sql_exec_t *exec);
+
+#endif /* _sql_plan_H */
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_sargable_H
+#define _sql_sargable_H
+
+#include "sql-parser-library/sql_ctx.h"
+
+// The values a column may take.  Strings are ordered case-insensitively (as in comparison.c)
+// and INT bounds are always inclusive.
+typedef struct {
+    sql_node_t *column;
+    sql_data_type_t type;
+
+    // bounds (NULL when unbounded)
+    sql_node_t *lo;
+    sql_node_t *hi;
+    bool lo_inclusive;
+    bool hi_inclusive;
+
+    // IN set (values is NULL when the column isn't restricted to a set)
+    sql_node_t **values;
+    size_t num_values;
+
+    bool empty;
+} sql_range_t;
+
+// describes a comparison / BETWEEN / IN predicate between a column and literals as a range
+// (returns false if the predicate isn't one)
+bool sql_range_init(sql_ctx_t *ctx, sql_node_t *predicate, sql_range_t *r);
+// r = r AND s (both on the same column)
+void sql_range_intersect(sql_ctx_t *ctx, sql_range_t *r, sql_range_t *s);
+// applies the bounds to the IN set and sets empty if no value is left
+void sql_range_normalize(sql_ctx_t *ctx, sql_range_t *r);
+
+// What the filter requires of one column.  All of the parts must hold.
+typedef struct {
+    const char *name;
+    sql_data_type_t type;
+
+    bool has_range;
+    sql_range_t range;
+
+    // LIKE 'prefix%' - the value starts with prefix (case-insensitive like LIKE)
+    const char *prefix;
+
+    bool is_null;
+    bool is_not_null;   // also set by any range or prefix
+
+    bool empty;         // no value can match
+} sql_column_constraint_t;
+
+typedef struct {
+    sql_column_constraint_t *columns;
+    size_t num_columns;
+
+    // what must still be evaluated for each row (the literal TRUE if nothing is left)
+    sql_node_t *residual;
+
+    // some column can't match, the filter is always false
+    bool always_false;
+} sql_sargable_t;
+
+// Splits the top level AND of a converted WHERE tree into per-column constraints which a
+// storage layer can use for key range scans / index seeks, and the residual predicate.
+// The filter is equivalent to all of the constraints AND the residual.  where is not modified
+// (run sql_optimize first so NOTs are pushed down and ranges merged).
+sql_sargable_t *sql_extract_sargable(sql_ctx_t *ctx, sql_node_t *where);
+
+// the constraint on a column (or NULL if the column isn't constrained)
+sql_column_constraint_t *sql_sargable_column(sql_sargable_t *s, const char *name);
+
+void sql_print_sargable(sql_ctx_t *ctx, sql_sargable_t *s);
+
+#endif /* _sql_sargable_H */
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_select_H
+#define _sql_select_H
+
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_ast.h"
+
+struct sql_select_s;
+typedef struct sql_select_s sql_select_t;
+
+// Compiles the SELECT list, GROUP BY keys, and HAVING of an AST from build_ast (converted, type
+// checked, and optimized like a WHERE clause, '*' expands to every column).  A call to a function
+// with an aggregate form (SUM, AVG, MIN, MAX, COUNT, ...) with a single argument is aggregated
+// across rows, other calls stay scalar.  Returns NULL (with an error on ctx) if the query can't
+// be compiled.
+sql_select_t *sql_select_compile(sql_ctx_t *ctx, sql_ast_node_t *ast);
+
+size_t sql_select_num_items(sql_select_t *select);
+// the compiled expression of an item (aggregate calls are replaced by their result)
+sql_node_t *sql_select_item(sql_select_t *select, size_t item);
+// the alias of an item (AS), or the name of the column or function it is, otherwise "?column?"
+const char *sql_select_item_name(sql_select_t *select, size_t item);
+sql_data_type_t sql_select_item_type(sql_select_t *select, size_t item);
+
+size_t sql_select_num_aggregates(sql_select_t *select);
+// an aggregate call of an item or HAVING (its parameters are evaluated for each row)
+sql_node_t *sql_select_aggregate(sql_select_t *select, size_t aggregate);
+
+// the compiled HAVING clause (NULL if there is none)
+sql_node_t *sql_select_having(sql_select_t *select);
+
+// the GROUP BY expressions (evaluated for each row to find its group, see sql_group_by.h)
+size_t sql_select_num_group_keys(sql_select_t *select);
+sql_node_t *sql_select_group_key(sql_select_t *select, size_t key);
+
+// The accumulators of every aggregate live in one block of sql_select_state_size bytes owned by
+// the caller, so the memory used doesn't depend on the number of rows.  Several states (one per
+// thread or per group) can be used with the same select.
+size_t sql_select_state_size(sql_select_t *select);
+void sql_select_state_init(sql_ctx_t *ctx, sql_select_t *select, void *state);
+
+// Adds ctx->row to the state (call for each row which matches the WHERE clause).  The arguments
+// are evaluated into ctx->pool, while the state keeps nothing from it (strings it holds are copied
+// to sql_ctx_plan_pool), so a long scan can run between sql_ctx_begin_scratch and
+// sql_ctx_end_scratch and call sql_ctx_reset_scratch after each batch of rows.
+void sql_select_accumulate(sql_ctx_t *ctx, sql_select_t *select, void *state);
+
+// adds other (accumulated from different rows) to state
+void sql_select_merge(sql_ctx_t *ctx, sql_select_t *select, void *state, const void *other);
+
+// Finalizes the aggregates and evaluates each item into results (sql_select_num_items entries).
+// Returns false (without evaluating the items) if HAVING doesn't hold.  Only for a query without
+// GROUP BY, sql_select_finalize_group is given the values of the keys of a group.
+bool sql_select_finalize(sql_ctx_t *ctx, sql_select_t *select, void *state, sql_node_t **results);
+bool sql_select_finalize_group(sql_ctx_t *ctx, sql_select_t *select, sql_node_t **keys, void *state,
+                               sql_node_t **results);
+
+// A value of an output row, the member of value set is the one for the item's type.  Strings point
+// at the row or at ctx->pool, so they are valid until either changes.
+typedef struct {
+    bool is_null;
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        const char *string_value;
+        time_t epoch;
+    } value;
+} sql_select_value_t;
+
+// Evaluates each item for ctx->row (set with sql_ctx_set_row, call for each row which matches the
+// WHERE clause) into row (sql_select_num_items entries).  Only the columns the items use are read,
+// each once per row.  Returns false if HAVING doesn't hold, or (with an error on ctx) if the query
+// aggregates, as its items are only known once all rows are seen (see sql_select_finalize).
+bool sql_select_project(sql_ctx_t *ctx, sql_select_t *select, sql_select_value_t *row);
+
+#endif /* _sql_select_H */
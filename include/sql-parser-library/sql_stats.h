@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_stats_H
+#define _sql_stats_H
+
+#include "sql-parser-library/sql_ctx.h"
+
+// Statistics for one column of a block of rows (a zone map entry).  min / max are literals
+// of the column's type (NULL when unknown) over the non-NULL values, strings are ordered
+// case-insensitively (as in comparison.c).
+typedef struct {
+    const char *name;
+    sql_node_t *min;
+    sql_node_t *max;
+    size_t null_count;
+    size_t row_count;   // null_count == row_count when every value is NULL
+} sql_column_stats_t;
+
+typedef enum {
+    SQL_STATS_ALWAYS_FALSE,   // no row in the block can match, skip it
+    SQL_STATS_MAYBE,          // evaluate the filter for each row
+    SQL_STATS_ALWAYS_TRUE     // every row in the block matches
+} sql_stats_result_t;
+
+const char *sql_stats_result_name(sql_stats_result_t result);
+
+// Evaluates a converted WHERE tree against the statistics of a block instead of its rows.
+// Columns without statistics may hold any value.  The answer is conservative, MAYBE is
+// returned whenever the statistics can't decide.
+sql_stats_result_t sql_eval_stats(sql_ctx_t *ctx, sql_node_t *where,
+                                  sql_column_stats_t *stats, size_t num_stats);
+
+#endif /* _sql_stats_H */
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef _sql_strcase_H
+#define _sql_strcase_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+    Case insensitive string kernels, used wherever SQL compares strings.
+
+        SELECT * FROM t WHERE name = 'Alice' OR city LIKE '%york%'
+
+    Only A-Z and a-z fold (as strcasecmp does in the C locale), so folding
+    never changes a length: strings of different lengths are never equal,
+    and the order is that of strcasecmp.  The loops run 32 bytes at a time
+    with AVX2 and 16 with SSE2 when the compiler targets them, and a byte at
+    a time otherwise (and for the tails).
+*/
+
+static inline char sql_ascii_tolower(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c + ('a' - 'A')) : c;
+}
+
+static inline char sql_ascii_toupper(char c) {
+    return c >= 'a' && c <= 'z' ? (char)(c - ('a' - 'A')) : c;
+}
+
+bool sql_strcase_equal(const char *a, size_t a_length, const char *b, size_t b_length);
+
+// < 0, 0, or > 0 as strcasecmp
+int sql_strcase_compare(const char *a, size_t a_length, const char *b, size_t b_length);
+
+// true if s starts / ends with affix
+bool sql_strcase_prefix(const char *s, size_t length, const char *prefix, size_t prefix_length);
+bool sql_strcase_suffix(const char *s, size_t length, const char *suffix, size_t suffix_length);
+
+// the first occurrence of needle in s, or NULL
+const char *sql_strcase_find(const char *s, size_t length, const char *needle, size_t needle_length);
+
+// length bytes of src lower / upper cased into dest (which may be src)
+void sql_ascii_lower(char *dest, const char *src, size_t length);
+void sql_ascii_upper(char *dest, const char *src, size_t length);
+
+#endif /* _sql_strcase_H */
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+    APPROX_COUNT_DISTINCT(expr) with a HyperLogLog sketch.
+
+        SELECT region, APPROX_COUNT_DISTINCT(user_id) FROM t GROUP BY region
+
+    Each value is hashed to 64 bits, the top SQL_HLL_PRECISION bits pick a
+    register and the register keeps the longest run of leading zeros (plus
+    one) seen in the rest of the hash.  The state is the registers (4 KiB
+    whatever the number of rows), the standard error is about
+    1.04 / sqrt(4096) = 1.6%, and two sketches merge by taking the larger of
+    each register.  Strings hash ignoring case, as = compares them.
+*/
+
+#define SQL_HLL_PRECISION 12
+#define SQL_HLL_REGISTERS (1 << SQL_HLL_PRECISION)
+
+typedef struct {
+    uint8_t registers[SQL_HLL_REGISTERS];
+} sql_hll_state_t;
+
+// the finalizer of splitmix64, spreads similar values (small ints) over all of the bits
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t hash_value(sql_data_type_t type, sql_node_t *v) {
+    switch (type) {
+        case SQL_TYPE_BOOL:
+            return mix64(v->value.bool_value ? 2 : 1);
+        case SQL_TYPE_INT:
+            return mix64((uint64_t)(int64_t)v->value.int_value);
+        case SQL_TYPE_DOUBLE: {
+            // -0.0 and 0.0 are the same value
+            double d = v->value.double_value == 0.0 ? 0.0 : v->value.double_value;
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            return mix64(bits);
+        }
+        case SQL_TYPE_DATETIME:
+            return mix64((uint64_t)v->value.epoch);
+        case SQL_TYPE_STRING: {
+            // FNV-1a of the lower cased string
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (const char *s = v->value.string_value ? v->value.string_value : ""; *s; s++) {
+                hash ^= (unsigned char)tolower((unsigned char)*s);
+                hash *= 0x100000001b3ULL;
+            }
+            return mix64(hash);
+        }
+        default:
+            return 0;
+    }
+}
+
+static void hll_add(sql_hll_state_t *s, uint64_t hash) {
+    size_t index = (size_t)(hash >> (64 - SQL_HLL_PRECISION));
+    uint64_t bits = hash << SQL_HLL_PRECISION;
+    uint8_t rank = 1;
+    while (rank <= 64 - SQL_HLL_PRECISION && !(bits & 0x8000000000000000ULL)) {
+        rank++;
+        bits <<= 1;
+    }
+    if (rank > s->registers[index])
+        s->registers[index] = rank;
+}
+
+static double hll_estimate(const sql_hll_state_t *s) {
+    double m = SQL_HLL_REGISTERS;
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < SQL_HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -(int)s->registers[i]);
+        if (!s->registers[i])
+            zeros++;
+    }
+    double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    // linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros)
+        estimate = m * log(m / (double)zeros);
+    return estimate;
+}
+
+// a single row has one distinct value unless it's NULL
+static sql_node_t *sql_func_approx_count_distinct(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    return sql_int_init(ctx, child && !child->is_null ? 1 : 0, false);
+}
+
+static sql_ctx_spec_update_t *update_approx_count_distinct_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
+    if (f->num_parameters != 1) {
+        sql_ctx_error(ctx, "APPROX_COUNT_DISTINCT requires exactly one parameter.");
+        return NULL;
+    }
+
+    sql_ctx_spec_update_t *update = (sql_ctx_spec_update_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_ctx_spec_update_t));
+    update->num_parameters = f->num_parameters;
+    update->parameters = f->parameters;
+    update->expected_data_types = (sql_data_type_t *)aml_pool_alloc(ctx->pool, sizeof(sql_data_type_t));
+    // values of any type can be counted
+    update->expected_data_types[0] = SQL_TYPE_UNKNOWN;
+
+    update->implementation = sql_func_approx_count_distinct;
+    update->return_type = SQL_TYPE_INT;
+    return update;
+}
+
+static void approx_count_distinct_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    memset(state, 0, sizeof(sql_hll_state_t));
+}
+
+static void approx_count_distinct_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (!child || child->is_null)
+        return;
+    hll_add((sql_hll_state_t *)state, hash_value(f->parameters[0]->data_type, child));
+}
+
+static void approx_count_distinct_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_hll_state_t *s = (sql_hll_state_t *)state;
+    const sql_hll_state_t *o = (const sql_hll_state_t *)other;
+    for (size_t i = 0; i < SQL_HLL_REGISTERS; i++) {
+        if (o->registers[i] > s->registers[i])
+            s->registers[i] = o->registers[i];
+    }
+}
+
+static sql_node_t *approx_count_distinct_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    double estimate = round(hll_estimate((sql_hll_state_t *)state));
+    return sql_int_init(ctx, estimate > INT_MAX ? INT_MAX : (int)estimate, false);
+}
+
+static sql_ctx_aggregate_t approx_count_distinct_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_hll_state_t),
+    .init = approx_count_distinct_init,
+    .accumulate = approx_count_distinct_accumulate,
+    .merge = approx_count_distinct_merge,
+    .finalize = approx_count_distinct_finalize
+};
+
+sql_ctx_spec_t approx_count_distinct_spec = {
+    .name = "APPROX_COUNT_DISTINCT",
+    .description = "Estimates the number of distinct values which are not NULL (HyperLogLog).",
+    .update = update_approx_count_distinct_spec,
+    .aggregate = &approx_count_distinct_aggregate
+};
+
+void sql_register_approx_count_distinct(sql_ctx_t *ctx) {
+    sql_ctx_register_spec(ctx, &approx_count_distinct_spec);
+
+    sql_ctx_register_callback(ctx, sql_func_approx_count_distinct, "approx_count_distinct",
+                              "Estimates the number of distinct values which are not NULL.");
+}
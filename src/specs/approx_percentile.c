@@ -0,0 +1,223 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    APPROX_PERCENTILE(expr, p) with a merging t-digest.
+
+        SELECT region, APPROX_PERCENTILE(latency, 0.99) FROM t GROUP BY region
+
+    Values are buffered and then merged with the existing centroids (sorted by
+    mean) whenever the buffer fills.  Neighbouring centroids are combined as
+    long as the pair spans at most one unit of the scale function
+    k(q) = compression / (2 pi) * asin(2q - 1), which is steep near q = 0 and
+    q = 1, so centroids stay small (and the tails accurate) where percentiles
+    like 0.99 are read.  Any two neighbours of a merged digest span more than
+    one unit and k spans compression / 2 units, so there are at most
+    compression + 1 centroids and the state has a fixed size (about 3 KiB).
+    Two digests merge by compressing the centroids and buffers of both.
+
+    A percentile interpolates between the centers of the centroids around it,
+    and between the smallest / largest value and the first / last centroid.
+*/
+
+#define SQL_TDIGEST_COMPRESSION 100.0
+#define SQL_TDIGEST_CENTROIDS 128
+#define SQL_TDIGEST_BUFFER 128
+#define SQL_TDIGEST_PI 3.14159265358979323846
+
+typedef struct {
+    double mean;
+    double weight;
+} sql_centroid_t;
+
+typedef struct {
+    sql_centroid_t centroids[SQL_TDIGEST_CENTROIDS];
+    double buffer[SQL_TDIGEST_BUFFER];
+    size_t num_centroids;
+    size_t num_buffered;
+    double min;
+    double max;
+} sql_tdigest_state_t;
+
+static int compare_centroids(const void *a, const void *b) {
+    double x = ((const sql_centroid_t *)a)->mean;
+    double y = ((const sql_centroid_t *)b)->mean;
+    return (x > y) - (x < y);
+}
+
+static double scale(double q) {
+    return SQL_TDIGEST_COMPRESSION / (2.0 * SQL_TDIGEST_PI) * asin(2.0 * q - 1.0);
+}
+
+// merges the buffer of s and the centroids and buffer of other (if not NULL) into the centroids of s
+static void compress(sql_tdigest_state_t *s, const sql_tdigest_state_t *other) {
+    sql_centroid_t all[2 * (SQL_TDIGEST_CENTROIDS + SQL_TDIGEST_BUFFER)];
+    size_t n = 0;
+    double total = 0.0;
+    for (const sql_tdigest_state_t *d = s; d; d = d == s ? other : NULL) {
+        for (size_t i = 0; i < d->num_centroids; i++) {
+            all[n++] = d->centroids[i];
+            total += d->centroids[i].weight;
+        }
+        for (size_t i = 0; i < d->num_buffered; i++) {
+            all[n].mean = d->buffer[i];
+            all[n++].weight = 1.0;
+            total += 1.0;
+        }
+    }
+    s->num_buffered = 0;
+    if (!n)
+        return;
+    qsort(all, n, sizeof(sql_centroid_t), compare_centroids);
+
+    sql_centroid_t current = all[0];
+    double weight_before = 0.0;  // of the centroids already written
+    size_t num_centroids = 0;
+    for (size_t i = 1; i < n; i++) {
+        double weight = current.weight + all[i].weight;
+        if (scale((weight_before + weight) / total) - scale(weight_before / total) <= 1.0 ||
+            num_centroids == SQL_TDIGEST_CENTROIDS - 1) {
+            current.mean += (all[i].mean - current.mean) * all[i].weight / weight;
+            current.weight = weight;
+            continue;
+        }
+        s->centroids[num_centroids++] = current;
+        weight_before += current.weight;
+        current = all[i];
+    }
+    s->centroids[num_centroids++] = current;
+    s->num_centroids = num_centroids;
+}
+
+// positions run from 0 (the smallest value) to total - 1 (the largest) as in PERCENTILE_CONT, so
+// centroids of a single value give the exact result
+static double tdigest_quantile(sql_tdigest_state_t *s, double q) {
+    sql_centroid_t *c = s->centroids;
+    size_t n = s->num_centroids;
+    double total = 0.0;
+    for (size_t i = 0; i < n; i++)
+        total += c[i].weight;
+
+    double target = q * (total - 1.0);
+    double center = (c[0].weight - 1.0) / 2.0;  // the position of the current centroid's mean
+    if (target <= center)
+        return center > 0.0 ? s->min + (c[0].mean - s->min) * target / center : c[0].mean;
+    for (size_t i = 0; i + 1 < n; i++) {
+        double step = (c[i].weight + c[i + 1].weight) / 2.0;
+        if (target <= center + step)
+            return c[i].mean + (c[i + 1].mean - c[i].mean) * (target - center) / step;
+        center += step;
+    }
+    double rest = total - 1.0 - center;
+    return rest > 0.0 ? c[n - 1].mean + (s->max - c[n - 1].mean) * (target - center) / rest : c[n - 1].mean;
+}
+
+// the only value of a single row is every percentile of it
+static sql_node_t *sql_func_approx_percentile(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (!child || child->is_null)
+        return sql_double_init(ctx, 0, true);
+    return sql_double_init(ctx, child->value.double_value, false);
+}
+
+static sql_ctx_spec_update_t *update_approx_percentile_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
+    if (f->num_parameters != 2) {
+        sql_ctx_error(ctx, "APPROX_PERCENTILE requires two parameters (expression, percentile).");
+        return NULL;
+    }
+    if (f->parameters[0]->data_type != SQL_TYPE_DOUBLE && f->parameters[0]->data_type != SQL_TYPE_INT) {
+        sql_ctx_error(ctx, "APPROX_PERCENTILE only supports numeric data types (INT, DOUBLE).");
+        return NULL;
+    }
+    sql_node_t *p = f->parameters[1];
+    double percentile = p->data_type == SQL_TYPE_INT ? p->value.int_value : p->value.double_value;
+    if (p->token_type != SQL_NUMBER || p->is_null || percentile < 0.0 || percentile > 1.0) {
+        sql_ctx_error(ctx, "The percentile of APPROX_PERCENTILE must be a number between 0 and 1.");
+        return NULL;
+    }
+
+    sql_ctx_spec_update_t *update = (sql_ctx_spec_update_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_ctx_spec_update_t));
+    update->num_parameters = f->num_parameters;
+    update->parameters = f->parameters;
+    update->expected_data_types = (sql_data_type_t *)aml_pool_alloc(ctx->pool, 2 * sizeof(sql_data_type_t));
+    update->expected_data_types[0] = SQL_TYPE_DOUBLE;
+    update->expected_data_types[1] = SQL_TYPE_DOUBLE;
+
+    update->implementation = sql_func_approx_percentile;
+    update->return_type = SQL_TYPE_DOUBLE;
+    return update;
+}
+
+static void approx_percentile_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_tdigest_state_t *s = (sql_tdigest_state_t *)state;
+    s->num_centroids = 0;
+    s->num_buffered = 0;
+    s->min = INFINITY;
+    s->max = -INFINITY;
+}
+
+static void approx_percentile_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_tdigest_state_t *s = (sql_tdigest_state_t *)state;
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (!child || child->is_null || isnan(child->value.double_value))
+        return;
+    double value = child->value.double_value;
+    if (s->num_buffered == SQL_TDIGEST_BUFFER)
+        compress(s, NULL);
+    s->buffer[s->num_buffered++] = value;
+    if (value < s->min)
+        s->min = value;
+    if (value > s->max)
+        s->max = value;
+}
+
+static void approx_percentile_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_tdigest_state_t *s = (sql_tdigest_state_t *)state;
+    const sql_tdigest_state_t *o = (const sql_tdigest_state_t *)other;
+    if (!o->num_centroids && !o->num_buffered)
+        return;
+    compress(s, o);
+    if (o->min < s->min)
+        s->min = o->min;
+    if (o->max > s->max)
+        s->max = o->max;
+}
+
+static sql_node_t *approx_percentile_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_tdigest_state_t *s = (sql_tdigest_state_t *)state;
+    if (s->num_buffered)
+        compress(s, NULL);
+    sql_node_t *p = sql_eval(ctx, f->parameters[1]);
+    if (!s->num_centroids || !p || p->is_null)
+        return sql_double_init(ctx, 0, true);
+    return sql_double_init(ctx, tdigest_quantile(s, p->value.double_value), false);
+}
+
+static sql_ctx_aggregate_t approx_percentile_aggregate = {
+    .num_parameters = 2,
+    .state_size = sizeof(sql_tdigest_state_t),
+    .init = approx_percentile_init,
+    .accumulate = approx_percentile_accumulate,
+    .merge = approx_percentile_merge,
+    .finalize = approx_percentile_finalize
+};
+
+sql_ctx_spec_t approx_percentile_spec = {
+    .name = "APPROX_PERCENTILE",
+    .description = "Estimates the value at a percentile (0 to 1) of numeric values (t-digest).",
+    .update = update_approx_percentile_spec,
+    .aggregate = &approx_percentile_aggregate
+};
+
+void sql_register_approx_percentile(sql_ctx_t *ctx) {
+    sql_ctx_register_spec(ctx, &approx_percentile_spec);
+
+    sql_ctx_register_callback(ctx, sql_func_approx_percentile, "approx_percentile",
+                              "Estimates the value at a percentile of numeric values.");
+}
@@ -98,20 +98,27 @@ sql_node_t *sql_double_divide(sql_ctx_t *ctx, sql_node_t *f) {
 }
 
 sql_node_t *sql_string_add(sql_ctx_t *ctx, sql_node_t *f) {
-    char *result = NULL;
+    // any NULL operand makes the result NULL, so the operands are evaluated (and their lengths
+    // summed) before anything is copied
+    sql_node_t **children = (sql_node_t **)aml_pool_alloc(ctx->pool, f->num_parameters * sizeof(sql_node_t *));
+    size_t total_length = 0;
     for( size_t i = 0; i < f->num_parameters; i++ ) {
         sql_node_t *child = sql_eval(ctx, f->parameters[i]);
         if (!child || child->is_null) {
             return sql_string_init(ctx, NULL, true);
         }
-        if (!result) {
-            result = aml_pool_strdup(ctx->pool, child->value.string_value);
-        }
-        else {
-            result = aml_pool_strdupf(ctx->pool, "%s%s", result, child->value.string_value);
-        }
+        children[i] = child;
+        total_length += sql_node_string_length(child);
+    }
+    char *result = (char *)aml_pool_alloc(ctx->pool, total_length + 1);
+    char *p = result;
+    for( size_t i = 0; i < f->num_parameters; i++ ) {
+        size_t length = sql_node_string_length(children[i]);
+        memcpy(p, children[i]->value.string_value, length);
+        p += length;
     }
-    return sql_string_init(ctx, result, false);
+    *p = '\0';
+    return sql_string_view_init(ctx, result, total_length);
 }
 
 // Add an integer value to a datetime (assumes days)
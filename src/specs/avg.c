@@ -40,10 +40,55 @@ static sql_ctx_spec_update_t *update_avg_spec(sql_ctx_t *ctx, sql_ctx_spec_t *sp
     return update;
 }
 
+// AVG(expr) across rows, the sum and count are kept separately so partial states can be merged
+typedef struct {
+    double sum;
+    size_t count;
+} sql_avg_state_t;
+
+static void avg_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_avg_state_t *s = (sql_avg_state_t *)state;
+    s->sum = 0.0;
+    s->count = 0;
+}
+
+static void avg_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_avg_state_t *s = (sql_avg_state_t *)state;
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (!child || child->is_null)
+        return;
+    s->sum += child->value.double_value;
+    s->count++;
+}
+
+static void avg_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_avg_state_t *s = (sql_avg_state_t *)state;
+    const sql_avg_state_t *o = (const sql_avg_state_t *)other;
+    s->sum += o->sum;
+    s->count += o->count;
+}
+
+static sql_node_t *avg_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_avg_state_t *s = (sql_avg_state_t *)state;
+    if (s->count == 0)
+        return sql_double_init(ctx, 0, true);
+    return sql_double_init(ctx, s->sum / s->count, false);
+}
+
+static sql_ctx_aggregate_t avg_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_avg_state_t),
+    .init = avg_init,
+    .accumulate = avg_accumulate,
+    .merge = avg_merge,
+    .finalize = avg_finalize
+};
+
 sql_ctx_spec_t avg_spec = {
     .name = "AVG",
     .description = "Calculates the average of numeric values.",
-    .update = update_avg_spec
+    .update = update_avg_spec,
+    .aggregate = &avg_aggregate
 };
 
 void sql_register_avg(sql_ctx_t *ctx) {
@@ -5,6 +5,7 @@
 #include "sql-parser-library/sql_node.h"
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/sql_strcase.h"
 
 sql_node_t *sql_int_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (f->num_parameters != 3) {
@@ -42,7 +43,10 @@ sql_node_t *sql_string_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (!value || !left || !right || value->is_null || left->is_null || right->is_null) {
         return sql_bool_init(ctx, false, true);
     }
-    return sql_bool_init(ctx, strcasecmp(left->value.string_value, value->value.string_value) <= 0 && strcasecmp(value->value.string_value, right->value.string_value) <= 0, false);
+    const char *s = value->value.string_value;
+    size_t length = sql_node_string_length(value);
+    return sql_bool_init(ctx, sql_strcase_compare(left->value.string_value, sql_node_string_length(left), s, length) <= 0 &&
+                              sql_strcase_compare(s, length, right->value.string_value, sql_node_string_length(right)) <= 0, false);
 }
 
 sql_node_t *sql_datetime_between(sql_ctx_t *ctx, sql_node_t *f) {
@@ -64,7 +68,8 @@ sql_node_t *sql_int_not_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (!result) {
         return sql_bool_init(ctx, false, true);
     }
-    result->value.bool_value = !result->value.bool_value;
+    if (!result->is_null)
+        result->value.bool_value = !result->value.bool_value;
     return result;
 }
 
@@ -73,7 +78,8 @@ sql_node_t *sql_double_not_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (!result) {
         return sql_bool_init(ctx, false, true);
     }
-    result->value.bool_value = !result->value.bool_value;
+    if (!result->is_null)
+        result->value.bool_value = !result->value.bool_value;
     return result;
 }
 
@@ -82,7 +88,8 @@ sql_node_t *sql_string_not_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (!result) {
         return sql_bool_init(ctx, false, true);
     }
-    result->value.bool_value = !result->value.bool_value;
+    if (!result->is_null)
+        result->value.bool_value = !result->value.bool_value;
     return result;
 }
 
@@ -91,7 +98,8 @@ sql_node_t *sql_datetime_not_between(sql_ctx_t *ctx, sql_node_t *f) {
     if (!result) {
         return sql_bool_init(ctx, false, true);
     }
-    result->value.bool_value = !result->value.bool_value;
+    if (!result->is_null)
+        result->value.bool_value = !result->value.bool_value;
     return result;
 }
 
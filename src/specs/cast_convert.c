@@ -4,8 +4,17 @@
 
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/number_utils.h"
+#include <ctype.h>
 #include <strings.h>
 
+// true if only spaces follow the number parsed up to end, so '3x' isn't read as 3
+static bool only_spaces(const char *end) {
+    while (isspace((unsigned char)*end))
+        end++;
+    return *end == '\0';
+}
+
 
 sql_node_t *sql_convert_bool_to_int(sql_ctx_t *ctx, sql_node_t *f) {
     sql_node_t *child = sql_eval(ctx, f->parameters[0]);
@@ -28,7 +37,7 @@ sql_node_t *sql_convert_bool_to_string(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null) {
         return sql_string_init(ctx, NULL, true);
     }
-    return sql_string_init(ctx, child->value.bool_value ? "true" : "false", false);
+    return child->value.bool_value ? sql_string_view_init(ctx, "true", 4) : sql_string_view_init(ctx, "false", 5);
 }
 
 sql_node_t *sql_convert_int_to_bool(sql_ctx_t *ctx, sql_node_t *f) {
@@ -65,8 +74,9 @@ sql_node_t *sql_convert_int_to_string(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null) {
         return sql_string_init(ctx, NULL, true);
     }
-    char *result = (char *)aml_pool_strdupf(ctx->pool, "%d", child->value.int_value);
-    return sql_string_init(ctx, result, false);
+    char buffer[SQL_INT_BUFFER_SIZE];
+    size_t length = sql_format_int(buffer, child->value.int_value);
+    return sql_string_init_length(ctx, buffer, length, false);
 }
 
 sql_node_t *sql_convert_double_to_bool(sql_ctx_t *ctx, sql_node_t *f) {
@@ -104,8 +114,9 @@ sql_node_t *sql_convert_double_to_string(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null) {
         return sql_string_init(ctx, NULL, true);
     }
-    char *result = (char *)aml_pool_strdupf(ctx->pool, "%f", child->value.double_value);
-    return sql_string_init(ctx, result, false);
+    char buffer[SQL_DOUBLE_BUFFER_SIZE];
+    size_t length = sql_format_double(buffer, child->value.double_value);
+    return sql_string_init_length(ctx, buffer, length, false);
 }
 
 sql_node_t *sql_convert_string_to_bool(sql_ctx_t *ctx, sql_node_t *f) {
@@ -129,7 +140,8 @@ sql_node_t *sql_convert_string_to_int(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_int_init(ctx, 0, true);
     }
     int result;
-    if (sscanf(child->value.string_value, "%d", &result) != 1) {
+    const char *end;
+    if (!sql_parse_int(child->value.string_value, &result, &end) || !only_spaces(end)) {
         return sql_int_init(ctx, 0, true);
     }
     return sql_int_init(ctx, result, false);
@@ -141,7 +153,8 @@ sql_node_t *sql_convert_string_to_double(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_double_init(ctx, 0.0f, true);
     }
     double result;
-    if (sscanf(child->value.string_value, "%lf", &result) != 1) {
+    const char *end;
+    if (!sql_parse_double(child->value.string_value, &result, &end) || !only_spaces(end)) {
         return sql_double_init(ctx, 0.0f, true);
     }
     return sql_double_init(ctx, result, false);
@@ -188,7 +201,7 @@ sql_node_t *sql_convert_datetime_to_string(sql_ctx_t *ctx, sql_node_t *f) {
         fprintf(stderr, "Failed to format datetime\n");
         return sql_string_init(ctx, NULL, true);
     }
-    return sql_string_init(ctx, result, false);
+    return sql_string_view_init(ctx, result, strlen(result));
 }
 
 sql_node_t *sql_convert_value(sql_ctx_t *ctx, sql_node_t *value, sql_data_type_t target_type) {
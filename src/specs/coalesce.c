@@ -19,7 +19,7 @@ static sql_node_t *sql_string_coalesce(sql_ctx_t *ctx, sql_node_t *f) {
     for (size_t i = 0; i < f->num_parameters; i++) {
         sql_node_t *child = sql_eval(ctx, f->parameters[i]);
         if (child && !child->is_null) {
-            return sql_string_init(ctx, child->value.string_value, false);
+            return sql_string_view_init(ctx, child->value.string_value, sql_node_string_length(child));
         }
     }
     return sql_string_init(ctx, NULL, true); // Return NULL if all values are NULL
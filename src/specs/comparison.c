@@ -4,7 +4,7 @@
 
 #include "sql-parser-library/sql_node.h"
 #include "sql-parser-library/sql_ctx.h"
-#include <strings.h>
+#include "sql-parser-library/sql_strcase.h"
 
 sql_node_t *sql_bool_less(sql_ctx_t *ctx, sql_node_t *f) {
     if (f->num_parameters != 2) {
@@ -150,6 +150,17 @@ sql_node_t *sql_double_equal(sql_ctx_t *ctx, sql_node_t *f) {
     return sql_bool_init(ctx, left->value.double_value == right->value.double_value, false);
 }
 
+// strings are compared ignoring case
+static bool string_equal(sql_node_t *left, sql_node_t *right) {
+    return sql_strcase_equal(left->value.string_value, sql_node_string_length(left),
+                             right->value.string_value, sql_node_string_length(right));
+}
+
+static int string_compare(sql_node_t *left, sql_node_t *right) {
+    return sql_strcase_compare(left->value.string_value, sql_node_string_length(left),
+                               right->value.string_value, sql_node_string_length(right));
+}
+
 sql_node_t *sql_string_less(sql_ctx_t *ctx, sql_node_t *f) {
     if (f->num_parameters != 2) {
         return sql_bool_init(ctx, false, true);
@@ -159,7 +170,7 @@ sql_node_t *sql_string_less(sql_ctx_t *ctx, sql_node_t *f) {
     if (!left || !right || left->is_null || right->is_null) {
         return sql_bool_init(ctx, false, true);
     }
-    int result = strcasecmp(left->value.string_value, right->value.string_value);
+    int result = string_compare(left, right);
     return sql_bool_init(ctx, result < 0, false);
 }
 
@@ -172,7 +183,7 @@ sql_node_t *sql_string_less_or_equal(sql_ctx_t *ctx, sql_node_t *f) {
     if (!left || !right || left->is_null || right->is_null) {
         return sql_bool_init(ctx, false, true);
     }
-    int result = strcasecmp(left->value.string_value, right->value.string_value);
+    int result = string_compare(left, right);
     return sql_bool_init(ctx, result <= 0, false);
 }
 
@@ -185,8 +196,7 @@ sql_node_t *sql_string_not_equal(sql_ctx_t *ctx, sql_node_t *f) {
     if (!left || !right || left->is_null || right->is_null) {
         return sql_bool_init(ctx, false, true);
     }
-    int result = strcasecmp(left->value.string_value, right->value.string_value);
-    return sql_bool_init(ctx, result != 0, false);
+    return sql_bool_init(ctx, !string_equal(left, right), false);
 }
 
 sql_node_t *sql_string_equal(sql_ctx_t *ctx, sql_node_t *f) {
@@ -198,8 +208,7 @@ sql_node_t *sql_string_equal(sql_ctx_t *ctx, sql_node_t *f) {
     if (!left || !right || left->is_null || right->is_null) {
         return sql_bool_init(ctx, false, true);
     }
-    int result = strcasecmp(left->value.string_value, right->value.string_value);
-    return sql_bool_init(ctx, result == 0, false);
+    return sql_bool_init(ctx, string_equal(left, right), false);
 }
 
 sql_node_t *sql_datetime_less(sql_ctx_t *ctx, sql_node_t *f) {
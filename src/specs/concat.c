@@ -10,32 +10,37 @@
 static sql_node_t *sql_string_concat(sql_ctx_t *ctx, sql_node_t *f) {
     aml_pool_t *pool = ctx->pool;
 
-    // Calculate the total length of the concatenated string
+    // Evaluate each parameter once, summing the lengths of the strings
+    sql_node_t **children = (sql_node_t **)aml_pool_alloc(pool, f->num_parameters * sizeof(sql_node_t *));
     size_t total_length = 0;
     for (size_t i = 0; i < f->num_parameters; i++) {
         sql_node_t *child = sql_eval(ctx, f->parameters[i]);
-        if (child && !child->is_null && child->data_type == SQL_TYPE_STRING) {
-            total_length += strlen(child->value.string_value);
+        if (!child || child->is_null || child->data_type != SQL_TYPE_STRING) {
+            child = NULL;
         }
+        else {
+            total_length += sql_node_string_length(child);
+        }
+        children[i] = child;
     }
 
     if (total_length == 0) {
         return sql_string_init(ctx, NULL, true); // Return NULL if all parameters are NULL
     }
 
-    // Allocate memory for the concatenated string
+    // Copy the strings into a single allocation
     char *result = (char *)aml_pool_alloc(pool, total_length + 1);
-    result[0] = '\0'; // Initialize the result string
-
-    // Concatenate the strings
+    char *p = result;
     for (size_t i = 0; i < f->num_parameters; i++) {
-        sql_node_t *child = sql_eval(ctx, f->parameters[i]);
-        if (child && !child->is_null && child->data_type == SQL_TYPE_STRING) {
-            strcat(result, child->value.string_value);
+        if (children[i]) {
+            size_t length = sql_node_string_length(children[i]);
+            memcpy(p, children[i]->value.string_value, length);
+            p += length;
         }
     }
+    *p = '\0';
 
-    return sql_string_init(ctx, result, false); // Return the concatenated string
+    return sql_string_view_init(ctx, result, total_length); // Return the concatenated string
 }
 
 // Update function for CONCAT
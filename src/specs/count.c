@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include <limits.h>
+
+// COUNT(*) counts every row, a '*' parameter is never NULL
+static bool is_star(sql_node_t *param) {
+    return param->token_type == SQL_STAR;
+}
+
+// Counts the parameters which aren't NULL
+static sql_node_t *sql_func_count(sql_ctx_t *ctx, sql_node_t *f) {
+    int result = 0;
+    for (size_t i = 0; i < f->num_parameters; i++) {
+        if (is_star(f->parameters[i])) {
+            result++;
+            continue;
+        }
+        sql_node_t *child = sql_eval(ctx, f->parameters[i]);
+        if (child && !child->is_null) {
+            result++;
+        }
+    }
+    return sql_int_init(ctx, result, false);
+}
+
+static sql_ctx_spec_update_t *update_count_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
+    if (f->num_parameters < 1) {
+        sql_ctx_error(ctx, "COUNT requires at least one parameter.");
+        return NULL;
+    }
+
+    sql_ctx_spec_update_t *update = (sql_ctx_spec_update_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_ctx_spec_update_t));
+    update->num_parameters = f->num_parameters;
+    update->parameters = f->parameters;
+    update->expected_data_types = (sql_data_type_t *)aml_pool_alloc(ctx->pool, f->num_parameters * sizeof(sql_data_type_t));
+
+    // any type can be counted, leave the parameters as they are
+    for (size_t i = 0; i < f->num_parameters; i++) {
+        update->expected_data_types[i] = SQL_TYPE_UNKNOWN;
+    }
+
+    update->implementation = sql_func_count;
+    update->return_type = SQL_TYPE_INT;
+    return update;
+}
+
+// COUNT(*) / COUNT(expr) across rows
+typedef struct {
+    size_t count;
+} sql_count_state_t;
+
+static void count_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    ((sql_count_state_t *)state)->count = 0;
+}
+
+static void count_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_count_state_t *s = (sql_count_state_t *)state;
+    if (is_star(f->parameters[0])) {
+        s->count++;
+        return;
+    }
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (child && !child->is_null)
+        s->count++;
+}
+
+static void count_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    ((sql_count_state_t *)state)->count += ((const sql_count_state_t *)other)->count;
+}
+
+// COUNT is an INT, more than INT_MAX rows (possible once parallel states are merged) report INT_MAX
+static sql_node_t *count_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    size_t count = ((sql_count_state_t *)state)->count;
+    return sql_int_init(ctx, count > INT_MAX ? INT_MAX : (int)count, false);
+}
+
+static sql_ctx_aggregate_t count_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_count_state_t),
+    .init = count_init,
+    .accumulate = count_accumulate,
+    .merge = count_merge,
+    .finalize = count_finalize
+};
+
+sql_ctx_spec_t count_spec = {
+    .name = "COUNT",
+    .description = "Counts the values which are not NULL (COUNT(*) counts rows).",
+    .update = update_count_spec,
+    .aggregate = &count_aggregate
+};
+
+void sql_register_count(sql_ctx_t *ctx) {
+    sql_ctx_register_spec(ctx, &count_spec);
+
+    sql_ctx_register_callback(ctx, sql_func_count, "count", "Counts the values which are not NULL.");
+}
@@ -25,7 +25,8 @@ static sql_node_t *sql_trunc_minute(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_sec = 0; // Reset seconds
 
     time_t truncated = timegm(dt);
@@ -39,7 +40,8 @@ static sql_node_t *sql_trunc_hour(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_min = 0; // Reset minutes
     dt->tm_sec = 0; // Reset seconds
 
@@ -54,7 +56,8 @@ static sql_node_t *sql_trunc_day(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_hour = 0; // Reset hours
     dt->tm_min = 0;  // Reset minutes
     dt->tm_sec = 0;  // Reset seconds
@@ -70,7 +73,8 @@ static sql_node_t *sql_trunc_week(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_hour = 0;
     dt->tm_min = 0;
     dt->tm_sec = 0;
@@ -87,7 +91,8 @@ static sql_node_t *sql_trunc_month(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_mday = 1; // Reset to the first day of the month
     dt->tm_hour = 0;
     dt->tm_min = 0;
@@ -104,7 +109,8 @@ static sql_node_t *sql_trunc_quarter(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_mon = (dt->tm_mon / 3) * 3; // Move to the first month of the quarter
     dt->tm_mday = 1;
     dt->tm_hour = 0;
@@ -122,7 +128,8 @@ static sql_node_t *sql_trunc_year(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_mon = 0;   // Reset to January
     dt->tm_mday = 1;  // Reset to the first day of the year
     dt->tm_hour = 0;
@@ -140,7 +147,8 @@ static sql_node_t *sql_trunc_decade(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_year = (dt->tm_year / 10) * 10; // Reset to the start of the decade
     dt->tm_mon = 0;
     dt->tm_mday = 1;
@@ -159,7 +167,8 @@ static sql_node_t *sql_trunc_century(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_year = (dt->tm_year / 100) * 100; // Reset to the start of the century
     dt->tm_mon = 0;
     dt->tm_mday = 1;
@@ -178,7 +187,8 @@ static sql_node_t *sql_trunc_millennium(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_datetime_init(ctx, 0, true);
     }
 
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     dt->tm_year = (dt->tm_year / 1000) * 1000; // Reset to the start of the millennium
     dt->tm_mon = 0;
     dt->tm_mday = 1;
@@ -13,7 +13,8 @@ static sql_node_t *sql_extract_quarter(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true);
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, (dt->tm_mon / 3) + 1, false);
 }
 
@@ -23,7 +24,8 @@ static sql_node_t *sql_extract_week(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true);
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     char buffer[10];
     strftime(buffer, sizeof(buffer), "%V", dt); // ISO week number
     return sql_int_init(ctx, atoi(buffer), false);
@@ -35,10 +37,9 @@ static sql_node_t *sql_extract_doy(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true);
     }
-    struct tm *dt = gmtime(&child->value.epoch);
-    char buffer[10];
-    strftime(buffer, sizeof(buffer), "%j", dt); // Day of the year
-    return sql_int_init(ctx, atoi(buffer), false);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
+    return sql_int_init(ctx, dt->tm_yday + 1, false); // Day of the year
 }
 
 // Function to extract the day of the week (0 for Sunday)
@@ -47,7 +48,8 @@ static sql_node_t *sql_extract_dow(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true);
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_wday, false); // tm_wday: 0 for Sunday, 1 for Monday, etc.
 }
 
@@ -57,7 +59,8 @@ static sql_node_t *sql_extract_isodow(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true);
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     int isodow = dt->tm_wday == 0 ? 7 : dt->tm_wday; // Convert 0 (Sunday) to 7
     return sql_int_init(ctx, isodow, false);
 }
@@ -68,7 +71,8 @@ static sql_node_t *sql_extract_year(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_year + 1900, false); // tm_year is years since 1900
 }
 
@@ -78,7 +82,8 @@ static sql_node_t *sql_extract_month(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_mon + 1, false); // tm_mon is months since January (0-11)
 }
 
@@ -88,7 +93,8 @@ static sql_node_t *sql_extract_day(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_mday, false);
 }
 
@@ -98,7 +104,8 @@ static sql_node_t *sql_extract_hour(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_hour, false);
 }
 
@@ -108,7 +115,8 @@ static sql_node_t *sql_extract_minute(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_min, false);
 }
 
@@ -118,7 +126,8 @@ static sql_node_t *sql_extract_second(sql_ctx_t *ctx, sql_node_t *f) {
     if (!child || child->is_null || child->data_type != SQL_TYPE_DATETIME) {
         return sql_int_init(ctx, 0, true); // Return NULL if invalid input
     }
-    struct tm *dt = gmtime(&child->value.epoch);
+    struct tm tm;
+    struct tm *dt = gmtime_r(&child->value.epoch, &tm);
     return sql_int_init(ctx, dt->tm_sec, false);
 }
 
@@ -4,6 +4,7 @@
 
 #include "sql-parser-library/sql_node.h"
 #include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_strcase.h"
 
 // Determine common type for IN expressions
 static sql_data_type_t determine_common_type(sql_data_type_t type1, sql_data_type_t type2) {
@@ -84,6 +85,7 @@ static sql_node_t *sql_string_in(sql_ctx_t *ctx, sql_node_t *f) {
     if (!value || value->is_null || !list) return sql_bool_init(ctx, false, true);
 
     char *target = (char *)value->value.string_value;
+    size_t target_length = sql_node_string_length(value);
     bool found = false, has_null = false;
 
     for (size_t i = 0; i < list->num_parameters; i++) {
@@ -92,7 +94,7 @@ static sql_node_t *sql_string_in(sql_ctx_t *ctx, sql_node_t *f) {
             has_null = true;
             continue;
         }
-        if (strcasecmp(elem->value.string_value, target) == 0) {
+        if (sql_strcase_equal(elem->value.string_value, sql_node_string_length(elem), target, target_length)) {
             found = true;
             break;
         }
@@ -18,7 +18,7 @@ static sql_node_t *sql_string_length(sql_ctx_t *ctx, sql_node_t *f) {
         return sql_int_init(ctx, 0, true); // Return NULL if input is NULL or not a string
     }
 
-    int length = (int)strlen(child->value.string_value);
+    int length = (int)sql_node_string_length(child);
     return sql_int_init(ctx, length, false); // Return the length of the string
 }
 
@@ -4,7 +4,7 @@
 
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/sql_node.h"
-#include <ctype.h>
+#include "sql-parser-library/sql_strcase.h"
 
 static bool _sql_like(const char *value, const char *pattern) {
     if (!value || !pattern) {
@@ -66,7 +66,7 @@ static bool _sql_ilike(const char *value, const char *pattern) {
             if (!*v) return false;
             p++;
             v++;
-        } else if (tolower((unsigned char)*p) == tolower((unsigned char)*v)) {
+        } else if (sql_ascii_tolower(*p) == sql_ascii_tolower(*v)) {
             // Direct character match (case insensitive)
             p++;
             v++;
@@ -109,7 +109,7 @@ static bool _sql_old_ilike(const char *value, const char *pattern) {
             if (!*v) return false;
             p++;
             v++;
-        } else if (tolower((unsigned char)*p) == tolower((unsigned char)*v)) {
+        } else if (sql_ascii_tolower(*p) == sql_ascii_tolower(*v)) {
             // Direct character match (case insensitive)
             p++;
             v++;
@@ -146,10 +146,83 @@ sql_node_t *sql_not_like(sql_ctx_t *ctx, sql_node_t *f) {
     if (!result) {
         return sql_bool_init(ctx, false, true);
     }
-    result->value.bool_value = !result->value.bool_value;
+    if (!result->is_null)
+        result->value.bool_value = !result->value.bool_value;
     return result;
 }
 
+static bool is_like_wildcard(char c) {
+    return c == '%' || c == ' ';
+}
+
+// A literal pattern of the form text, text%, %text, or %text% (where text has no wildcards and
+// '%' may be any run of '%' or spaces) is a case insensitive equality, prefix, suffix, or
+// substring test.
+static bool is_simple_pattern(sql_node_t *pattern) {
+    if (!is_literal(pattern) || pattern->is_null || !pattern->value.string_value) {
+        return false;
+    }
+    const char *p = pattern->value.string_value;
+    const char *end = p + sql_node_string_length(pattern);
+    while (p < end && is_like_wildcard(*p)) {
+        p++;
+    }
+    while (end > p && is_like_wildcard(end[-1])) {
+        end--;
+    }
+    for (; p < end; p++) {
+        if (is_like_wildcard(*p) || *p == '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool simple_like(sql_node_t *value, sql_node_t *pattern) {
+    const char *s = value->value.string_value;
+    size_t length = sql_node_string_length(value);
+    const char *text = pattern->value.string_value;
+    const char *end = text + sql_node_string_length(pattern);
+    bool leading = false, trailing = false;
+    while (text < end && is_like_wildcard(*text)) {
+        text++;
+        leading = true;
+    }
+    while (end > text && is_like_wildcard(end[-1])) {
+        end--;
+        trailing = true;
+    }
+    size_t text_length = end - text;
+    if (leading && trailing) {
+        return sql_strcase_find(s, length, text, text_length) != NULL;
+    }
+    if (leading) {
+        return sql_strcase_suffix(s, length, text, text_length);
+    }
+    if (trailing) {
+        return sql_strcase_prefix(s, length, text, text_length);
+    }
+    return sql_strcase_equal(s, length, text, text_length);
+}
+
+static sql_node_t *sql_simple_like(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_node_t *value = sql_eval(ctx, f->parameters[0]);
+    sql_node_t *pattern = f->parameters[1];
+    if (!value || value->is_null) {
+        return sql_bool_init(ctx, false, true);
+    }
+    return sql_bool_init(ctx, simple_like(value, pattern), false);
+}
+
+static sql_node_t *sql_simple_not_like(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_node_t *value = sql_eval(ctx, f->parameters[0]);
+    sql_node_t *pattern = f->parameters[1];
+    if (!value || value->is_null) {
+        return sql_bool_init(ctx, false, true);
+    }
+    return sql_bool_init(ctx, !simple_like(value, pattern), false);
+}
+
 // Update function for LIKE
 static sql_ctx_spec_update_t *update_like_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
     if (f->num_parameters != 2) {
@@ -171,7 +244,7 @@ static sql_ctx_spec_update_t *update_like_spec(sql_ctx_t *ctx, sql_ctx_spec_t *s
         update->expected_data_types[i] = SQL_TYPE_STRING;
     }
 
-    update->implementation = sql_like;
+    update->implementation = is_simple_pattern(f->parameters[1]) ? sql_simple_like : sql_like;
     update->return_type = SQL_TYPE_BOOL;
 
     return update;
@@ -198,7 +271,7 @@ static sql_ctx_spec_update_t *update_not_like_spec(sql_ctx_t *ctx, sql_ctx_spec_
         update->expected_data_types[i] = SQL_TYPE_STRING;
     }
 
-    update->implementation = sql_not_like;
+    update->implementation = is_simple_pattern(f->parameters[1]) ? sql_simple_not_like : sql_not_like;
     update->return_type = SQL_TYPE_BOOL;
 
     return update;
@@ -4,7 +4,7 @@
 
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/sql_node.h"
-#include <ctype.h>
+#include "sql-parser-library/sql_strcase.h"
 
 static sql_node_t *sql_func_lower(sql_ctx_t *ctx, sql_node_t *f) {
     sql_node_t *child = sql_eval(ctx, f->parameters[0]);
@@ -13,13 +13,13 @@ static sql_node_t *sql_func_lower(sql_ctx_t *ctx, sql_node_t *f) {
     }
 
     const char *input = child->value.string_value;
-    char *result = aml_pool_strdup(ctx->pool, input);
+    size_t length = sql_node_string_length(child);
+    char *result = (char *)aml_pool_alloc(ctx->pool, length + 1);
 
-    for (char *p = result; *p; ++p) {
-        *p = tolower(*p);
-    }
+    sql_ascii_lower(result, input, length);
+    result[length] = '\0';
 
-    return sql_string_init(ctx, result, false);
+    return sql_string_view_init(ctx, result, length);
 }
 
 static sql_node_t *sql_func_upper(sql_ctx_t *ctx, sql_node_t *f) {
@@ -29,13 +29,13 @@ static sql_node_t *sql_func_upper(sql_ctx_t *ctx, sql_node_t *f) {
     }
 
     const char *input = child->value.string_value;
-    char *result = aml_pool_strdup(ctx->pool, input);
+    size_t length = sql_node_string_length(child);
+    char *result = (char *)aml_pool_alloc(ctx->pool, length + 1);
 
-    for (char *p = result; *p; ++p) {
-        *p = toupper(*p);
-    }
+    sql_ascii_upper(result, input, length);
+    result[length] = '\0';
 
-    return sql_string_init(ctx, result, false);
+    return sql_string_view_init(ctx, result, length);
 }
 
 static sql_ctx_spec_update_t *update_lower_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
@@ -3,9 +3,10 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_strcase.h"
 #include <limits.h>
 #include <float.h>
-#include <strings.h>
+#include <string.h>
 
 static sql_node_t *sql_bool_min(sql_ctx_t *ctx, sql_node_t *f) {
     // set bool to max value
@@ -39,32 +40,40 @@ static sql_node_t *sql_bool_max(sql_ctx_t *ctx, sql_node_t *f) {
 
 static sql_node_t *sql_string_min(sql_ctx_t *ctx, sql_node_t *f) {
     // set string to max value
-    const char *result = NULL;
+    sql_node_t *result = NULL;
     for( size_t i = 0; i < f->num_parameters; i++ ) {
         sql_node_t *child = sql_eval(ctx, f->parameters[i]);
         if (!child || child->is_null) {
             return sql_string_init(ctx, NULL, true);
         }
-        if (!result || strcasecmp(child->value.string_value, result) < 0) {
-            result = child->value.string_value;
+        if (!result || sql_strcase_compare(child->value.string_value, sql_node_string_length(child),
+                                           result->value.string_value, sql_node_string_length(result)) < 0) {
+            result = child;
         }
     }
-    return sql_string_init(ctx, result, false);
+    if (!result) {
+        return sql_string_init(ctx, NULL, false);
+    }
+    return sql_string_view_init(ctx, result->value.string_value, sql_node_string_length(result));
 }
 
 static sql_node_t *sql_string_max(sql_ctx_t *ctx, sql_node_t *f) {
     // set string to min value
-    const char *result = NULL;
+    sql_node_t *result = NULL;
     for( size_t i = 0; i < f->num_parameters; i++ ) {
         sql_node_t *child = sql_eval(ctx, f->parameters[i]);
         if (!child || child->is_null) {
             return sql_string_init(ctx, NULL, true);
         }
-        if (!result || strcasecmp(child->value.string_value, result) > 0) {
-            result = child->value.string_value;
+        if (!result || sql_strcase_compare(child->value.string_value, sql_node_string_length(child),
+                                           result->value.string_value, sql_node_string_length(result)) > 0) {
+            result = child;
         }
     }
-    return sql_string_init(ctx, result, false);
+    if (!result) {
+        return sql_string_init(ctx, NULL, false);
+    }
+    return sql_string_view_init(ctx, result->value.string_value, sql_node_string_length(result));
 }
 
 static sql_node_t *sql_datetime_min(sql_ctx_t *ctx, sql_node_t *f) {
@@ -157,6 +166,148 @@ static sql_node_t *sql_double_max(sql_ctx_t *ctx, sql_node_t *f) {
     return sql_double_init(ctx, result, false);
 }
 
+// MIN(expr) / MAX(expr) across rows.  A string is copied into a buffer owned by the state which
+// is only reallocated for a longer value, so the state stays bounded by the longest value kept.
+typedef struct {
+    bool has_value;
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        time_t epoch;
+        struct {
+            char *buffer;
+            size_t size;
+        } string;
+    } value;
+} sql_min_max_state_t;
+
+static void min_max_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    memset(state, 0, sizeof(sql_min_max_state_t));
+}
+
+// > 0 if v sorts after the value kept in s
+static int compare_to_state(sql_data_type_t type, sql_min_max_state_t *s, sql_node_t *v) {
+    switch (type) {
+        case SQL_TYPE_BOOL:
+            return (int)v->value.bool_value - (int)s->value.bool_value;
+        case SQL_TYPE_INT:
+            return (v->value.int_value > s->value.int_value) - (v->value.int_value < s->value.int_value);
+        case SQL_TYPE_DOUBLE:
+            return (v->value.double_value > s->value.double_value) -
+                   (v->value.double_value < s->value.double_value);
+        case SQL_TYPE_DATETIME:
+            return (v->value.epoch > s->value.epoch) - (v->value.epoch < s->value.epoch);
+        case SQL_TYPE_STRING:
+            return sql_strcase_compare(v->value.string_value, sql_node_string_length(v),
+                                       s->value.string.buffer, strlen(s->value.string.buffer));
+        default:
+            return 0;
+    }
+}
+
+// direction is -1 to keep the smallest value, 1 to keep the largest
+static void keep_value(sql_ctx_t *ctx, sql_node_t *f, sql_min_max_state_t *s, sql_node_t *v, int direction) {
+    if (!v || v->is_null)
+        return;
+    if (s->has_value && compare_to_state(f->data_type, s, v) * direction <= 0)
+        return;
+
+    switch (f->data_type) {
+        case SQL_TYPE_BOOL:
+            s->value.bool_value = v->value.bool_value;
+            break;
+        case SQL_TYPE_INT:
+            s->value.int_value = v->value.int_value;
+            break;
+        case SQL_TYPE_DOUBLE:
+            s->value.double_value = v->value.double_value;
+            break;
+        case SQL_TYPE_DATETIME:
+            s->value.epoch = v->value.epoch;
+            break;
+        case SQL_TYPE_STRING: {
+            const char *value = v->value.string_value ? v->value.string_value : "";
+            size_t length = sql_node_string_length(v) + 1;
+            if (length > s->value.string.size) {
+                s->value.string.size = length * 2;
+                s->value.string.buffer = (char *)aml_pool_alloc(sql_ctx_plan_pool(ctx), s->value.string.size);
+            }
+            memcpy(s->value.string.buffer, value, length);
+            break;
+        }
+        default:
+            return;
+    }
+    s->has_value = true;
+}
+
+// the kept value of other as a node (for merging)
+static void state_value(sql_node_t *f, const sql_min_max_state_t *other, sql_node_t *v) {
+    memset(v, 0, sizeof(*v));
+    v->data_type = f->data_type;
+    v->is_null = !other->has_value;
+    if (f->data_type == SQL_TYPE_STRING)
+        v->value.string_value = other->value.string.buffer;
+    else
+        memcpy(&v->value, &other->value, sizeof(v->value));
+}
+
+static void min_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    keep_value(ctx, f, (sql_min_max_state_t *)state, sql_eval(ctx, f->parameters[0]), -1);
+}
+
+static void max_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    keep_value(ctx, f, (sql_min_max_state_t *)state, sql_eval(ctx, f->parameters[0]), 1);
+}
+
+static void min_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_node_t v;
+    state_value(f, (const sql_min_max_state_t *)other, &v);
+    keep_value(ctx, f, (sql_min_max_state_t *)state, &v, -1);
+}
+
+static void max_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_node_t v;
+    state_value(f, (const sql_min_max_state_t *)other, &v);
+    keep_value(ctx, f, (sql_min_max_state_t *)state, &v, 1);
+}
+
+static sql_node_t *min_max_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_min_max_state_t *s = (sql_min_max_state_t *)state;
+    bool is_null = !s->has_value;
+    switch (f->data_type) {
+        case SQL_TYPE_BOOL:
+            return sql_bool_init(ctx, s->value.bool_value, is_null);
+        case SQL_TYPE_INT:
+            return sql_int_init(ctx, s->value.int_value, is_null);
+        case SQL_TYPE_DOUBLE:
+            return sql_double_init(ctx, s->value.double_value, is_null);
+        case SQL_TYPE_DATETIME:
+            return sql_datetime_init(ctx, s->value.epoch, is_null);
+        default:
+            return sql_string_init(ctx, is_null ? NULL : s->value.string.buffer, is_null);
+    }
+}
+
+static sql_ctx_aggregate_t min_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_min_max_state_t),
+    .init = min_max_init,
+    .accumulate = min_accumulate,
+    .merge = min_merge,
+    .finalize = min_max_finalize
+};
+
+static sql_ctx_aggregate_t max_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_min_max_state_t),
+    .init = min_max_init,
+    .accumulate = max_accumulate,
+    .merge = max_merge,
+    .finalize = min_max_finalize
+};
+
 static sql_ctx_spec_update_t *update_min_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
     if (f->num_parameters < 1) {
         sql_ctx_error(ctx, "MIN function requires at least one parameter.");
@@ -222,7 +373,8 @@ static sql_ctx_spec_update_t *update_min_spec(sql_ctx_t *ctx, sql_ctx_spec_t *sp
 sql_ctx_spec_t min_function_spec = {
     .name = "MIN",
     .description = "Returns the minimum value.",
-    .update = update_min_spec
+    .update = update_min_spec,
+    .aggregate = &min_aggregate
 };
 
 static sql_ctx_spec_update_t *update_max_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
@@ -290,7 +442,8 @@ static sql_ctx_spec_update_t *update_max_spec(sql_ctx_t *ctx, sql_ctx_spec_t *sp
 sql_ctx_spec_t max_function_spec = {
     .name = "MAX",
     .description = "Returns the maximum value.",
-    .update = update_max_spec
+    .update = update_max_spec,
+    .aggregate = &max_aggregate
 };
 
 void sql_register_min_max(sql_ctx_t *ctx) {
@@ -14,14 +14,15 @@ static sql_node_t *sql_func_substr_two_params(sql_ctx_t *ctx, sql_node_t *f) {
     }
 
     const char *input_str = str_node->value.string_value;
+    size_t input_length = sql_node_string_length(str_node);
     int start_pos = start_node->value.int_value - 1; // Convert to 0-based index
 
-    if (start_pos < 0 || start_pos >= (int)strlen(input_str)) {
+    if (start_pos < 0 || (size_t)start_pos >= input_length) {
         return sql_string_init(ctx, NULL, true); // Invalid indices return NULL
     }
 
-    char *result = aml_pool_strdup(ctx->pool, input_str + start_pos);
-    return sql_string_init(ctx, result, false);
+    // the rest of the input is already NUL terminated, so the result points into it
+    return sql_string_view_init(ctx, input_str + start_pos, input_length - start_pos);
 }
 
 static sql_node_t *sql_func_substr_three_params(sql_ctx_t *ctx, sql_node_t *f) {
@@ -34,17 +35,24 @@ static sql_node_t *sql_func_substr_three_params(sql_ctx_t *ctx, sql_node_t *f) {
     }
 
     const char *input_str = str_node->value.string_value;
+    size_t input_length = sql_node_string_length(str_node);
     int start_pos = start_node->value.int_value - 1; // Convert to 0-based index
     int length = length_node->value.int_value;
 
-    if (start_pos < 0 || start_pos >= (int)strlen(input_str) || length < 0) {
+    if (start_pos < 0 || (size_t)start_pos >= input_length || length < 0) {
         return sql_string_init(ctx, NULL, true); // Invalid indices return NULL
     }
 
+    // a substring which reaches the end of the input points into it, only one which ends
+    // earlier needs a copy to be NUL terminated
+    size_t rest = input_length - start_pos;
+    if ((size_t)length >= rest) {
+        return sql_string_view_init(ctx, input_str + start_pos, rest);
+    }
     char *result = aml_pool_alloc(ctx->pool, length + 1);
-    strncpy(result, input_str + start_pos, length);
-    result[length] = '\0'; // Ensure null-termination
-    return sql_string_init(ctx, result, false);
+    memcpy(result, input_str + start_pos, length);
+    result[length] = '\0';
+    return sql_string_view_init(ctx, result, length);
 }
 
 static sql_ctx_spec_update_t *update_substr_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
@@ -41,10 +41,53 @@ static sql_ctx_spec_update_t *update_sum_spec(sql_ctx_t *ctx, sql_ctx_spec_t *sp
     return update;
 }
 
+// SUM(expr) across rows, NULL when every value is NULL
+typedef struct {
+    double sum;
+    size_t count;
+} sql_sum_state_t;
+
+static void sum_init(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_sum_state_t *s = (sql_sum_state_t *)state;
+    s->sum = 0.0;
+    s->count = 0;
+}
+
+static void sum_accumulate(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_sum_state_t *s = (sql_sum_state_t *)state;
+    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
+    if (!child || child->is_null)
+        return;
+    s->sum += child->value.double_value;
+    s->count++;
+}
+
+static void sum_merge(sql_ctx_t *ctx, sql_node_t *f, void *state, const void *other) {
+    sql_sum_state_t *s = (sql_sum_state_t *)state;
+    const sql_sum_state_t *o = (const sql_sum_state_t *)other;
+    s->sum += o->sum;
+    s->count += o->count;
+}
+
+static sql_node_t *sum_finalize(sql_ctx_t *ctx, sql_node_t *f, void *state) {
+    sql_sum_state_t *s = (sql_sum_state_t *)state;
+    return sql_double_init(ctx, s->sum, s->count == 0);
+}
+
+static sql_ctx_aggregate_t sum_aggregate = {
+    .num_parameters = 1,
+    .state_size = sizeof(sql_sum_state_t),
+    .init = sum_init,
+    .accumulate = sum_accumulate,
+    .merge = sum_merge,
+    .finalize = sum_finalize
+};
+
 sql_ctx_spec_t sum_spec = {
     .name = "SUM",
     .description = "Calculates the sum of numeric values.",
-    .update = update_sum_spec
+    .update = update_sum_spec,
+    .aggregate = &sum_aggregate
 };
 
 void sql_register_sum(sql_ctx_t *ctx) {
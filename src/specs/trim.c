@@ -5,71 +5,44 @@
 #include "sql-parser-library/sql_ctx.h"
 #include <strings.h>
 
-static sql_node_t *sql_trim(sql_ctx_t *ctx, sql_node_t *f) {
+// Removes the leading and / or trailing spaces of the parameter.  Without trailing spaces the
+// result points into the input (which stays NUL terminated), so only RTRIM / TRIM of a value
+// ending in spaces copies it.
+static sql_node_t *trim_spaces(sql_ctx_t *ctx, sql_node_t *f, bool leading, bool trailing) {
     sql_node_t *child = sql_eval(ctx, f->parameters[0]);
-    if (!child || child->is_null) {
+    if (!child || child->is_null || !child->value.string_value) {
         return sql_string_init(ctx, NULL, true);
     }
-    char *value = (char *)child->value.string_value;
-    if(!value) {
-        return sql_string_init(ctx, NULL, true);
+    const char *value = child->value.string_value;
+    const char *end = value + sql_node_string_length(child);
+    if (leading) {
+        while (value < end && *value == ' ') {
+            value++;
+        }
     }
-    // Trim leading spaces
-    while (*value == ' ') {
-        value++;
+    if (!trailing || end == value || end[-1] != ' ') {
+        return sql_string_view_init(ctx, value, end - value);
     }
-    // Trim trailing spaces
-    char *end = value + strlen(value) - 1;
-    char *start_end = end;
-    while (end > value && *end == ' ') {
+    while (end > value && end[-1] == ' ') {
         end--;
     }
-    if(end < start_end) {
-        size_t index = end - value + 1;
-        value = aml_pool_strdup(ctx->pool, value);
-        value[index] = '\0';
-    }
-    return sql_string_init(ctx, value, false);
+    size_t length = end - value;
+    char *result = (char *)aml_pool_alloc(ctx->pool, length + 1);
+    memcpy(result, value, length);
+    result[length] = '\0';
+    return sql_string_view_init(ctx, result, length);
+}
+
+static sql_node_t *sql_trim(sql_ctx_t *ctx, sql_node_t *f) {
+    return trim_spaces(ctx, f, true, true);
 }
 
 static sql_node_t *sql_rtrim(sql_ctx_t *ctx, sql_node_t *f) {
-    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
-    if (!child || child->is_null) {
-        return sql_string_init(ctx, NULL, true);
-    }
-    char *value = (char *)child->value.string_value;
-    if (!value) {
-        return sql_string_init(ctx, NULL, true);
-    }
-    // Trim trailing spaces
-    char *end = value + strlen(value) - 1;
-    char *start_end = end;
-    while (end > value && *end == ' ') {
-        end--;
-    }
-    if (end < start_end) {
-        size_t index = end - value + 1;
-        value = aml_pool_strdup(ctx->pool, value);
-        value[index] = '\0';
-    }
-    return sql_string_init(ctx, value, false);
+    return trim_spaces(ctx, f, false, true);
 }
 
 static sql_node_t *sql_ltrim(sql_ctx_t *ctx, sql_node_t *f) {
-    sql_node_t *child = sql_eval(ctx, f->parameters[0]);
-    if (!child || child->is_null) {
-        return sql_string_init(ctx, NULL, true);
-    }
-    char *value = (char *)child->value.string_value;
-    if (!value) {
-        return sql_string_init(ctx, NULL, true);
-    }
-    // Trim leading spaces
-    while (*value == ' ') {
-        value++;
-    }
-    value = aml_pool_strdup(ctx->pool, value);
-    return sql_string_init(ctx, value, false);
+    return trim_spaces(ctx, f, true, false);
 }
 
 static sql_ctx_spec_update_t *update_trim_spec(sql_ctx_t *ctx, sql_ctx_spec_t *spec, sql_node_t *f) {
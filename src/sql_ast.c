@@ -4,7 +4,9 @@
 
 #include "sql-parser-library/sql_ast.h"
 #include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/number_utils.h"
 #include "a-memory-library/aml_pool.h"
+#include <string.h>
 #include <strings.h>
 
 static inline bool is_context_error(sql_ctx_t *context) {
@@ -58,12 +60,17 @@ sql_ast_node_t *create_ast_node(sql_ctx_t *context, sql_token_t *token) {
             break;
         }
         case SQL_NUMBER:
-            if (strchr(token->token, '.') != NULL) {
-                node->data_type = SQL_TYPE_DOUBLE;
-            } else {
+        {
+            // an integer too large for an int (or written with a '.' or an exponent) is a double
+            int int_value;
+            const char *end;
+            if (sql_parse_int(token->token, &int_value, &end) && !*end) {
                 node->data_type = SQL_TYPE_INT;
+            } else {
+                node->data_type = SQL_TYPE_DOUBLE;
             }
             break;
+        }
         case SQL_COMPOUND_LITERAL:
             if (!strncasecmp(token->token, "TIMESTAMP", 9)) {
                 time_t epoch = 0;
@@ -172,7 +179,8 @@ sql_ast_node_t *parse_term(sql_ctx_t *context, sql_token_t **tokens, size_t *pos
 sql_ast_node_t *parse_factor(sql_ctx_t *context, sql_token_t **tokens, size_t *pos, size_t end_pos) {
     if (*pos < end_pos && tokens[*pos]->type == SQL_OPEN_PAREN) {
         (*pos)++; // Consume '('
-        sql_ast_node_t *node = parse_arithmetic_expression(context, tokens, pos, end_pos);
+        // any expression, so (a > b) can be the right side of a comparison: (a > b) = (c > d)
+        sql_ast_node_t *node = parse_expression(context, tokens, pos, end_pos);
         if (is_context_error(context))
             return NULL;
         if (*pos < end_pos && tokens[*pos]->type == SQL_CLOSE_PAREN) {
@@ -310,6 +318,16 @@ sql_ast_node_t *parse_primary(sql_ctx_t *context, sql_token_t **tokens, size_t *
     return NULL;
 }
 
+// true if the tokens from pos to end_pos are a lone '*' (COUNT(*) or SELECT *)
+static bool is_star(sql_token_t **tokens, size_t pos, size_t end_pos) {
+    return pos + 1 == end_pos && tokens[pos]->type == SQL_OPERATOR && !strcmp(tokens[pos]->token, "*");
+}
+
+static sql_ast_node_t *create_star_node(sql_ctx_t *context) {
+    // the tokenizer binds '*' to the multiplication spec, a star is not an operator
+    return create_ast_node(context, &(sql_token_t){ .type = SQL_STAR, .token = "*" });
+}
+
 sql_ast_node_t *parse_function_call(sql_ctx_t *context, sql_token_t **tokens, size_t *pos, size_t end_pos) {
     // func_name_token is the function name we consumed outside
     sql_token_t *func_name_token = tokens[*pos - 1];
@@ -336,7 +354,14 @@ sql_ast_node_t *parse_function_call(sql_ctx_t *context, sql_token_t **tokens, si
                 return NULL;
 
             size_t arg_pos = *pos;
-            sql_ast_node_t *arg = parse_expression(context, tokens, &arg_pos, arg_end);
+            sql_ast_node_t *arg = NULL;
+            if (is_star(tokens, arg_pos, arg_end)) {
+                // COUNT(*)
+                arg = create_star_node(context);
+                arg_pos++;
+            } else {
+                arg = parse_expression(context, tokens, &arg_pos, arg_end);
+            }
             if (!arg) {
                 sql_ctx_error(context, "Error parsing function argument");
                 return NULL;
@@ -655,16 +680,13 @@ static sql_ast_node_t *parse_not_comparison_expression(sql_ctx_t *context,
  * parse_comparison: parse something like
  *   <arithmetic> [NOT] [= | <> | BETWEEN ... | IN ... | IS ... ]
  */
-sql_ast_node_t *parse_comparison(sql_ctx_t *context,
-                                 sql_token_t **tokens,
-                                 size_t *pos,
-                                 size_t end_pos)
+// Parses the comparison which follows left (if any), left is returned when there isn't one
+static sql_ast_node_t *parse_comparison_operator(sql_ctx_t *context,
+                                                 sql_ast_node_t *left,
+                                                 sql_token_t **tokens,
+                                                 size_t *pos,
+                                                 size_t end_pos)
 {
-    // First parse the left-hand side as an arithmetic expression
-    sql_ast_node_t *left = parse_arithmetic_expression(context, tokens, pos, end_pos);
-    if (is_context_error(context))
-        return NULL;
-
     // Check if there's a NOT or a comparison operator next
     if (*pos < end_pos) {
         // If the next token is NOT => might be "NOT BETWEEN", "NOT IN", etc.
@@ -692,6 +714,19 @@ sql_ast_node_t *parse_comparison(sql_ctx_t *context,
     return left;
 }
 
+sql_ast_node_t *parse_comparison(sql_ctx_t *context,
+                                 sql_token_t **tokens,
+                                 size_t *pos,
+                                 size_t end_pos)
+{
+    // First parse the left-hand side as an arithmetic expression
+    sql_ast_node_t *left = parse_arithmetic_expression(context, tokens, pos, end_pos);
+    if (is_context_error(context))
+        return NULL;
+
+    return parse_comparison_operator(context, left, tokens, pos, end_pos);
+}
+
 /* ------------------------------------------------------------------
  *  The new parse_unary function:
  *    - If we see NOT => parse another unary
@@ -717,14 +752,24 @@ sql_ast_node_t *parse_unary(sql_ctx_t *context,
 
     // Check for parentheses => parse full sub-expression
     if (*pos < end_pos && tokens[*pos]->type == SQL_OPEN_PAREN) {
-        (*pos)++; // consume '('
+        size_t open_pos = (*pos)++; // consume '('
         sql_ast_node_t *expr = parse_expression(context, tokens, pos, end_pos);
+        if (is_context_error(context))
+            return NULL;
         if (*pos < end_pos && tokens[*pos]->type == SQL_CLOSE_PAREN) {
             (*pos)++; // consume ')'
         } else {
             sql_ctx_error(context, "Expected closing parenthesis in parse_unary");
+            return NULL;
         }
-        return expr;
+
+        // (a + b) * c > d - the parentheses only group an operand of the arithmetic
+        if (*pos < end_pos && tokens[*pos]->type == SQL_OPERATOR) {
+            *pos = open_pos;
+            return parse_comparison(context, tokens, pos, end_pos);
+        }
+        // (a > b) IS NOT TRUE, (a + b) > c - the sub-expression is compared
+        return parse_comparison_operator(context, expr, tokens, pos, end_pos);
     }
 
     // Otherwise, parse a comparison-level expression
@@ -821,6 +866,8 @@ sql_ast_node_t *parse_in_list(sql_ctx_t *context,
     sql_ast_node_t *list_node = (sql_ast_node_t *)aml_pool_alloc(context->pool, sizeof(sql_ast_node_t));
     list_node->type = SQL_LIST;
     list_node->value = NULL;
+    list_node->data_type = SQL_TYPE_UNKNOWN;
+    list_node->spec = NULL;
     list_node->left = NULL;
     list_node->right = NULL;
     list_node->next = NULL;
@@ -880,9 +927,144 @@ sql_ast_node_t *parse_in_list(sql_ctx_t *context,
 }
 
 /* ------------------------------------------------------------------
- *  AST build for SELECT / FROM / WHERE at the top level
+ *  AST build for SELECT / FROM / WHERE / GROUP BY / HAVING / ORDER BY / LIMIT / OFFSET at the top level
  * ------------------------------------------------------------------ */
 
+// a keyword which starts the next clause (IS belongs to the expression)
+static bool is_clause_keyword(sql_token_t *token) {
+    return token->type == SQL_KEYWORD && strcasecmp(token->token, "IS") != 0;
+}
+
+// the end of an expression within a clause, keywords and commas inside parentheses
+// (EXTRACT(YEAR FROM x)) are skipped
+static size_t find_clause_end(sql_token_t **tokens, size_t pos, size_t token_count, bool stop_at_comma) {
+    int paren_level = 0;
+    for (; pos < token_count; pos++) {
+        sql_token_t *token = tokens[pos];
+        if (token->type == SQL_OPEN_PAREN || token->type == SQL_OPEN_BRACKET) {
+            paren_level++;
+        } else if (token->type == SQL_CLOSE_PAREN || token->type == SQL_CLOSE_BRACKET) {
+            if (paren_level > 0)
+                paren_level--;
+        } else if (paren_level == 0 &&
+                   ((stop_at_comma && token->type == SQL_COMMA) || is_clause_keyword(token))) {
+            break;
+        }
+    }
+    return pos;
+}
+
+static bool is_word(sql_token_t *token, const char *word) {
+    return (token->type == SQL_IDENTIFIER || token->type == SQL_KEYWORD) && strcasecmp(token->token, word) == 0;
+}
+
+static bool is_alias(sql_token_t *token) {
+    return token->type == SQL_IDENTIFIER || token->type == SQL_LITERAL;
+}
+
+// Parses comma separated expressions up to the next clause as children of parent (SELECT, GROUP BY).
+// With allow_alias an expression may be followed by [AS] alias, the item is then a node named AS
+// with the expression as left and the alias (a literal) as right.
+static bool parse_expression_list(sql_ctx_t *context, sql_token_t **tokens, size_t *pos,
+                                  size_t token_count, sql_ast_node_t *parent, bool allow_alias) {
+    while (*pos < token_count && !is_clause_keyword(tokens[*pos])) {
+        if (tokens[*pos]->type == SQL_COMMA) {
+            (*pos)++; // Skip comma
+            continue;
+        }
+        size_t item_end = find_clause_end(tokens, *pos, token_count, true);
+        sql_ast_node_t *item_node = NULL;
+        if (is_star(tokens, *pos, item_end)) {
+            item_node = create_star_node(context);
+            (*pos)++;
+        } else {
+            item_node = parse_expression(context, tokens, pos, item_end);
+        }
+        if (!item_node || is_context_error(context))
+            return false;
+
+        sql_token_t *alias = NULL;
+        if (allow_alias && *pos == item_end && item_end < token_count && is_word(tokens[item_end], "AS")) {
+            if (item_end + 1 >= token_count || !is_alias(tokens[item_end + 1])) {
+                sql_ctx_error(context, "Expected an alias after AS");
+                return false;
+            }
+            alias = tokens[item_end + 1];
+            *pos = item_end + 2;
+            item_end = find_clause_end(tokens, *pos, token_count, true);
+        } else if (allow_alias && *pos + 1 == item_end && tokens[*pos]->type == SQL_IDENTIFIER) {
+            alias = tokens[(*pos)++];
+        }
+        if (alias && item_node->type == SQL_STAR) {
+            sql_ctx_error(context, "'*' can't have an alias");
+            return false;
+        }
+        if (*pos < item_end) {
+            sql_ctx_error(context, "Unexpected token in %s list: %s", parent->value, tokens[*pos]->token);
+            return false;
+        }
+        if (alias) {
+            sql_ast_node_t *as_node = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, "AS"});
+            as_node->left = item_node;
+            as_node->right = create_ast_node(context, &(sql_token_t){SQL_LITERAL, alias->token});
+            item_node = as_node;
+        }
+        add_child_node(parent, item_node);
+    }
+    return true;
+}
+
+// Parses ORDER BY items, each an expression optionally followed by ASC / DESC and NULLS FIRST / LAST.
+// An item is a node named ASC or DESC with the expression as left and NULLS FIRST / NULLS LAST (when
+// given) as right.
+static bool parse_order_by_list(sql_ctx_t *context, sql_token_t **tokens, size_t *pos,
+                                size_t token_count, sql_ast_node_t *parent) {
+    while (*pos < token_count && !is_clause_keyword(tokens[*pos])) {
+        if (tokens[*pos]->type == SQL_COMMA) {
+            (*pos)++; // Skip comma
+            continue;
+        }
+        size_t item_end = find_clause_end(tokens, *pos, token_count, true);
+        size_t expression_end = item_end;
+        const char *nulls = NULL;
+        const char *direction = "ASC";
+        if (expression_end >= *pos + 2 && is_word(tokens[expression_end - 2], "NULLS")) {
+            if (is_word(tokens[expression_end - 1], "FIRST"))
+                nulls = "NULLS FIRST";
+            else if (is_word(tokens[expression_end - 1], "LAST"))
+                nulls = "NULLS LAST";
+            else {
+                sql_ctx_error(context, "Expected FIRST or LAST after NULLS");
+                return false;
+            }
+            expression_end -= 2;
+        }
+        if (expression_end > *pos && (is_word(tokens[expression_end - 1], "ASC") ||
+                                      is_word(tokens[expression_end - 1], "DESC"))) {
+            direction = is_word(tokens[expression_end - 1], "DESC") ? "DESC" : "ASC";
+            expression_end--;
+        }
+        if (expression_end == *pos) {
+            sql_ctx_error(context, "Missing expression in ORDER BY");
+            return false;
+        }
+
+        sql_ast_node_t *item_node = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, (char *)direction});
+        item_node->left = parse_expression(context, tokens, pos, expression_end);
+        if (!item_node->left || is_context_error(context))
+            return false;
+        if (*pos < expression_end) {
+            sql_ctx_error(context, "Unexpected token in ORDER BY list: %s", tokens[*pos]->token);
+            return false;
+        }
+        *pos = item_end;
+        if (nulls)
+            item_node->right = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, (char *)nulls});
+        add_child_node(parent, item_node);
+    }
+    return true;
+}
+
 sql_ast_node_t *build_ast(sql_ctx_t *context, sql_token_t **tokens, size_t token_count) {
     sql_ast_node_t *root = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, "ROOT"});
     if (is_context_error(context))
@@ -897,17 +1079,9 @@ sql_ast_node_t *build_ast(sql_ctx_t *context, sql_token_t **tokens, size_t token
                 sql_ast_node_t *select_node = create_ast_node(context, token);
                 if (is_context_error(context))
                     return NULL;
-                // Parse columns until next keyword
-                while (pos < token_count && tokens[pos]->type != SQL_KEYWORD) {
-                    if (tokens[pos]->type == SQL_COMMA) {
-                        pos++; // Skip comma
-                        continue;
-                    }
-                    sql_ast_node_t *column_node = create_ast_node(context, tokens[pos++]);
-                    if (is_context_error(context))
-                        return NULL;
-                    add_child_node(select_node, column_node);
-                }
+                // Parse each item as an expression up to the next comma or clause
+                if (!parse_expression_list(context, tokens, &pos, token_count, select_node, true))
+                    return NULL;
                 add_child_node(root, select_node);
             }
             else if (strcasecmp(token->token, "FROM") == 0) {
@@ -934,11 +1108,65 @@ sql_ast_node_t *build_ast(sql_ctx_t *context, sql_token_t **tokens, size_t token
                 if (is_context_error(context))
                     return NULL;
 
-                where_node->left = parse_expression(context, tokens, &pos, token_count);
+                where_node->left = parse_expression(context, tokens, &pos,
+                                                    find_clause_end(tokens, pos, token_count, false));
                 if (is_context_error(context))
                     return NULL;
                 add_child_node(root, where_node);
             }
+            else if (strcasecmp(token->token, "GROUP") == 0) {
+                pos++;
+                if (pos >= token_count || strcasecmp(tokens[pos]->token, "BY") != 0) {
+                    sql_ctx_error(context, "Expected BY after GROUP");
+                    return NULL;
+                }
+                pos++;
+                sql_ast_node_t *group_node = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, "GROUP BY"});
+                if (is_context_error(context))
+                    return NULL;
+                if (!parse_expression_list(context, tokens, &pos, token_count, group_node, false))
+                    return NULL;
+                add_child_node(root, group_node);
+            }
+            else if (strcasecmp(token->token, "HAVING") == 0) {
+                pos++;
+                sql_ast_node_t *having_node = create_ast_node(context, token);
+                if (is_context_error(context))
+                    return NULL;
+
+                having_node->left = parse_expression(context, tokens, &pos,
+                                                     find_clause_end(tokens, pos, token_count, false));
+                if (is_context_error(context))
+                    return NULL;
+                add_child_node(root, having_node);
+            }
+            else if (strcasecmp(token->token, "ORDER") == 0) {
+                pos++;
+                if (pos >= token_count || strcasecmp(tokens[pos]->token, "BY") != 0) {
+                    sql_ctx_error(context, "Expected BY after ORDER");
+                    return NULL;
+                }
+                pos++;
+                sql_ast_node_t *order_node = create_ast_node(context, &(sql_token_t){SQL_KEYWORD, "ORDER BY"});
+                if (is_context_error(context))
+                    return NULL;
+                if (!parse_order_by_list(context, tokens, &pos, token_count, order_node))
+                    return NULL;
+                add_child_node(root, order_node);
+            }
+            else if (strcasecmp(token->token, "LIMIT") == 0 || strcasecmp(token->token, "OFFSET") == 0) {
+                pos++;
+                sql_ast_node_t *limit_node = create_ast_node(context, token);
+                if (is_context_error(context))
+                    return NULL;
+                if (pos >= token_count || tokens[pos]->type != SQL_NUMBER ||
+                    strspn(tokens[pos]->token, "0123456789") != strlen(tokens[pos]->token)) {
+                    sql_ctx_error(context, "%s expects a non-negative integer", limit_node->value);
+                    return NULL;
+                }
+                limit_node->left = create_ast_node(context, tokens[pos++]);
+                add_child_node(root, limit_node);
+            }
             else {
                 // Other keywords?
                 pos++;
@@ -7,6 +7,7 @@
 #include "sql-parser-library/sql_ctx.h"
 #include "a-memory-library/aml_pool.h"
 #include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/number_utils.h"
 #include "sql-parser-library/sql_tokenizer.h" // For token type names
 
 #include <string.h>
@@ -69,17 +70,18 @@ static sql_data_type_t infer_list_type(sql_ast_node_t *list) {
 static void convert_value(aml_pool_t *pool, sql_ast_node_t *ast, sql_node_t *node) {
     switch (ast->data_type) {
         case SQL_TYPE_INT:
-            if(sscanf(ast->value, "%d", &node->value.int_value) != 1) {
+            if(!sql_parse_int(ast->value, &node->value.int_value, NULL)) {
                 node->is_null = true;
             }
             break;
         case SQL_TYPE_DOUBLE:
-            if(sscanf(ast->value, "%lf", &node->value.double_value) != 1) {
+            if(!sql_parse_double(ast->value, &node->value.double_value, NULL)) {
                 node->is_null = true;
             }
             break;
         case SQL_TYPE_STRING:
             node->value.string_value = aml_pool_strdup(pool, ast->value);
+            node->value.string_length = strlen(ast->value);
             break;
         case SQL_TYPE_BOOL:
             if (strcasecmp(ast->value, "true") == 0 || strcmp(ast->value, "1") == 0) {
@@ -170,6 +172,7 @@ sql_node_t *convert_ast_to_node(sql_ctx_t *context, sql_ast_node_t *ast) {
             if(strcasecmp(context->columns[i].name, ast->value) == 0) {
                 node->data_type = context->columns[i].type;
                 node->func = context->columns[i].func;
+                node->value.custom = context->columns + i;
                 break;
             }
         }
@@ -72,6 +72,39 @@ void *sql_ctx_get_callback(sql_ctx_t *ctx, const char *name) {
     return get_named_pointer_pointer(&ctx->callbacks, name);
 }
 
+void sql_ctx_set_row(sql_ctx_t *ctx, void *row) {
+    ctx->row = row;
+    ctx->row_id++;
+}
+
+void sql_ctx_begin_scratch(sql_ctx_t *ctx) {
+    if (ctx->plan_pool)
+        return;
+    ctx->plan_pool = ctx->pool;
+    ctx->pool = aml_pool_init(16384);
+}
+
+void sql_ctx_reset_scratch(sql_ctx_t *ctx) {
+    if (!ctx->plan_pool)
+        return;
+    aml_pool_clear(ctx->pool);
+    // the memos hold results from the scratch pool, they must not be reused for the current row
+    ctx->row_id++;
+}
+
+void sql_ctx_end_scratch(sql_ctx_t *ctx) {
+    if (!ctx->plan_pool)
+        return;
+    aml_pool_destroy(ctx->pool);
+    ctx->pool = ctx->plan_pool;
+    ctx->plan_pool = NULL;
+    ctx->row_id++;
+}
+
+aml_pool_t *sql_ctx_plan_pool(sql_ctx_t *ctx) {
+    return ctx->plan_pool ? ctx->plan_pool : ctx->pool;
+}
+
 void sql_ctx_reserve_keyword(sql_ctx_t *ctx, const char *keyword) {
     if (!ctx || !keyword) return;
 
@@ -107,10 +140,11 @@ void sql_reserve_default_keywords(sql_ctx_t *ctx) {
 void sql_ctx_error(sql_ctx_t *ctx, const char *format, ...) {
     if (!ctx || !format) return;
 
-    sql_ctx_message_t *message = (sql_ctx_message_t *)aml_pool_alloc(ctx->pool, sizeof(sql_ctx_message_t));
+    aml_pool_t *pool = sql_ctx_plan_pool(ctx);
+    sql_ctx_message_t *message = (sql_ctx_message_t *)aml_pool_alloc(pool, sizeof(sql_ctx_message_t));
     va_list args;
     va_start(args, format);
-    message->message = aml_pool_strdupvf(ctx->pool, format, args);
+    message->message = aml_pool_strdupvf(pool, format, args);
     va_end(args);
 
     // Append to the errors list
@@ -121,10 +155,11 @@ void sql_ctx_error(sql_ctx_t *ctx, const char *format, ...) {
 void sql_ctx_warning(sql_ctx_t *ctx, const char *format, ...) {
     if (!ctx || !format) return;
 
-    sql_ctx_message_t *message = (sql_ctx_message_t *)aml_pool_alloc(ctx->pool, sizeof(sql_ctx_message_t));
+    aml_pool_t *pool = sql_ctx_plan_pool(ctx);
+    sql_ctx_message_t *message = (sql_ctx_message_t *)aml_pool_alloc(pool, sizeof(sql_ctx_message_t));
     va_list args;
     va_start(args, format);
-    message->message = aml_pool_strdupvf(ctx->pool, format, args);
+    message->message = aml_pool_strdupvf(pool, format, args);
     va_end(args);
 
     // Append to the warnings list
@@ -0,0 +1,350 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/date_utils.h"
+#include "a-memory-library/aml_buffer.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+    Rewrites calendar predicates on a DATETIME column into half-open epoch ranges
+    on the column itself.
+
+        EXTRACT(YEAR FROM created) = 2024          => '2024-01-01' <= created AND created < '2025-01-01'
+        YEAR(created) = 2024 AND MONTH(created) = 5 => '2024-05-01' <= created AND created < '2024-06-01'
+        DATE_TRUNC('day', created) <= '2024-05-01' => created < '2024-05-02'
+
+    Every DATE_TRUNC unit and EXTRACT(YEAR) are monotonic, so =, <, <= (and the
+    flipped >, >=) and BETWEEN all map onto a single range.  MONTH, DAY and HOUR
+    are not monotonic on their own and are only rewritten as equalities chained
+    under a YEAR equality on the same column inside a conjunction.  NULL columns
+    still produce NULL because the column remains an operand of every comparison.
+*/
+
+// [lo, hi) - empty when lo == hi
+typedef struct {
+    time_t lo;
+    time_t hi;
+} date_range_t;
+
+typedef struct {
+    const char *name;
+    // added to a truncated value, lands inside the following unit (and never beyond it)
+    time_t step;
+} date_trunc_unit_t;
+
+static const date_trunc_unit_t trunc_units[] = {
+    {"trunc_second", 1},
+    {"trunc_minute", 60},
+    {"trunc_hour", 3600},
+    {"trunc_day", 86400},
+    {"trunc_week", 7 * 86400},
+    {"trunc_month", 45 * 86400},
+    {"trunc_quarter", 135 * 86400},
+    {"trunc_year", (time_t)548 * 86400},
+    {"trunc_decade", (time_t)5479 * 86400},
+    {"trunc_century", (time_t)54787 * 86400},
+    {"trunc_millennium", (time_t)547870 * 86400}
+};
+
+static const char *calendar_fields[] = {
+    "extract_year", "extract_month", "extract_day", "extract_hour"
+};
+
+#define NUM_TRUNC_UNITS (sizeof(trunc_units) / sizeof(trunc_units[0]))
+#define NUM_CALENDAR_FIELDS (sizeof(calendar_fields) / sizeof(calendar_fields[0]))
+
+// Returns the column a date function is applied to, if it is applied directly to a DATETIME column
+static sql_node_t *date_function_column(sql_ctx_t *ctx, sql_node_t *f, const char **name) {
+    if (f->token_type != SQL_FUNCTION || !f->func || f->num_parameters != 1)
+        return NULL;
+
+    sql_node_t *column = f->parameters[0];
+    if (column->token_type != SQL_IDENTIFIER || column->data_type != SQL_TYPE_DATETIME)
+        return NULL;
+
+    *name = sql_ctx_get_callback_name(ctx, f->func);
+    return *name ? column : NULL;
+}
+
+static const date_trunc_unit_t *get_trunc_unit(const char *name) {
+    for (size_t i = 0; i < NUM_TRUNC_UNITS; i++) {
+        if (strcmp(trunc_units[i].name, name) == 0)
+            return trunc_units + i;
+    }
+    return NULL;
+}
+
+static int get_calendar_field(const char *name) {
+    for (size_t i = 0; i < NUM_CALENDAR_FIELDS; i++) {
+        if (strcmp(calendar_fields[i], name) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+// Literal operand (folding a CONVERT or similar over literals if simplify_func_tree hasn't run yet)
+static sql_node_t *constant_operand(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!is_literal(node)) {
+        if (!node->func || !node->spec)
+            return NULL;
+        for (size_t i = 0; i < node->num_parameters; i++) {
+            if (!is_literal(node->parameters[i]))
+                return NULL;
+        }
+        node = node->func(ctx, node);
+        if (!node)
+            return NULL;
+    }
+    if (node->is_null || node->token_type == SQL_LIST)
+        return NULL;
+    return node;
+}
+
+static time_t apply_trunc(sql_ctx_t *ctx, sql_node_t *f, time_t epoch) {
+    sql_node_t tmp = *f;
+    sql_node_t *value = sql_datetime_init(ctx, epoch, false);
+    tmp.parameters = &value;
+    sql_node_t *result = f->func(ctx, &tmp);
+    return result->value.epoch;
+}
+
+// The range of column values for which DATE_TRUNC(unit, column) = epoch
+static bool trunc_range(sql_ctx_t *ctx, sql_node_t *f, const date_trunc_unit_t *unit,
+                        time_t epoch, date_range_t *range) {
+    time_t floor = apply_trunc(ctx, f, epoch);
+    time_t next = apply_trunc(ctx, f, floor + unit->step);
+    if (floor > epoch || next <= floor)
+        return false;
+
+    if (floor == epoch) {
+        range->lo = floor;
+        range->hi = next;
+    } else {
+        // epoch is not on a unit boundary, so no value truncates to it
+        range->lo = next;
+        range->hi = next;
+    }
+    return true;
+}
+
+// The range of column values for which the leading num_fields of year, month, day, hour all match
+static void calendar_range(const int *fields, size_t num_fields, date_range_t *range) {
+    struct tm tm_info = {0};
+    tm_info.tm_year = fields[0] - 1900;
+    tm_info.tm_mday = 1;
+    if (num_fields > 1)
+        tm_info.tm_mon = fields[1] - 1;
+    if (num_fields > 2)
+        tm_info.tm_mday = fields[2];
+    if (num_fields > 3)
+        tm_info.tm_hour = fields[3];
+
+    struct tm check = tm_info;
+    range->lo = timegm(&check);
+
+    // timegm normalizes out of range fields (month 13, day 31 in April, ...)
+    if (check.tm_year != tm_info.tm_year || check.tm_mon != tm_info.tm_mon ||
+        check.tm_mday != tm_info.tm_mday || check.tm_hour != tm_info.tm_hour) {
+        range->hi = range->lo;
+        return;
+    }
+
+    if (num_fields == 1)
+        tm_info.tm_year++;
+    else if (num_fields == 2)
+        tm_info.tm_mon++;
+    else if (num_fields == 3)
+        tm_info.tm_mday++;
+    else
+        tm_info.tm_hour++;
+    range->hi = timegm(&tm_info);
+}
+
+static sql_node_t *bound_init(sql_ctx_t *ctx, sql_node_t *column, const char *op, time_t epoch, bool column_first) {
+    sql_node_t *parameters[2];
+    sql_node_t *value = sql_datetime_init(ctx, epoch, false);
+    parameters[0] = column_first ? copy_nodes(ctx, column) : value;
+    parameters[1] = column_first ? value : copy_nodes(ctx, column);
+    return sql_operation_init(ctx, SQL_COMPARISON, op, parameters, 2);
+}
+
+// lo <= column AND column < hi (either bound may be omitted)
+static sql_node_t *range_init(sql_ctx_t *ctx, sql_node_t *column, const date_range_t *range,
+                              bool has_lo, bool has_hi) {
+    sql_node_t *lo = has_lo ? bound_init(ctx, column, "<=", range->lo, false) : NULL;
+    sql_node_t *hi = has_hi ? bound_init(ctx, column, "<", range->hi, true) : NULL;
+    if ((has_lo && !lo) || (has_hi && !hi))
+        return NULL;
+    if (!lo)
+        return hi;
+    if (!hi)
+        return lo;
+    sql_node_t *parameters[2] = { lo, hi };
+    return sql_operation_init(ctx, SQL_AND, "AND", parameters, 2);
+}
+
+// The range of column values for which the date function f equals value
+static bool value_range(sql_ctx_t *ctx, sql_node_t *f, const char *name, sql_node_t *value,
+                        date_range_t *range) {
+    value = constant_operand(ctx, value);
+    if (!value)
+        return false;
+
+    const date_trunc_unit_t *unit = get_trunc_unit(name);
+    if (unit) {
+        if (value->data_type != SQL_TYPE_DATETIME)
+            return false;
+        return trunc_range(ctx, f, unit, value->value.epoch, range);
+    }
+    if (strcmp(name, "extract_year") == 0) {
+        if (value->data_type != SQL_TYPE_INT)
+            return false;
+        calendar_range(&value->value.int_value, 1, range);
+        return true;
+    }
+    return false;
+}
+
+static size_t rewrite_date_comparison(sql_ctx_t *ctx, sql_node_t *node) {
+    const char *op = node->token;
+    const char *name = NULL;
+    sql_node_t *column = NULL;
+    sql_node_t *replacement = NULL;
+    date_range_t range, upper;
+
+    if (node->num_parameters == 3 && !strcasecmp(op, "BETWEEN")) {
+        sql_node_t *f = node->parameters[0];
+        column = date_function_column(ctx, f, &name);
+        if (!column ||
+            !value_range(ctx, f, name, node->parameters[1], &range) ||
+            !value_range(ctx, f, name, node->parameters[2], &upper))
+            return 0;
+        range.hi = upper.hi;
+        replacement = range_init(ctx, column, &range, true, true);
+    } else if (node->num_parameters == 2) {
+        bool function_first = true;
+        sql_node_t *f = node->parameters[0];
+        sql_node_t *value = node->parameters[1];
+        column = date_function_column(ctx, f, &name);
+        if (!column) {
+            function_first = false;
+            f = node->parameters[1];
+            value = node->parameters[0];
+            column = date_function_column(ctx, f, &name);
+        }
+        if (!column || !value_range(ctx, f, name, value, &range))
+            return 0;
+
+        if (!strcmp(op, "=") || !strcmp(op, "=="))
+            replacement = range_init(ctx, column, &range, true, true);
+        else if (!strcmp(op, "<")) {
+            // f < value => column < lo, value < f => hi <= column
+            if (function_first) {
+                range.hi = range.lo;
+                replacement = range_init(ctx, column, &range, false, true);
+            } else {
+                range.lo = range.hi;
+                replacement = range_init(ctx, column, &range, true, false);
+            }
+        } else if (!strcmp(op, "<=")) {
+            // f <= value => column < hi, value <= f => lo <= column
+            replacement = range_init(ctx, column, &range, !function_first, function_first);
+        }
+    }
+
+    if (!replacement)
+        return 0;
+    *node = *replacement;
+    return 1;
+}
+
+// Matches calendar_field(column) = int, returning the field index and the value
+static int calendar_equality(sql_ctx_t *ctx, sql_node_t *node, sql_node_t **column, int *value) {
+    if (node->token_type != SQL_COMPARISON || node->num_parameters != 2 ||
+        (strcmp(node->token, "=") && strcmp(node->token, "==")))
+        return -1;
+
+    for (size_t i = 0; i < 2; i++) {
+        const char *name = NULL;
+        *column = date_function_column(ctx, node->parameters[i], &name);
+        if (!*column)
+            continue;
+        sql_node_t *v = constant_operand(ctx, node->parameters[1 - i]);
+        if (!v || v->data_type != SQL_TYPE_INT)
+            return -1;
+        *value = v->value.int_value;
+        return get_calendar_field(name);
+    }
+    return -1;
+}
+
+static void collect_conjuncts(aml_buffer_t *bh, sql_node_t *node) {
+    if (node->token_type == SQL_AND) {
+        for (size_t i = 0; i < node->num_parameters; i++)
+            collect_conjuncts(bh, node->parameters[i]);
+    } else {
+        aml_buffer_append(bh, &node, sizeof(sql_node_t *));
+    }
+}
+
+static size_t rewrite_calendar_conjunction(sql_ctx_t *ctx, sql_node_t *node) {
+    aml_buffer_t *bh = aml_buffer_pool_init(ctx->pool, sizeof(sql_node_t *) * 8);
+    collect_conjuncts(bh, node);
+    sql_node_t **terms = (sql_node_t **)aml_buffer_data(bh);
+    size_t num_terms = aml_buffer_length(bh) / sizeof(sql_node_t *);
+
+    size_t rewrites = 0;
+    for (size_t i = 0; i < num_terms; i++) {
+        sql_node_t *column = NULL;
+        int fields[NUM_CALENDAR_FIELDS];
+        if (calendar_equality(ctx, terms[i], &column, &fields[0]) != 0)
+            continue;
+
+        // find MONTH, then DAY, then HOUR equalities on the same column
+        sql_node_t *matched[NUM_CALENDAR_FIELDS] = { terms[i] };
+        size_t num_fields = 1;
+        for (size_t j = 0; j < num_terms && num_fields < NUM_CALENDAR_FIELDS; j++) {
+            sql_node_t *other = NULL;
+            int value = 0;
+            if (calendar_equality(ctx, terms[j], &other, &value) == (int)num_fields &&
+                !strcasecmp(other->token, column->token)) {
+                matched[num_fields] = terms[j];
+                fields[num_fields++] = value;
+                j = (size_t)-1; // restart, the next field may appear earlier
+            }
+        }
+        if (num_fields == 1)
+            continue; // a lone YEAR equality is handled by rewrite_date_comparison
+
+        date_range_t range;
+        calendar_range(fields, num_fields, &range);
+        sql_node_t *replacement = range_init(ctx, column, &range, true, true);
+        if (!replacement)
+            continue;
+
+        *terms[i] = *replacement;
+        for (size_t j = 1; j < num_fields; j++)
+            *matched[j] = *sql_bool_init(ctx, true, false);
+        rewrites++;
+    }
+    return rewrites;
+}
+
+size_t rewrite_date_predicates(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node)
+        return 0;
+
+    size_t rewrites = 0;
+    if (node->token_type == SQL_AND)
+        rewrites += rewrite_calendar_conjunction(ctx, node);
+
+    for (size_t i = 0; i < node->num_parameters; i++)
+        rewrites += rewrite_date_predicates(ctx, node->parameters[i]);
+
+    if (node->token_type == SQL_COMPARISON)
+        rewrites += rewrite_date_comparison(ctx, node);
+    return rewrites;
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_dependencies.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+    Column dependencies for late materialization.
+
+        SELECT name, LOWER(city) FROM t WHERE price > 10 AND created > NOW() - INTERVAL 1 DAY
+
+    The WHERE clause reads price and created, the SELECT list reads name and
+    city.  A scan which decodes price and created first only has to decode
+    name and city for the rows which match.  A column is found by walking the
+    converted trees for identifier nodes bound to a column of ctx->columns
+    (identifiers which aren't columns have no func).  A column read by both
+    clauses is a filter column, as it is decoded before the filter runs.
+*/
+
+static void mark_column(sql_ctx_t *ctx, sql_node_t *node, bool *used) {
+    for (size_t i = 0; i < ctx->column_count; i++) {
+        if (!strcasecmp(ctx->columns[i].name, node->token)) {
+            used[i] = true;
+            return;
+        }
+    }
+}
+
+void sql_mark_columns(sql_ctx_t *ctx, sql_node_t *node, bool *used) {
+    if (!node)
+        return;
+    if (node->token_type == SQL_IDENTIFIER && node->func && node->token)
+        mark_column(ctx, node, used);
+    for (size_t i = 0; i < node->num_parameters; i++)
+        sql_mark_columns(ctx, node->parameters[i], used);
+}
+
+// the indexes of the columns used and not excluded (excluded may be NULL)
+static size_t *collect(sql_ctx_t *ctx, bool *used, bool *excluded, size_t *num_columns) {
+    size_t n = 0;
+    for (size_t i = 0; i < ctx->column_count; i++)
+        n += used[i] && !(excluded && excluded[i]);
+    size_t *columns = (size_t *)aml_pool_alloc(ctx->pool, (n ? n : 1) * sizeof(size_t));
+    n = 0;
+    for (size_t i = 0; i < ctx->column_count; i++) {
+        if (used[i] && !(excluded && excluded[i]))
+            columns[n++] = i;
+    }
+    *num_columns = n;
+    return columns;
+}
+
+sql_dependencies_t *sql_dependencies(sql_ctx_t *ctx, sql_node_t *where, sql_select_t *select) {
+    size_t count = ctx->column_count ? ctx->column_count : 1;
+    bool *filter = (bool *)aml_pool_zalloc(ctx->pool, count * sizeof(bool));
+    bool *output = (bool *)aml_pool_zalloc(ctx->pool, count * sizeof(bool));
+
+    sql_mark_columns(ctx, where, filter);
+    if (select) {
+        for (size_t i = 0; i < sql_select_num_items(select); i++)
+            sql_mark_columns(ctx, sql_select_item(select, i), output);
+        for (size_t i = 0; i < sql_select_num_group_keys(select); i++)
+            sql_mark_columns(ctx, sql_select_group_key(select, i), output);
+        // the aggregate calls are replaced by their results in the items
+        for (size_t i = 0; i < sql_select_num_aggregates(select); i++)
+            sql_mark_columns(ctx, sql_select_aggregate(select, i), output);
+        sql_mark_columns(ctx, sql_select_having(select), output);
+    }
+
+    sql_dependencies_t *deps = (sql_dependencies_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_dependencies_t));
+    deps->filter = collect(ctx, filter, NULL, &deps->num_filter);
+    deps->output = collect(ctx, output, filter, &deps->num_output);
+    return deps;
+}
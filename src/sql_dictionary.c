@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+    Predicates on dictionary encoded columns.
+
+        status = 'active' OR LOWER(status) LIKE 'pend%'
+
+    A column with a dictionary (see sql_ctx_column_t) has few distinct values,
+    so a predicate which reads no other column has few distinct results.  The
+    largest such subtrees (the whole OR above, or each side of an AND which
+    also reads another column) are evaluated once per dictionary entry and
+    once for NULL, which gives a bit per code for TRUE and one for NULL.  The
+    subtree is replaced by a DICTIONARY node which looks the row's code up in
+    those bits, so a row never fetches or compares the string.
+
+    The predicate is kept as the parameter of the DICTIONARY node (for
+    print_node, sql_dependencies, and sharing), and evaluated in its place
+    if it has become a literal (sql_partial_eval binding the column).
+*/
+
+typedef struct {
+    sql_ctx_column_t *column;
+    uint32_t size;       // of the dictionary, the code of NULL
+    uint64_t *matches;   // a bit per code, set if the predicate is TRUE
+    uint64_t *nulls;     // set if it's NULL
+} sql_dictionary_predicate_t;
+
+static bool test_bit(const uint64_t *bits, uint32_t code) {
+    return (bits[code >> 6] >> (code & 63)) & 1;
+}
+
+static sql_node_t *sql_dictionary_lookup(sql_ctx_t *ctx, sql_node_t *f) {
+    if (is_literal(f->parameters[0]))
+        return f->parameters[0];
+    sql_dictionary_predicate_t *p = (sql_dictionary_predicate_t *)f->value.custom;
+    uint32_t code = p->column->code(ctx, p->column);
+    if (code > p->size)
+        code = p->size;
+    return sql_bool_init(ctx, test_bit(p->matches, code), test_bit(p->nulls, code));
+}
+
+static sql_ctx_column_t *find_column(sql_ctx_t *ctx, const char *name) {
+    for (size_t i = 0; i < ctx->column_count; i++) {
+        if (!strcasecmp(ctx->columns[i].name, name))
+            return ctx->columns + i;
+    }
+    return NULL;
+}
+
+// false if node reads a column without a dictionary, a second column, or has an aggregate,
+// otherwise *column is the column it reads (if any)
+static bool reads_one_dictionary(sql_ctx_t *ctx, sql_node_t *node, sql_ctx_column_t **column) {
+    if (node->spec && node->spec->aggregate)
+        return false;
+    if (node->token_type == SQL_IDENTIFIER) {
+        sql_ctx_column_t *c = node->func && node->token ? find_column(ctx, node->token) : NULL;
+        if (!c || !c->dictionary || !c->code || c->type != SQL_TYPE_STRING || (*column && *column != c))
+            return false;
+        *column = c;
+        return true;
+    }
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        if (!reads_one_dictionary(ctx, node->parameters[i], column))
+            return false;
+    }
+    return true;
+}
+
+static size_t count_columns(sql_node_t *node) {
+    if (node->token_type == SQL_IDENTIFIER)
+        return 1;
+    size_t n = 0;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        n += count_columns(node->parameters[i]);
+    return n;
+}
+
+// a copy of node (without memos or DICTIONARY nodes) to evaluate per entry, with its column nodes
+// turned into literals which are appended to columns
+static sql_node_t *copy_predicate(sql_ctx_t *ctx, sql_node_t *node, sql_node_t **columns, size_t *num_columns) {
+    if (node->func == sql_dictionary_lookup)
+        return copy_predicate(ctx, node->parameters[0], columns, num_columns);
+    sql_node_t *copy = (sql_node_t *)aml_pool_alloc(ctx->pool, sizeof(sql_node_t));
+    *copy = *node;
+    copy->memo = NULL;
+    if (node->token_type == SQL_IDENTIFIER) {
+        copy->func = NULL;
+        copy->type = SQL_LITERAL;
+        copy->token_type = SQL_LITERAL;
+        columns[(*num_columns)++] = copy;
+        return copy;
+    }
+    if (node->num_parameters) {
+        copy->parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, node->num_parameters * sizeof(sql_node_t *));
+        for (size_t i = 0; i < node->num_parameters; i++)
+            copy->parameters[i] = copy_predicate(ctx, node->parameters[i], columns, num_columns);
+    }
+    return copy;
+}
+
+static void rewrite_predicate(sql_ctx_t *ctx, sql_node_t *node, sql_ctx_column_t *column) {
+    size_t num_columns = 0;
+    sql_node_t **columns = (sql_node_t **)aml_pool_alloc(ctx->pool, count_columns(node) * sizeof(sql_node_t *));
+    sql_node_t *predicate = copy_predicate(ctx, node, columns, &num_columns);
+
+    sql_dictionary_predicate_t *p = (sql_dictionary_predicate_t *)aml_pool_zalloc(ctx->pool, sizeof(*p));
+    size_t words = ((size_t)column->dictionary_size + 64) / 64;
+    p->column = column;
+    p->size = column->dictionary_size;
+    p->matches = (uint64_t *)aml_pool_zalloc(ctx->pool, words * sizeof(uint64_t));
+    p->nulls = (uint64_t *)aml_pool_zalloc(ctx->pool, words * sizeof(uint64_t));
+
+    // the results of each entry are only needed until its bits are set
+    bool scratch = !ctx->plan_pool;
+    if (scratch)
+        sql_ctx_begin_scratch(ctx);
+    for (uint32_t code = 0; code <= p->size; code++) {
+        const char *value = code < p->size && column->dictionary[code] ? column->dictionary[code] : "";
+        for (size_t i = 0; i < num_columns; i++) {
+            columns[i]->value.string_value = value;
+            columns[i]->value.string_length = strlen(value);
+            columns[i]->is_null = code == p->size;
+        }
+        sql_node_t *result = sql_eval(ctx, predicate);
+        if (!result || result->is_null)
+            p->nulls[code >> 6] |= (uint64_t)1 << (code & 63);
+        else if (result->value.bool_value)
+            p->matches[code >> 6] |= (uint64_t)1 << (code & 63);
+        if (scratch)
+            sql_ctx_reset_scratch(ctx);
+    }
+    if (scratch)
+        sql_ctx_end_scratch(ctx);
+
+    // node becomes the lookup, a copy of it its parameter
+    sql_node_t *original = (sql_node_t *)aml_pool_alloc(ctx->pool, sizeof(sql_node_t));
+    *original = *node;
+    original->memo = NULL;
+    sql_node_t **parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, sizeof(sql_node_t *));
+    parameters[0] = original;
+
+    if (!sql_ctx_get_callback_name(ctx, sql_dictionary_lookup))
+        sql_ctx_register_callback(ctx, sql_dictionary_lookup, "dictionary_lookup",
+                                  "Looks the code of a dictionary encoded column up in a predicate's results");
+
+    sql_node_memo_t *memo = node->memo;
+    memset(node, 0, sizeof(*node));
+    node->token = aml_pool_strdup(ctx->pool, "DICTIONARY");
+    node->type = SQL_FUNCTION;
+    node->token_type = SQL_FUNCTION;
+    node->data_type = SQL_TYPE_BOOL;
+    node->func = sql_dictionary_lookup;
+    node->value.custom = p;
+    node->parameters = parameters;
+    node->num_parameters = 1;
+    node->memo = memo;
+}
+
+size_t rewrite_dictionary_predicates(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node || node->func == sql_dictionary_lookup)
+        return 0;
+    sql_ctx_column_t *column = NULL;
+    if (node->data_type == SQL_TYPE_BOOL && node->token_type != SQL_IDENTIFIER && node->func &&
+        reads_one_dictionary(ctx, node, &column) && column) {
+        rewrite_predicate(ctx, node, column);
+        return 1;
+    }
+    size_t rewrites = 0;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        rewrites += rewrite_dictionary_predicates(ctx, node->parameters[i]);
+    return rewrites;
+}
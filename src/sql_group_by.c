@@ -0,0 +1,499 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_group_by.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Hash aggregation.
+
+        SELECT region, COUNT(*), SUM(amount) FROM t GROUP BY region
+
+    Groups are found through an open addressing table (linear probing) of
+    {hash, group} entries, so a lookup touches a cache line or two of entries
+    and then the group itself.  Each group is one record from the table's pool
+    holding its typed keys followed by the accumulator state of the aggregates.
+
+    String keys are interned: the first time a string (ignoring case) is seen
+    as a key it is copied into the pool, and every group with that key points
+    to the copy.  Equal strings always share a pointer, so keys compare
+    without strcasecmp, and a row's string which isn't interned yet can't
+    belong to an existing group.
+
+    Every allocation is counted, including the arrays left behind when a
+    table grows, so memory_used is what the pool holds.  A new group is
+    refused if it would take memory_used above max_memory.
+
+    Tables built from different rows (one per thread) are combined by
+    merging their groups into another table.  sql_group_by_partition splits
+    the entries of a finished table by the high bits of their hash, so the
+    merge of each partition only reads its own entries and the partitions
+    can be merged at the same time into tables which share no groups.
+*/
+
+typedef struct {
+    bool is_null;
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        time_t epoch;
+        const char *string_value;   // interned
+    } value;
+} sql_group_key_t;
+
+typedef struct {
+    uint64_t hash;
+    sql_group_key_t *group;   // the keys of the group followed by its state (NULL for an empty entry)
+} sql_group_entry_t;
+
+typedef struct {
+    uint64_t hash;
+    const char *value;        // NULL for an empty entry
+} sql_group_string_t;
+
+struct sql_group_by_s {
+    sql_select_t *select;
+    aml_pool_t *pool;
+
+    size_t num_keys;
+    sql_data_type_t *key_types;
+    size_t state_offset;
+    size_t group_size;
+
+    sql_group_entry_t *entries;
+    size_t capacity;          // a power of 2
+
+    sql_group_key_t **groups;
+    size_t num_groups;
+    size_t groups_size;
+
+    sql_group_string_t *strings;
+    size_t strings_capacity;  // a power of 2
+    size_t num_strings;
+
+    // the keys of the current row, row_strings holds the strings which aren't interned yet
+    sql_group_key_t *row_keys;
+    const char **row_strings;
+    uint64_t *row_string_hashes;
+
+    // the entries grouped by partition (set by sql_group_by_partition)
+    sql_group_entry_t *partition_entries;
+    size_t *partition_offsets;  // num_partitions + 1
+    size_t num_partitions;
+
+    size_t memory_used;
+    size_t max_memory;
+};
+
+#define SQL_GROUP_BY_INITIAL_CAPACITY 16
+
+static void *group_alloc(sql_group_by_t *g, size_t size) {
+    g->memory_used += size;
+    return aml_pool_zalloc(g->pool, size);
+}
+
+static uint64_t hash_combine(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// the murmur3 finalizer, so every bit of the keys reaches the low bits (the slot) and the high
+// bits (the partition), an INT key combined alone is just the key plus a constant
+static uint64_t hash_finish(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// FNV-1a of the lower cased string
+static uint64_t hash_string(const char *s) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (; *s; s++) {
+        hash ^= (unsigned char)tolower((unsigned char)*s);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool needs_growth(size_t count, size_t capacity) {
+    return count * 4 > capacity * 3;
+}
+
+static const char *find_string(sql_group_by_t *g, uint64_t hash, const char *s) {
+    size_t mask = g->strings_capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        sql_group_string_t *e = g->strings + i;
+        if (!e->value)
+            return NULL;
+        if (e->hash == hash && !strcasecmp(e->value, s))
+            return e->value;
+    }
+}
+
+static void insert_string_entry(sql_group_string_t *strings, size_t capacity, uint64_t hash, const char *value) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (strings[i].value)
+        i = (i + 1) & mask;
+    strings[i].hash = hash;
+    strings[i].value = value;
+}
+
+static const char *intern_string(sql_group_by_t *g, uint64_t hash, const char *s) {
+    const char *value = find_string(g, hash, s);
+    if (value)
+        return value;
+
+    if (needs_growth(g->num_strings + 1, g->strings_capacity)) {
+        size_t capacity = g->strings_capacity * 2;
+        sql_group_string_t *strings =
+            (sql_group_string_t *)group_alloc(g, capacity * sizeof(sql_group_string_t));
+        for (size_t i = 0; i < g->strings_capacity; i++) {
+            if (g->strings[i].value)
+                insert_string_entry(strings, capacity, g->strings[i].hash, g->strings[i].value);
+        }
+        g->strings = strings;
+        g->strings_capacity = capacity;
+    }
+
+    size_t length = strlen(s) + 1;
+    char *copy = (char *)group_alloc(g, length);
+    memcpy(copy, s, length);
+    insert_string_entry(g->strings, g->strings_capacity, hash, copy);
+    g->num_strings++;
+    return copy;
+}
+
+// sets the string key of the current row, returns the hash of the string
+static uint64_t set_string_key(sql_group_by_t *g, size_t key, const char *s,
+                               size_t *string_bytes, size_t *new_strings) {
+    uint64_t string_hash = hash_string(s);
+    g->row_keys[key].value.string_value = find_string(g, string_hash, s);
+    if (!g->row_keys[key].value.string_value) {
+        g->row_strings[key] = s;
+        g->row_string_hashes[key] = string_hash;
+        *string_bytes += strlen(s) + 1;
+        (*new_strings)++;
+    }
+    return string_hash;
+}
+
+static bool same_keys(sql_group_by_t *g, const sql_group_key_t *a, const sql_group_key_t *b) {
+    for (size_t i = 0; i < g->num_keys; i++) {
+        if (a[i].is_null || b[i].is_null) {
+            if (a[i].is_null != b[i].is_null)
+                return false;
+            continue;
+        }
+        switch (g->key_types[i]) {
+            case SQL_TYPE_BOOL:
+                if (a[i].value.bool_value != b[i].value.bool_value)
+                    return false;
+                break;
+            case SQL_TYPE_INT:
+                if (a[i].value.int_value != b[i].value.int_value)
+                    return false;
+                break;
+            case SQL_TYPE_DOUBLE:
+                if (a[i].value.double_value != b[i].value.double_value)
+                    return false;
+                break;
+            case SQL_TYPE_DATETIME:
+                if (a[i].value.epoch != b[i].value.epoch)
+                    return false;
+                break;
+            case SQL_TYPE_STRING:
+                if (a[i].value.string_value != b[i].value.string_value)
+                    return false;
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+static sql_group_key_t *find_group(sql_group_by_t *g, uint64_t hash) {
+    size_t mask = g->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        sql_group_entry_t *e = g->entries + i;
+        if (!e->group)
+            return NULL;
+        if (e->hash == hash && same_keys(g, e->group, g->row_keys))
+            return e->group;
+    }
+}
+
+static void insert_group_entry(sql_group_entry_t *entries, size_t capacity, uint64_t hash, sql_group_key_t *group) {
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (entries[i].group)
+        i = (i + 1) & mask;
+    entries[i].hash = hash;
+    entries[i].group = group;
+}
+
+// the memory a new group takes, including any table which has to grow for it
+static size_t group_memory(sql_group_by_t *g, size_t string_bytes, size_t new_strings) {
+    size_t size = g->group_size + string_bytes;
+    if (needs_growth(g->num_groups + 1, g->capacity))
+        size += g->capacity * 2 * sizeof(sql_group_entry_t);
+    if (g->num_groups == g->groups_size)
+        size += g->groups_size * 2 * sizeof(sql_group_key_t *);
+    for (size_t capacity = g->strings_capacity;
+         new_strings && needs_growth(g->num_strings + new_strings, capacity); capacity *= 2)
+        size += capacity * 2 * sizeof(sql_group_string_t);
+    return size;
+}
+
+static sql_group_key_t *add_group(sql_ctx_t *ctx, sql_group_by_t *g, uint64_t hash,
+                                  size_t string_bytes, size_t new_strings) {
+    if (g->max_memory && g->memory_used + group_memory(g, string_bytes, new_strings) > g->max_memory) {
+        sql_ctx_error(ctx, "GROUP BY exceeded its memory limit of %zu bytes (%zu groups)",
+                      g->max_memory, g->num_groups);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < g->num_keys; i++) {
+        if (g->row_strings[i])
+            g->row_keys[i].value.string_value = intern_string(g, g->row_string_hashes[i], g->row_strings[i]);
+    }
+
+    sql_group_key_t *group = (sql_group_key_t *)group_alloc(g, g->group_size);
+    memcpy(group, g->row_keys, g->num_keys * sizeof(sql_group_key_t));
+    sql_select_state_init(ctx, g->select, (char *)group + g->state_offset);
+
+    if (needs_growth(g->num_groups + 1, g->capacity)) {
+        size_t capacity = g->capacity * 2;
+        sql_group_entry_t *entries = (sql_group_entry_t *)group_alloc(g, capacity * sizeof(sql_group_entry_t));
+        for (size_t i = 0; i < g->capacity; i++) {
+            if (g->entries[i].group)
+                insert_group_entry(entries, capacity, g->entries[i].hash, g->entries[i].group);
+        }
+        g->entries = entries;
+        g->capacity = capacity;
+    }
+    insert_group_entry(g->entries, g->capacity, hash, group);
+
+    if (g->num_groups == g->groups_size) {
+        size_t size = g->groups_size * 2;
+        sql_group_key_t **groups = (sql_group_key_t **)group_alloc(g, size * sizeof(sql_group_key_t *));
+        memcpy(groups, g->groups, g->num_groups * sizeof(sql_group_key_t *));
+        g->groups = groups;
+        g->groups_size = size;
+    }
+    g->groups[g->num_groups++] = group;
+    return group;
+}
+
+sql_group_by_t *sql_group_by_init(sql_ctx_t *ctx, sql_select_t *select, size_t max_memory) {
+    aml_pool_t *pool = aml_pool_init(16384);
+    sql_group_by_t *g = (sql_group_by_t *)aml_pool_zalloc(pool, sizeof(sql_group_by_t));
+    g->pool = pool;
+    g->select = select;
+    g->max_memory = max_memory;
+    g->memory_used = sizeof(sql_group_by_t);
+
+    g->num_keys = sql_select_num_group_keys(select);
+    g->key_types = (sql_data_type_t *)group_alloc(g, (g->num_keys + 1) * sizeof(sql_data_type_t));
+    g->row_keys = (sql_group_key_t *)group_alloc(g, (g->num_keys + 1) * sizeof(sql_group_key_t));
+    g->row_strings = (const char **)group_alloc(g, (g->num_keys + 1) * sizeof(const char *));
+    g->row_string_hashes = (uint64_t *)group_alloc(g, (g->num_keys + 1) * sizeof(uint64_t));
+    bool has_strings = false;
+    for (size_t i = 0; i < g->num_keys; i++) {
+        g->key_types[i] = sql_select_group_key(select, i)->data_type;
+        if (g->key_types[i] == SQL_TYPE_STRING)
+            has_strings = true;
+    }
+
+    size_t alignment = _Alignof(max_align_t);
+    g->state_offset = (g->num_keys * sizeof(sql_group_key_t) + alignment - 1) & ~(alignment - 1);
+    g->group_size = g->state_offset + sql_select_state_size(select);
+
+    g->capacity = SQL_GROUP_BY_INITIAL_CAPACITY;
+    g->entries = (sql_group_entry_t *)group_alloc(g, g->capacity * sizeof(sql_group_entry_t));
+    g->groups_size = SQL_GROUP_BY_INITIAL_CAPACITY;
+    g->groups = (sql_group_key_t **)group_alloc(g, g->groups_size * sizeof(sql_group_key_t *));
+    if (has_strings) {
+        g->strings_capacity = SQL_GROUP_BY_INITIAL_CAPACITY;
+        g->strings = (sql_group_string_t *)group_alloc(g, g->strings_capacity * sizeof(sql_group_string_t));
+    }
+
+    // without GROUP BY there is a single group, even when there are no rows
+    if (!g->num_keys)
+        add_group(ctx, g, 0, 0, 0);
+    return g;
+}
+
+void sql_group_by_destroy(sql_group_by_t *group_by) {
+    aml_pool_destroy(group_by->pool);
+}
+
+bool sql_group_by_accumulate(sql_ctx_t *ctx, sql_group_by_t *g) {
+    uint64_t hash = 0;
+    size_t string_bytes = 0;
+    size_t new_strings = 0;
+    for (size_t i = 0; i < g->num_keys; i++) {
+        sql_node_t *value = sql_eval(ctx, sql_select_group_key(g->select, i));
+        sql_group_key_t *key = g->row_keys + i;
+        g->row_strings[i] = NULL;
+        key->is_null = !value || value->is_null;
+        if (key->is_null) {
+            hash = hash_combine(hash, 0);
+            continue;
+        }
+        switch (g->key_types[i]) {
+            case SQL_TYPE_BOOL:
+                key->value.bool_value = value->value.bool_value;
+                hash = hash_combine(hash, key->value.bool_value ? 2 : 1);
+                break;
+            case SQL_TYPE_INT:
+                key->value.int_value = value->value.int_value;
+                hash = hash_combine(hash, (uint64_t)(int64_t)key->value.int_value);
+                break;
+            case SQL_TYPE_DOUBLE: {
+                // -0.0 and 0.0 are the same key
+                key->value.double_value = value->value.double_value == 0.0 ? 0.0 : value->value.double_value;
+                uint64_t bits;
+                memcpy(&bits, &key->value.double_value, sizeof(bits));
+                hash = hash_combine(hash, bits);
+                break;
+            }
+            case SQL_TYPE_DATETIME:
+                key->value.epoch = value->value.epoch;
+                hash = hash_combine(hash, (uint64_t)key->value.epoch);
+                break;
+            case SQL_TYPE_STRING: {
+                const char *s = value->value.string_value ? value->value.string_value : "";
+                hash = hash_combine(hash, set_string_key(g, i, s, &string_bytes, &new_strings));
+                break;
+            }
+            default:
+                // a key of any other type puts every row in one group
+                key->is_null = true;
+                hash = hash_combine(hash, 0);
+                break;
+        }
+    }
+    hash = hash_finish(hash);
+
+    sql_group_key_t *group = new_strings ? NULL : find_group(g, hash);
+    if (!group) {
+        group = add_group(ctx, g, hash, string_bytes, new_strings);
+        if (!group)
+            return false;
+    }
+    sql_select_accumulate(ctx, g->select, (char *)group + g->state_offset);
+    return true;
+}
+
+static size_t partition_of(uint64_t hash, size_t num_partitions) {
+    // the low bits pick the slot in the table
+    return (size_t)(hash >> 40) % num_partitions;
+}
+
+void sql_group_by_partition(sql_group_by_t *g, size_t num_partitions) {
+    if (!num_partitions)
+        num_partitions = 1;
+    g->num_partitions = num_partitions;
+    g->partition_offsets = (size_t *)group_alloc(g, (num_partitions + 1) * sizeof(size_t));
+    g->partition_entries = (sql_group_entry_t *)group_alloc(g, (g->num_groups + 1) * sizeof(sql_group_entry_t));
+
+    size_t *offsets = g->partition_offsets;
+    for (size_t i = 0; i < g->capacity; i++) {
+        if (g->entries[i].group)
+            offsets[partition_of(g->entries[i].hash, num_partitions) + 1]++;
+    }
+    for (size_t p = 0; p < num_partitions; p++)
+        offsets[p + 1] += offsets[p];
+
+    // fill each partition from its start, then shift the offsets back
+    for (size_t i = 0; i < g->capacity; i++) {
+        if (g->entries[i].group)
+            g->partition_entries[offsets[partition_of(g->entries[i].hash, num_partitions)]++] = g->entries[i];
+    }
+    for (size_t p = num_partitions; p > 0; p--)
+        offsets[p] = offsets[p - 1];
+    offsets[0] = 0;
+}
+
+bool sql_group_by_merge(sql_ctx_t *ctx, sql_group_by_t *g, sql_group_by_t *src, size_t partition) {
+    sql_group_entry_t *entries = src->entries;
+    size_t start = 0, end = src->capacity;
+    if (src->num_partitions) {
+        if (partition >= src->num_partitions)
+            return true;
+        entries = src->partition_entries;
+        start = src->partition_offsets[partition];
+        end = src->partition_offsets[partition + 1];
+    }
+
+    for (size_t i = start; i < end; i++) {
+        sql_group_key_t *keys = entries[i].group;
+        if (!keys)
+            continue;
+
+        // the keys are the same values, so they hash the same, only strings have to be interned again
+        size_t string_bytes = 0;
+        size_t new_strings = 0;
+        memcpy(g->row_keys, keys, g->num_keys * sizeof(sql_group_key_t));
+        for (size_t k = 0; k < g->num_keys; k++) {
+            g->row_strings[k] = NULL;
+            if (g->key_types[k] == SQL_TYPE_STRING && !keys[k].is_null)
+                set_string_key(g, k, keys[k].value.string_value, &string_bytes, &new_strings);
+        }
+
+        sql_group_key_t *group = new_strings ? NULL : find_group(g, entries[i].hash);
+        if (!group) {
+            group = add_group(ctx, g, entries[i].hash, string_bytes, new_strings);
+            if (!group)
+                return false;
+        }
+        sql_select_merge(ctx, g->select, (char *)group + g->state_offset, (char *)keys + src->state_offset);
+    }
+    return true;
+}
+
+size_t sql_group_by_num_groups(sql_group_by_t *group_by) {
+    return group_by->num_groups;
+}
+
+size_t sql_group_by_memory_used(sql_group_by_t *group_by) {
+    return group_by->memory_used;
+}
+
+static sql_node_t *key_node(sql_ctx_t *ctx, sql_data_type_t type, sql_group_key_t *key) {
+    switch (type) {
+        case SQL_TYPE_BOOL:
+            return sql_bool_init(ctx, key->value.bool_value, key->is_null);
+        case SQL_TYPE_INT:
+            return sql_int_init(ctx, key->value.int_value, key->is_null);
+        case SQL_TYPE_DOUBLE:
+            return sql_double_init(ctx, key->value.double_value, key->is_null);
+        case SQL_TYPE_DATETIME:
+            return sql_datetime_init(ctx, key->value.epoch, key->is_null);
+        case SQL_TYPE_STRING:
+            return sql_string_init(ctx, key->is_null ? NULL : key->value.string_value, key->is_null);
+        default:
+            return sql_string_init(ctx, NULL, true);
+    }
+}
+
+bool sql_group_by_result(sql_ctx_t *ctx, sql_group_by_t *g, size_t group, sql_node_t **results) {
+    if (group >= g->num_groups)
+        return false;
+    sql_group_key_t *keys = g->groups[group];
+    sql_node_t **key_nodes = (sql_node_t **)aml_pool_alloc(ctx->pool, (g->num_keys + 1) * sizeof(sql_node_t *));
+    for (size_t i = 0; i < g->num_keys; i++)
+        key_nodes[i] = key_node(ctx, g->key_types[i], keys + i);
+    return sql_select_finalize_group(ctx, g->select, key_nodes, (char *)keys + g->state_offset, results);
+}
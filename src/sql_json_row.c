@@ -0,0 +1,595 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_json_row.h"
+#include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/number_utils.h"
+#include "a-memory-library/aml_pool.h"
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+struct sql_json_schema_s {
+    sql_ctx_column_t *columns;
+    size_t num_columns;
+    size_t *name_lengths;
+
+    // open addressing on the hash of the name, each slot is a column index + 1 (0 if empty)
+    uint32_t *slots;
+    size_t mask;
+};
+
+typedef enum {
+    SQL_JSON_NULL,     // missing or null
+    SQL_JSON_STRING,   // text is between the quotes
+    SQL_JSON_ESCAPED,  // a string with escapes
+    SQL_JSON_NESTED,   // an object or array
+    SQL_JSON_SCALAR    // a number, true, or false
+} sql_json_kind_t;
+
+// where the value of a column is in the current object
+typedef struct {
+    const char *text;
+    size_t length;
+    sql_json_kind_t kind;
+    bool found;      // the key was in the object
+    bool converted;  // the column's value is set
+} sql_json_slot_t;
+
+struct sql_json_row_s {
+    sql_json_schema_t *schema;
+    aml_pool_t *pool;         // of the row itself
+    aml_pool_t *strings;      // the strings of the current object, cleared by each decode
+    sql_json_slot_t *slots;   // per column
+    sql_node_t *values;       // a literal per column
+
+    bool *used;               // per column, the columns decoded
+    size_t num_used;
+    size_t num_found;         // of the columns in use, in the current object
+    size_t generation;        // incremented by each decode (see sql_ctx_t.row_generation)
+};
+
+static void convert_slot(sql_json_row_t *row, size_t index);
+
+static uint32_t hash_key(const char *key, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    return hash;
+}
+
+// the index of the column named key (num_columns if there isn't one)
+static size_t find_key(sql_json_schema_t *schema, const char *key, size_t length) {
+    for (size_t i = hash_key(key, length);; i++) {
+        uint32_t slot = schema->slots[i & schema->mask];
+        if (!slot)
+            return schema->num_columns;
+        size_t index = slot - 1;
+        if (schema->name_lengths[index] == length && !memcmp(schema->columns[index].name, key, length))
+            return index;
+    }
+}
+
+static sql_node_t *null_value(sql_ctx_t *ctx, sql_data_type_t type) {
+    sql_node_t *result = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
+    result->data_type = type;
+    result->type = SQL_LITERAL;
+    result->token_type = SQL_LITERAL;
+    result->value.string_value = "";
+    result->is_null = true;
+    return result;
+}
+
+// The getter of every column, which converts the column's value the first time it's read for an
+// object.  The nodes of a column have it as value.custom (see convert_ast_to_node), so finding the
+// value is an index, the name is only looked up for nodes built some other way.
+static sql_node_t *sql_json_row_column(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_json_row_t *row = (sql_json_row_t *)ctx->row;
+    if (!row)
+        return null_value(ctx, f->data_type);
+    sql_json_schema_t *schema = row->schema;
+    sql_ctx_column_t *column = (sql_ctx_column_t *)f->value.custom;
+    size_t index = 0;
+    if (column >= schema->columns && column < schema->columns + schema->num_columns) {
+        index = (size_t)(column - schema->columns);
+    } else {
+        while (index < schema->num_columns && (!f->token || strcasecmp(schema->columns[index].name, f->token)))
+            index++;
+        if (index == schema->num_columns)
+            return null_value(ctx, f->data_type);
+    }
+    if (!row->slots[index].converted)
+        convert_slot(row, index);
+    return row->values + index;
+}
+
+static size_t json_row_generation(void *row) {
+    return ((sql_json_row_t *)row)->generation;
+}
+
+sql_json_schema_t *sql_json_schema_init(sql_ctx_t *ctx) {
+    aml_pool_t *pool = sql_ctx_plan_pool(ctx);
+    sql_json_schema_t *schema = (sql_json_schema_t *)aml_pool_zalloc(pool, sizeof(*schema));
+    schema->columns = ctx->columns;
+    schema->num_columns = ctx->column_count;
+    schema->name_lengths = (size_t *)aml_pool_alloc(pool, (ctx->column_count + 1) * sizeof(size_t));
+
+    size_t size = 8;
+    while (size < ctx->column_count * 2)
+        size <<= 1;
+    schema->mask = size - 1;
+    schema->slots = (uint32_t *)aml_pool_zalloc(pool, size * sizeof(uint32_t));
+
+    if (!sql_ctx_get_callback_name(ctx, sql_json_row_column))
+        sql_ctx_register_callback(ctx, sql_json_row_column, "json_row_column",
+                                  "Returns the value of a column decoded from a JSON object");
+    // a row decoded into again is a new row for the memos, even without sql_ctx_set_row
+    ctx->row_generation = json_row_generation;
+    for (size_t i = 0; i < ctx->column_count; i++) {
+        const char *name = ctx->columns[i].name;
+        size_t length = strlen(name);
+        schema->name_lengths[i] = length;
+        ctx->columns[i].func = sql_json_row_column;
+        // a later column of the same name is never found, as with the first match in a catalog
+        if (find_key(schema, name, length) < i)
+            continue;
+        size_t slot = hash_key(name, length);
+        while (schema->slots[slot & schema->mask])
+            slot++;
+        schema->slots[slot & schema->mask] = (uint32_t)i + 1;
+    }
+    return schema;
+}
+
+static void set_null(sql_node_t *v) {
+    memset(&v->value, 0, sizeof(v->value));
+    v->value.string_value = "";
+    v->token = NULL;
+    v->is_null = true;
+}
+
+static void clear_slots(sql_json_row_t *row) {
+    for (size_t i = 0; i < row->schema->num_columns; i++) {
+        row->slots[i].kind = SQL_JSON_NULL;
+        row->slots[i].found = false;
+        row->slots[i].converted = false;
+    }
+    row->num_found = 0;
+}
+
+sql_json_row_t *sql_json_row_init(sql_json_schema_t *schema) {
+    aml_pool_t *pool = aml_pool_init(1024);
+    sql_json_row_t *row = (sql_json_row_t *)aml_pool_zalloc(pool, sizeof(*row));
+    row->schema = schema;
+    row->pool = pool;
+    row->strings = aml_pool_init(4096);
+    row->slots = (sql_json_slot_t *)aml_pool_zalloc(pool, (schema->num_columns + 1) * sizeof(sql_json_slot_t));
+    row->values = (sql_node_t *)aml_pool_zalloc(pool, (schema->num_columns + 1) * sizeof(sql_node_t));
+    row->used = (bool *)aml_pool_alloc(pool, (schema->num_columns + 1) * sizeof(bool));
+    for (size_t i = 0; i < schema->num_columns; i++) {
+        row->values[i].data_type = schema->columns[i].type;
+        row->values[i].type = SQL_LITERAL;
+        row->values[i].token_type = SQL_LITERAL;
+        set_null(row->values + i);
+    }
+    sql_json_row_use_columns(row, NULL);
+    return row;
+}
+
+void sql_json_row_use_columns(sql_json_row_t *row, const bool *used) {
+    row->num_used = 0;
+    for (size_t i = 0; i < row->schema->num_columns; i++) {
+        row->used[i] = !used || used[i];
+        if (row->used[i])
+            row->num_used++;
+    }
+    clear_slots(row);
+}
+
+void sql_json_row_destroy(sql_json_row_t *row) {
+    if (!row)
+        return;
+    aml_pool_destroy(row->strings);
+    aml_pool_destroy(row->pool);
+}
+
+sql_node_t *sql_json_row_value(sql_json_row_t *row, size_t index) {
+    if (index >= row->schema->num_columns)
+        return NULL;
+    if (!row->slots[index].converted)
+        convert_slot(row, index);
+    return row->values + index;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while (p < end && is_space(*p))
+        p++;
+    return p;
+}
+
+// The first quote or backslash at or after p (end if there isn't one), a block of bytes at a time
+static const char *find_quote(const char *p, const char *end) {
+#if defined(__AVX2__)
+    __m256i quote32 = _mm256_set1_epi8('"'), backslash32 = _mm256_set1_epi8('\\');
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        uint32_t bits = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, quote32), _mm256_cmpeq_epi8(x, backslash32)));
+        if (bits)
+            return p + __builtin_ctz(bits);
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i quote16 = _mm_set1_epi8('"'), backslash16 = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(x, quote16), _mm_cmpeq_epi8(x, backslash16)));
+        if (bits)
+            return p + __builtin_ctz(bits);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\')
+        p++;
+    return p;
+}
+
+// The first quote or bracket at or after p (end if there isn't one).  '[' and ']' differ from '{'
+// and '}' only in the 0x20 bit, so setting it finds both with one compare.
+static const char *find_structural(const char *p, const char *end) {
+#if defined(__AVX2__)
+    __m256i quote32 = _mm256_set1_epi8('"'), case32 = _mm256_set1_epi8(0x20);
+    __m256i open32 = _mm256_set1_epi8('{'), close32 = _mm256_set1_epi8('}');
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)p);
+        __m256i folded = _mm256_or_si256(x, case32);
+        __m256i brackets =
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, open32), _mm256_cmpeq_epi8(folded, close32));
+        uint32_t bits =
+            (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(brackets, _mm256_cmpeq_epi8(x, quote32)));
+        if (bits)
+            return p + __builtin_ctz(bits);
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i quote16 = _mm_set1_epi8('"'), case16 = _mm_set1_epi8(0x20);
+    __m128i open16 = _mm_set1_epi8('{'), close16 = _mm_set1_epi8('}');
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)p);
+        __m128i folded = _mm_or_si128(x, case16);
+        __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(folded, open16), _mm_cmpeq_epi8(folded, close16));
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(_mm_or_si128(brackets, _mm_cmpeq_epi8(x, quote16)));
+        if (bits)
+            return p + __builtin_ctz(bits);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']')
+        p++;
+    return p;
+}
+
+// p is at the opening quote, returns just past the closing one (NULL if there isn't one)
+static const char *scan_string(const char *p, const char *end, bool *escaped) {
+    for (p++;;) {
+        p = find_quote(p, end);
+        if (p == end)
+            return NULL;
+        if (*p == '"')
+            return p + 1;
+        // the escaped character is skipped, whatever it is
+        *escaped = true;
+        if (end - p < 2)
+            return NULL;
+        p += 2;
+    }
+}
+
+// the end of a number, true, false, or null
+static const char *scan_word(const char *p, const char *end) {
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' &&
+           *p != '\t')
+        p++;
+    return p;
+}
+
+// just past the value at p (not checking it beyond the nesting of objects and arrays)
+static const char *skip_value(const char *p, const char *end) {
+    bool escaped;
+    if (p >= end)
+        return NULL;
+    if (*p == '"')
+        return scan_string(p, end, &escaped);
+    if (*p != '{' && *p != '[') {
+        const char *word_end = scan_word(p, end);
+        return word_end > p ? word_end : NULL;
+    }
+    // only quotes and brackets matter inside, so the bytes between them are skipped in blocks
+    size_t depth = 0;
+    while ((p = find_structural(p, end)) < end) {
+        if (*p == '"') {
+            p = scan_string(p, end, &escaped);
+            if (!p)
+                return NULL;
+            continue;
+        }
+        if (*p == '{' || *p == '[')
+            depth++;
+        else if (--depth == 0)
+            return p + 1;
+        p++;
+    }
+    return NULL;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static bool read_hex4(const char *p, const char *end, uint32_t *code) {
+    if (end - p < 4)
+        return false;
+    *code = 0;
+    for (int i = 0; i < 4; i++) {
+        int d = hex_digit(p[i]);
+        if (d < 0)
+            return false;
+        *code = (*code << 4) | (uint32_t)d;
+    }
+    return true;
+}
+
+static char *put_utf8(char *out, uint32_t code) {
+    if (code < 0x80) {
+        *out++ = (char)code;
+    } else if (code < 0x800) {
+        *out++ = (char)(0xC0 | (code >> 6));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *out++ = (char)(0xE0 | (code >> 12));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (code >> 18));
+        *out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+// The length bytes between the quotes of a string, unescaped (which never makes them longer) and
+// NUL terminated in the row's strings.
+static char *copy_string(sql_json_row_t *row, const char *s, size_t length, bool escaped, size_t *out_length) {
+    char *result = (char *)aml_pool_alloc(row->strings, length + 1);
+    if (!escaped) {
+        memcpy(result, s, length);
+        result[length] = '\0';
+        *out_length = length;
+        return result;
+    }
+    const char *end = s + length;
+    char *out = result;
+    while (s < end) {
+        if (*s != '\\' || s + 1 == end) {
+            *out++ = *s++;
+            continue;
+        }
+        s++;
+        char c = *s++;
+        switch (c) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t code, low;
+                if (!read_hex4(s, end, &code)) {
+                    *out++ = c;
+                    break;
+                }
+                s += 4;
+                // a surrogate pair is one code point (six bytes of escape for four of UTF-8)
+                if (code >= 0xD800 && code < 0xDC00 && end - s >= 6 && s[0] == '\\' && s[1] == 'u' &&
+                    read_hex4(s + 2, end, &low) && low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    s += 6;
+                }
+                out = put_utf8(out, code);
+                break;
+            }
+            default:
+                // \", \\, \/ (and anything else) are the character itself
+                *out++ = c;
+        }
+    }
+    *out = '\0';
+    *out_length = (size_t)(out - result);
+    return result;
+}
+
+static bool parse_int(const char *s, int *value) {
+    const char *end;
+    if (sql_parse_int(s, value, &end) && !*end)
+        return true;
+    // 3.0, 1e3, or a number with a fraction (which is truncated)
+    double d;
+    if (!sql_parse_double(s, &d, &end) || *end || !(d > (double)INT_MIN - 1.0 && d < (double)INT_MAX + 1.0))
+        return false;
+    *value = (int)d;
+    return true;
+}
+
+static bool parse_double(const char *s, double *value) {
+    const char *end;
+    return sql_parse_double(s, value, &end) && !*end;
+}
+
+static bool parse_epoch(sql_json_row_t *row, const char *s, bool is_string, time_t *epoch) {
+    int64_t seconds;
+    const char *end;
+    if (sql_parse_int64(s, &seconds, &end) && !*end) {
+        *epoch = (time_t)seconds;
+        return true;
+    }
+    return is_string && convert_string_to_datetime(epoch, row->strings, s);
+}
+
+static bool parse_bool(const char *s, bool *value) {
+    if (!strcasecmp(s, "true") || !strcmp(s, "1")) {
+        *value = true;
+        return true;
+    }
+    if (!strcasecmp(s, "false") || !strcmp(s, "0")) {
+        *value = false;
+        return true;
+    }
+    double d;
+    if (!parse_double(s, &d))
+        return false;
+    *value = d != 0.0;
+    return true;
+}
+
+// Sets v from the text of a scalar (a string's contents, or the JSON of anything else)
+static void set_value(sql_json_row_t *row, sql_node_t *v, char *text, size_t length, bool is_string) {
+    bool ok = false;
+    switch (v->data_type) {
+        case SQL_TYPE_INT:
+            ok = parse_int(text, &v->value.int_value);
+            break;
+        case SQL_TYPE_DOUBLE:
+            ok = parse_double(text, &v->value.double_value);
+            break;
+        case SQL_TYPE_DATETIME:
+            ok = parse_epoch(row, text, is_string, &v->value.epoch);
+            break;
+        case SQL_TYPE_BOOL:
+            ok = parse_bool(text, &v->value.bool_value);
+            break;
+        case SQL_TYPE_STRING:
+            v->value.string_value = text;
+            v->value.string_length = length;
+            v->token = text;
+            ok = true;
+            break;
+        default:
+            break;
+    }
+    if (ok)
+        v->is_null = false;
+    else
+        set_null(v);
+}
+
+// records where the value at p is in slot, returns just past it (NULL if it isn't a value)
+static const char *record_value(sql_json_slot_t *slot, const char *p, const char *end) {
+    const char *value_end;
+    bool escaped = false;
+    if (*p == '"') {
+        value_end = scan_string(p, end, &escaped);
+        if (!value_end)
+            return NULL;
+        slot->text = p + 1;
+        slot->length = (size_t)(value_end - p) - 2;
+        slot->kind = escaped ? SQL_JSON_ESCAPED : SQL_JSON_STRING;
+        return value_end;
+    }
+    value_end = skip_value(p, end);
+    if (!value_end)
+        return NULL;
+    slot->text = p;
+    slot->length = (size_t)(value_end - p);
+    if (slot->length == 4 && !memcmp(p, "null", 4))
+        slot->kind = SQL_JSON_NULL;
+    else
+        slot->kind = *p == '{' || *p == '[' ? SQL_JSON_NESTED : SQL_JSON_SCALAR;
+    return value_end;
+}
+
+static void convert_slot(sql_json_row_t *row, size_t index) {
+    sql_json_slot_t *slot = row->slots + index;
+    sql_node_t *v = row->values + index;
+    slot->converted = true;
+    if (slot->kind == SQL_JSON_NULL || (slot->kind == SQL_JSON_NESTED && v->data_type != SQL_TYPE_STRING)) {
+        set_null(v);
+        return;
+    }
+    size_t length;
+    char *text = copy_string(row, slot->text, slot->length, slot->kind == SQL_JSON_ESCAPED, &length);
+    set_value(row, v, text, length, slot->kind == SQL_JSON_STRING || slot->kind == SQL_JSON_ESCAPED);
+}
+
+bool sql_json_row_decode(sql_json_row_t *row, const char *json, size_t length) {
+    sql_json_schema_t *schema = row->schema;
+    aml_pool_clear(row->strings);
+    clear_slots(row);
+    row->generation++;
+
+    const char *p = skip_space(json, json + length);
+    const char *end = json + length;
+    if (p == end || *p != '{')
+        return false;
+    p = skip_space(p + 1, end);
+    if (p < end && *p == '}')
+        return true;
+    while (p < end && *p == '"') {
+        bool escaped = false;
+        const char *key_end = scan_string(p, end, &escaped);
+        if (!key_end)
+            break;
+        const char *key = p + 1;
+        size_t key_length = (size_t)(key_end - p) - 2;
+        if (escaped)
+            key = copy_string(row, key, key_length, true, &key_length);
+        size_t index = find_key(schema, key, key_length);
+        if (index < schema->num_columns && !row->used[index])
+            index = schema->num_columns;
+
+        p = skip_space(key_end, end);
+        if (p == end || *p != ':')
+            break;
+        p = skip_space(p + 1, end);
+        if (p == end)
+            break;
+        p = index < schema->num_columns ? record_value(row->slots + index, p, end) : skip_value(p, end);
+        if (!p)
+            break;
+        if (index < schema->num_columns && !row->slots[index].found) {
+            row->slots[index].found = true;
+            // the rest of the object has nothing to decode, it only has to end (which catches a
+            // truncated line)
+            if (++row->num_found == row->num_used) {
+                const char *last = end;
+                while (last > p && is_space(last[-1]))
+                    last--;
+                if (last > p && last[-1] == '}')
+                    return true;
+                break;
+            }
+        }
+        p = skip_space(p, end);
+        if (p < end && *p == '}')
+            return true;
+        if (p == end || *p != ',')
+            break;
+        p = skip_space(p + 1, end);
+    }
+    clear_slots(row);
+    return false;
+}
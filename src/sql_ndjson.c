@@ -0,0 +1,229 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ndjson.h"
+#include "sql-parser-library/sql_dependencies.h"
+#include "a-memory-library/aml_pool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SQL_NDJSON_CHUNK_SIZE (4 * 1024 * 1024)
+#define SQL_NDJSON_BATCH_SIZE 1024
+
+struct sql_ndjson_s {
+    aml_pool_t *pool;
+    const char *data;
+    size_t size;
+};
+
+sql_ndjson_t *sql_ndjson_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return NULL;
+    }
+    void *data = NULL;
+    if (st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return NULL;
+        }
+        // read front to back once, so read ahead and drop pages behind
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    }
+    // the mapping stays valid without the descriptor
+    close(fd);
+
+    aml_pool_t *pool = aml_pool_init(256);
+    sql_ndjson_t *file = (sql_ndjson_t *)aml_pool_zalloc(pool, sizeof(sql_ndjson_t));
+    file->pool = pool;
+    file->data = (const char *)data;
+    file->size = data ? (size_t)st.st_size : 0;
+    return file;
+}
+
+void sql_ndjson_close(sql_ndjson_t *file) {
+    if (!file)
+        return;
+    if (file->data)
+        munmap((void *)file->data, file->size);
+    aml_pool_destroy(file->pool);
+}
+
+const char *sql_ndjson_data(sql_ndjson_t *file) {
+    return file->data;
+}
+
+size_t sql_ndjson_size(sql_ndjson_t *file) {
+    return file->size;
+}
+
+typedef struct sql_ndjson_scan_s sql_ndjson_scan_t;
+
+typedef struct {
+    sql_ndjson_scan_t *scan;
+    sql_exec_t *exec;
+    sql_json_row_t *row;
+} sql_ndjson_worker_t;
+
+struct sql_ndjson_scan_s {
+    const char *data;
+    size_t size;
+    size_t chunk_size;
+    size_t num_chunks;
+    size_t batch_size;
+    sql_ndjson_match_cb match;
+    void *match_arg;
+
+    atomic_size_t next_chunk;
+    atomic_bool stopped;
+    atomic_bool failed;
+};
+
+// the first line which starts at or after offset
+static const char *line_at(sql_ndjson_scan_t *s, size_t offset) {
+    const char *end = s->data + s->size;
+    if (!offset)
+        return s->data;
+    if (offset >= s->size)
+        return end;
+    // the line holding the byte before offset ends at the first newline from there (memchr looks a
+    // word or vector at a time)
+    const char *newline = (const char *)memchr(s->data + offset - 1, '\n', s->size - offset + 1);
+    return newline ? newline + 1 : end;
+}
+
+// Scans the lines which start in the chunk, returns false if the scan should stop
+static bool scan_chunk(sql_ndjson_worker_t *w, size_t chunk) {
+    sql_ndjson_scan_t *s = w->scan;
+    const char *end = s->data + s->size;
+    const char *p = line_at(s, chunk * s->chunk_size);
+    const char *last = line_at(s, (chunk + 1) * s->chunk_size);
+    size_t batch = 0;
+    bool more = true;
+    while (p < last) {
+        const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+        size_t length = (size_t)((newline ? newline : end) - p);
+        if (sql_json_row_decode(w->row, p, length) && sql_exec_matches(w->exec, w->row) &&
+            !s->match(s->match_arg, w->exec, p, length)) {
+            more = false;
+            break;
+        }
+        if (++batch == s->batch_size) {
+            if (sql_exec_ctx(w->exec)->errors)
+                break;
+            sql_exec_reset(w->exec);
+            batch = 0;
+        }
+        p = newline ? newline + 1 : end;
+    }
+    if (sql_exec_ctx(w->exec)->errors) {
+        // the errors stay on the exec context until the scan is done
+        atomic_store(&s->failed, true);
+        return false;
+    }
+    sql_exec_reset(w->exec);
+    return more;
+}
+
+static void *scan_chunks(void *arg) {
+    sql_ndjson_worker_t *w = (sql_ndjson_worker_t *)arg;
+    sql_ndjson_scan_t *s = w->scan;
+    while (!atomic_load(&s->stopped)) {
+        size_t chunk = atomic_fetch_add(&s->next_chunk, 1);
+        if (chunk >= s->num_chunks)
+            break;
+        if (!scan_chunk(w, chunk))
+            atomic_store(&s->stopped, true);
+    }
+    return NULL;
+}
+
+static void copy_errors(sql_ctx_t *ctx, sql_ctx_t *from) {
+    size_t num_errors = 0;
+    char **errors = sql_ctx_get_errors(from, &num_errors);
+    for (size_t i = 0; i < num_errors; i++)
+        sql_ctx_error(ctx, "%s", errors[i]);
+}
+
+bool sql_ndjson_scan(sql_ctx_t *ctx, sql_plan_t *plan, sql_json_schema_t *schema, const char *data,
+                     size_t size, sql_ndjson_match_cb match, void *match_arg, sql_ndjson_options_t *options) {
+    size_t num_threads = options ? options->num_threads : 0;
+    size_t chunk_size = options && options->chunk_size ? options->chunk_size : SQL_NDJSON_CHUNK_SIZE;
+    size_t batch_size = options && options->batch_size ? options->batch_size : SQL_NDJSON_BATCH_SIZE;
+    if (!num_threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (size_t)online : 1;
+    }
+    size_t num_chunks = (size + chunk_size - 1) / chunk_size;
+    if (num_threads > num_chunks)
+        num_threads = num_chunks ? num_chunks : 1;
+
+    aml_pool_t *pool = aml_pool_init(4096);
+    sql_ndjson_scan_t *s = (sql_ndjson_scan_t *)aml_pool_zalloc(pool, sizeof(sql_ndjson_scan_t));
+    s->data = data;
+    s->size = size;
+    s->chunk_size = chunk_size;
+    s->num_chunks = num_chunks;
+    s->batch_size = batch_size;
+    s->match = match;
+    s->match_arg = match_arg;
+    atomic_init(&s->next_chunk, 0);
+    atomic_init(&s->stopped, false);
+    atomic_init(&s->failed, false);
+
+    // only the columns the plan reads are decoded, the keys of the others are skipped
+    sql_dependencies_t *deps = sql_dependencies(ctx, sql_plan_where(plan), sql_plan_select(plan));
+    bool *used = (bool *)aml_pool_zalloc(pool, (ctx->column_count + 1) * sizeof(bool));
+    for (size_t i = 0; i < deps->num_filter; i++)
+        used[deps->filter[i]] = true;
+    for (size_t i = 0; i < deps->num_output; i++)
+        used[deps->output[i]] = true;
+
+    sql_ndjson_worker_t *workers =
+        (sql_ndjson_worker_t *)aml_pool_zalloc(pool, num_threads * sizeof(sql_ndjson_worker_t));
+    for (size_t i = 0; i < num_threads; i++) {
+        workers[i].scan = s;
+        workers[i].exec = sql_exec_init(plan);
+        workers[i].row = sql_json_row_init(schema);
+        sql_json_row_use_columns(workers[i].row, used);
+    }
+
+    // the first worker runs on the calling thread (as do any which can't be started)
+    pthread_t *threads = (pthread_t *)aml_pool_alloc(pool, num_threads * sizeof(pthread_t));
+    bool *started = (bool *)aml_pool_zalloc(pool, num_threads * sizeof(bool));
+    for (size_t i = 1; i < num_threads; i++)
+        started[i] = pthread_create(threads + i, NULL, scan_chunks, workers + i) == 0;
+    scan_chunks(workers);
+    for (size_t i = 1; i < num_threads; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            scan_chunks(workers + i);
+    }
+
+    bool failed = atomic_load(&s->failed);
+    for (size_t i = 0; i < num_threads; i++) {
+        if (failed)
+            copy_errors(ctx, sql_exec_ctx(workers[i].exec));
+        sql_exec_destroy(workers[i].exec);
+        sql_json_row_destroy(workers[i].row);
+    }
+    aml_pool_destroy(pool);
+    return !failed;
+}
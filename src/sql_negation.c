@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+    Pushes NOT down to the leaves so the other passes see plain predicates.
+
+        NOT (a AND b)            => NOT a OR NOT b
+        NOT (a OR b)             => NOT a AND NOT b
+        NOT NOT a                => a
+        NOT (x < 5)              => 5 <= x          (x >= 5)
+        NOT (x = 5)              => x != 5
+        NOT (x BETWEEN 1 AND 5)  => x NOT BETWEEN 1 AND 5
+        NOT (x LIKE 'a%')        => x NOT LIKE 'a%'
+        NOT (x IS NULL)          => x IS NOT NULL   (and IS TRUE / IS FALSE)
+
+    AND, OR, NOT and the comparisons all return NULL when an input is NULL, so
+    the rewrites above are exact.  NOT IN is the exception - it is never NULL
+    (see in.c) - so IN and NOT IN are only swapped where NULL and FALSE are both
+    "no match" (the root of the filter and the terms of an AND at the root), and
+    never in a value expression (push_down_value_negations).
+
+        NOT (x IN (1, 2))        => x NOT IN (1, 2) AND x IS NOT NULL
+        NOT (x NOT IN (1, 2))    => x IN (1, 2)
+
+    A NOT that can't be pushed any further (NOT flag) is left alone.
+*/
+
+typedef struct {
+    const char *name;
+    const char *negated;
+} sql_negated_spec_t;
+
+static sql_negated_spec_t negated_specs[] = {
+    { "=", "!=" },
+    { "==", "!=" },
+    { "!=", "=" },
+    { "BETWEEN", "NOT BETWEEN" },
+    { "NOT BETWEEN", "BETWEEN" },
+    { "LIKE", "NOT LIKE" },
+    { "NOT LIKE", "LIKE" },
+    { "IS NULL", "IS NOT NULL" },
+    { "IS NOT NULL", "IS NULL" },
+    { "IS TRUE", "IS NOT TRUE" },
+    { "IS NOT TRUE", "IS TRUE" },
+    { "IS FALSE", "IS NOT FALSE" },
+    { "IS NOT FALSE", "IS FALSE" }
+};
+
+static sql_node_t *not_init(sql_ctx_t *ctx, sql_node_t *node) {
+    return sql_operation_init(ctx, SQL_NOT, "NOT", &node, 1);
+}
+
+// True if the IN list only holds non-null literals
+static bool is_literal_list(sql_node_t *list) {
+    if (list->token_type != SQL_LIST)
+        return false;
+    for (size_t i = 0; i < list->num_parameters; i++) {
+        if (!is_literal(list->parameters[i]) || list->parameters[i]->is_null)
+            return false;
+    }
+    return true;
+}
+
+static sql_node_t *negate_in(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    if (!filter || node->num_parameters != 2 || !is_literal_list(node->parameters[1]))
+        return NULL;
+
+    if (!strcasecmp(node->spec->name, "NOT IN"))
+        return sql_operation_init(ctx, SQL_COMPARISON, "IN", node->parameters, 2);
+
+    // x NOT IN (...) is TRUE for a NULL x, where NOT (x IN (...)) is NULL
+    if (node->parameters[0]->token_type != SQL_IDENTIFIER)
+        return NULL;
+    sql_node_t *not_in = sql_operation_init(ctx, SQL_COMPARISON, "NOT IN", node->parameters, 2);
+    sql_node_t *column = copy_nodes(ctx, node->parameters[0]);
+    sql_node_t *not_null = sql_operation_init(ctx, SQL_COMPARISON, "IS NOT NULL", &column, 1);
+    if (!not_in || !not_null)
+        return NULL;
+    sql_node_t *parameters[2] = { not_in, not_null };
+    return sql_operation_init(ctx, SQL_AND, "AND", parameters, 2);
+}
+
+static sql_node_t *negate_comparison(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    if (!node->spec || !node->func)
+        return NULL;
+
+    const char *name = node->spec->name;
+    if (!strcmp(name, "<") || !strcmp(name, "<=")) {
+        // NOT (a < b) => b <= a, NOT (a <= b) => b < a
+        if (node->num_parameters != 2)
+            return NULL;
+        sql_node_t *parameters[2] = { node->parameters[1], node->parameters[0] };
+        return sql_operation_init(ctx, SQL_COMPARISON, name[1] ? "<" : "<=", parameters, 2);
+    }
+
+    if (!strcasecmp(name, "IN") || !strcasecmp(name, "NOT IN"))
+        return negate_in(ctx, node, filter);
+
+    for (size_t i = 0; i < sizeof(negated_specs) / sizeof(negated_specs[0]); i++) {
+        if (!strcasecmp(name, negated_specs[i].name))
+            return sql_operation_init(ctx, SQL_COMPARISON, negated_specs[i].negated,
+                                      node->parameters, node->num_parameters);
+    }
+    return NULL;
+}
+
+// Returns a node equivalent to NOT node (or NULL if NOT can't be pushed into node)
+static sql_node_t *negate(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    switch (node->token_type) {
+        case SQL_NOT:
+            return node->num_parameters == 1 ? node->parameters[0] : NULL;
+        case SQL_AND:
+        case SQL_OR: {
+            // De Morgan - the terms are negated as the walk reaches them
+            sql_node_t **parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, node->num_parameters * sizeof(sql_node_t *));
+            for (size_t i = 0; i < node->num_parameters; i++) {
+                parameters[i] = not_init(ctx, node->parameters[i]);
+                if (!parameters[i])
+                    return NULL;
+            }
+            if (node->token_type == SQL_AND)
+                return sql_operation_init(ctx, SQL_OR, "OR", parameters, node->num_parameters);
+            return sql_operation_init(ctx, SQL_AND, "AND", parameters, node->num_parameters);
+        }
+        case SQL_COMPARISON:
+            return negate_comparison(ctx, node, filter);
+        default:
+            return NULL;
+    }
+}
+
+static size_t push_down_node(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    if (!node)
+        return 0;
+
+    size_t rewrites = 0;
+    while (node->token_type == SQL_NOT && node->num_parameters == 1) {
+        sql_node_t *negated = negate(ctx, node->parameters[0], filter);
+        if (!negated)
+            break;
+        *node = *negated;
+        rewrites++;
+    }
+
+    bool child_filter = filter && node->token_type == SQL_AND;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        rewrites += push_down_node(ctx, node->parameters[i], child_filter);
+    return rewrites;
+}
+
+size_t push_down_negations(sql_ctx_t *ctx, sql_node_t *node) {
+    return push_down_node(ctx, node, true);
+}
+
+size_t push_down_value_negations(sql_ctx_t *ctx, sql_node_t *node) {
+    return push_down_node(ctx, node, false);
+}
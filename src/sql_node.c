@@ -5,7 +5,9 @@
 #include "sql-parser-library/sql_node.h"
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/date_utils.h"
+#include "sql-parser-library/number_utils.h"
 #include "a-memory-library/aml_pool.h"
+#include <stdint.h>
 #include <strings.h>
 
 const char *sql_token_type_name(sql_token_type_t type) {
@@ -59,6 +61,47 @@ bool is_literal(sql_node_t *node) {
            type == SQL_LIST;
 }
 
+// a literal, NULL, or a list of them
+static bool is_constant(sql_node_t *node) {
+    if (node->func)
+        return false;
+    if (node->token_type == SQL_LIST) {
+        for (size_t i = 0; i < node->num_parameters; i++) {
+            if (!is_constant(node->parameters[i]) || node->parameters[i]->token_type == SQL_LIST)
+                return false;
+        }
+        return true;
+    }
+    return is_literal(node) && !node->num_parameters;
+}
+
+// the value of a CONVERT of a constant, or NULL (with an error) if a value can't be converted
+static sql_node_t *convert_constant(sql_ctx_t *context, sql_node_t *node, sql_node_t *param) {
+    sql_node_t *result = node->func(context, node);
+    if (result && result->token_type == SQL_LIST) {
+        // the elements are CONVERT nodes of their own
+        for (size_t i = 0; i < result->num_parameters; i++) {
+            sql_node_t *element = result->parameters[i];
+            if (element->func)
+                element = element->func(context, element);
+            if (!element || (element->is_null && !param->parameters[i]->is_null)) {
+                sql_ctx_error(context, "Cannot convert '%s' to %s", param->parameters[i]->token,
+                              sql_data_type_name(node->data_type));
+                return NULL;
+            }
+            result->parameters[i] = element;
+        }
+        result->data_type = node->data_type;
+        return result;
+    }
+    if (!result || (result->is_null && !param->is_null)) {
+        sql_ctx_error(context, "Cannot convert '%s' to %s", param->token ? param->token : "",
+                      sql_data_type_name(node->data_type));
+        return NULL;
+    }
+    return result;
+}
+
 static sql_node_t *create_convert_node(sql_ctx_t *context, sql_node_t *param, sql_data_type_t target_type) {
     sql_node_t *node = sql_function_init(context, "CONVERT");
     node->data_type = target_type;
@@ -69,24 +112,60 @@ static sql_node_t *create_convert_node(sql_ctx_t *context, sql_node_t *param, sq
     node->spec = sql_ctx_get_spec(context, "CONVERT");
 
     if(node->spec) {
+        // CONVERT expects the type its parameter already has, so the parameter is never converted
         sql_ctx_spec_update_t *update = node->spec->update(context, node->spec, node);
         if(update) {
             node->parameters = update->parameters;
             node->num_parameters = update->num_parameters;
-            if(update->expected_data_types) {
-                for(size_t i = 0; i < node->num_parameters; i++) {
-                    if(update->expected_data_types[i] != SQL_TYPE_UNKNOWN &&
-                       node->parameters[i]->data_type != update->expected_data_types[i]) {
-                        node->parameters[i] = create_convert_node(context, node->parameters[i], update->expected_data_types[i]);
-                        node->parameters[i]->data_type = update->expected_data_types[i];
-                    }
-                }
-            }
             node->data_type = update->return_type;
             node->func = update->implementation;
         }
     }
 
+    // a constant is converted now rather than once per row
+    if(node->func && is_constant(param)) {
+        sql_node_t *result = convert_constant(context, node, param);
+        if(result) {
+            return result;
+        }
+    }
+    return node;
+}
+
+sql_node_t *sql_operation_init(sql_ctx_t *context, sql_token_type_t token_type, const char *name,
+                               sql_node_t **parameters, size_t num_parameters) {
+    sql_node_t *node = (sql_node_t *)aml_pool_zalloc(context->pool, sizeof(sql_node_t));
+    node->token_type = token_type;
+    node->type = token_type;
+    node->token = aml_pool_strdup(context->pool, name);
+    node->data_type = SQL_TYPE_UNKNOWN;
+    node->num_parameters = num_parameters;
+    node->parameters = (sql_node_t **)aml_pool_alloc(context->pool, num_parameters * sizeof(sql_node_t *));
+    for(size_t i = 0; i < num_parameters; i++) {
+        node->parameters[i] = parameters[i];
+    }
+    node->spec = sql_ctx_get_spec(context, name);
+    if(!node->spec || !node->spec->update) {
+        return NULL;
+    }
+
+    sql_ctx_spec_update_t *update = node->spec->update(context, node->spec, node);
+    if(!update) {
+        return NULL;
+    }
+    node->parameters = update->parameters;
+    node->num_parameters = update->num_parameters;
+    if(update->expected_data_types) {
+        for(size_t i = 0; i < node->num_parameters; i++) {
+            if(update->expected_data_types[i] != SQL_TYPE_UNKNOWN &&
+               node->parameters[i]->data_type != update->expected_data_types[i]) {
+                node->parameters[i] = create_convert_node(context, node->parameters[i], update->expected_data_types[i]);
+                node->parameters[i]->data_type = update->expected_data_types[i];
+            }
+        }
+    }
+    node->data_type = update->return_type;
+    node->func = update->implementation;
     return node;
 }
 
@@ -218,246 +297,202 @@ static sql_data_type_t parse_data_type_from_string(const char *type_str) {
     return SQL_TYPE_UNKNOWN;
 }
 
-void simplify_tree(sql_ctx_t *ctx, sql_node_t *node) {
-    if (!node) return;
+// Replaces node with a TRUE / FALSE literal
+static void set_bool_literal(sql_node_t *node, bool value) {
+    node->token = value ? "TRUE" : "FALSE";
+    node->type = SQL_LITERAL;
+    node->token_type = SQL_LITERAL;
+    node->func = NULL;
+    node->spec = NULL;
+    node->num_parameters = 0;
+    node->parameters = NULL;
+    node->data_type = SQL_TYPE_BOOL;
+    node->value.bool_value = value;
+    node->is_null = false;
+}
 
-    // If no children and no function, nothing to do
-    if (node->num_parameters == 0 && !node->func) {
-        return;
+static bool is_bool_literal(sql_node_t *node, bool value) {
+    return is_literal(node) && node->data_type == SQL_TYPE_BOOL && !node->is_null &&
+           node->value.bool_value == value;
+}
+
+size_t fold_constant_expressions(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node || (node->num_parameters == 0 && !node->func)) {
+        return 0;
     }
 
-    // Recurse into parameters first
+    // Simplify child nodes first
+    size_t rewrites = 0;
     for (size_t i = 0; i < node->num_parameters; i++) {
-        simplify_tree(ctx, node->parameters[i]);
+        rewrites += fold_constant_expressions(ctx, node->parameters[i]);
     }
 
-    // Now try to simplify function calls (like simplify_func_tree)
-    bool all_literals = true;
+    // Check if the current node is a function with only literal parameters
     for (size_t i = 0; i < node->num_parameters; i++) {
         if (!is_literal(node->parameters[i])) {
-            all_literals = false;
-            break;
+            return rewrites;
         }
     }
 
-    // If all literals and node->func and (node->spec or ctx->row), evaluate the function
-    if (all_literals && node->func && (node->spec || ctx->row)) {
+    if (node->func && (node->spec || ctx->row)) {
+        // Evaluate the function
         sql_node_t *result_node = node->func(ctx, node);
+
         if (result_node) {
             // Replace current node with the result
             *node = *result_node;
+            rewrites++;
         }
     }
-
-    // Now handle logical expression simplifications (like simplify_logical_expressions)
-    sql_token_type_t node_type = node->token_type;
-
-    if (node_type == SQL_AND) {
-        // Check if any literal `false`
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (is_literal(node->parameters[i]) &&
-                node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                !node->parameters[i]->value.bool_value) {
-                // Simplify to 'false'
-                node->token = "FALSE";
-                node->type = node->parameters[i]->type;
-                node->token_type = node->parameters[i]->token_type;
-                node->func = NULL;
-                node->num_parameters = 0;
-                node->parameters = NULL;
-                node->data_type = SQL_TYPE_BOOL;
-                node->value.bool_value = false;
-                node->is_null = false;
-                return;
-            }
-        }
-
-        // Remove literal `true` values
-        size_t write_index = 0;
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (!(is_literal(node->parameters[i]) &&
-                  node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                  node->parameters[i]->value.bool_value)) {
-                node->parameters[write_index++] = node->parameters[i];
-            }
-        }
-        node->num_parameters = write_index;
-
-        // If only one term remains, replace the AND with that term
-        if (node->num_parameters == 1) {
-            *node = *node->parameters[0];
-        }
-    } else if (node_type == SQL_OR) {
-        // Check if any literal `true`
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (is_literal(node->parameters[i]) &&
-                node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                node->parameters[i]->value.bool_value) {
-                // Simplify to 'true'
-                node->token = "TRUE";
-                node->type = node->parameters[i]->type;
-                node->token_type = node->parameters[i]->token_type;
-                node->func = NULL;
-                node->num_parameters = 0;
-                node->parameters = NULL;
-                node->data_type = SQL_TYPE_BOOL;
-                node->value.bool_value = true;
-                node->is_null = false;
-                return;
-            }
-        }
-
-        // Remove literal `false` values
-        size_t write_index = 0;
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (!(is_literal(node->parameters[i]) &&
-                  node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                  !node->parameters[i]->value.bool_value)) {
-                node->parameters[write_index++] = node->parameters[i];
-            }
-        }
-        node->num_parameters = write_index;
-
-        // If only one term remains, replace the OR with that term
-        if (node->num_parameters == 1) {
-            *node = *node->parameters[0];
-        }
-    }
+    return rewrites;
 }
 
-sql_node_t *copy_nodes(sql_ctx_t *ctx, sql_node_t *node) {
-    if (!node) {
-        return NULL;
+size_t flatten_logical_expressions(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node || node->num_parameters == 0) {
+        return 0;
     }
 
-    sql_node_t *new_node = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
-    *new_node = *node;
-    if(node->num_parameters) {
-        new_node->parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, node->num_parameters * sizeof(sql_node_t *));
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            new_node->parameters[i] = copy_nodes(ctx, node->parameters[i]);
-        }
+    size_t rewrites = 0;
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        rewrites += flatten_logical_expressions(ctx, node->parameters[i]);
     }
-    return new_node;
-}
 
-void simplify_func_tree(sql_ctx_t *ctx, sql_node_t *node ) {
-    if (!node || (node->num_parameters == 0 && !node->func)) {
-        return;
+    sql_token_type_t node_type = node->token_type;
+    if (node_type != SQL_AND && node_type != SQL_OR) {
+        return rewrites;
     }
 
-    // Simplify child nodes first
+    // AND(AND(a, b), c) => AND(a, b, c) (children are already flat)
+    size_t num_parameters = 0;
     for (size_t i = 0; i < node->num_parameters; i++) {
-        simplify_func_tree(ctx, node->parameters[i]);
+        sql_node_t *child = node->parameters[i];
+        num_parameters += child->token_type == node_type ? child->num_parameters : 1;
     }
-
-    // Check if the current node is a function with only literal parameters
-    bool all_literals = true;
-    for (size_t i = 0; i < node->num_parameters; i++) {
-        if (!is_literal(node->parameters[i])) {
-            all_literals = false;
-            break;
-        }
+    if (num_parameters == node->num_parameters) {
+        return rewrites;
     }
 
-    if (all_literals && node->func && (node->spec || ctx->row)) {
-        // Evaluate the function
-        sql_node_t *result_node = node->func(ctx, node);
-
-        if (result_node) {
-            // Replace current node with the result
-            *node = *result_node;
+    sql_node_t **parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, num_parameters * sizeof(sql_node_t *));
+    size_t index = 0;
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        sql_node_t *child = node->parameters[i];
+        if (child->token_type == node_type) {
+            for (size_t j = 0; j < child->num_parameters; j++) {
+                parameters[index++] = child->parameters[j];
+            }
+            rewrites++;
+        } else {
+            parameters[index++] = child;
         }
     }
+    node->parameters = parameters;
+    node->num_parameters = num_parameters;
+    return rewrites;
 }
 
-void simplify_logical_expressions(sql_node_t *node) {
+// How a literal term may decide an AND / OR.  Standard SQL decides AND(FALSE, NULL) as FALSE and
+// OR(TRUE, NULL) as TRUE, while the AND / OR specs return NULL when any term is.
+typedef enum {
+    SIMPLIFY_STANDARD,  // FALSE decides an AND and TRUE an OR, at any depth (as standard SQL)
+    SIMPLIFY_FILTER,    // FALSE decides an AND where NULL also rejects the row (see below)
+    SIMPLIFY_VALUE      // nothing decides, every NULL result is kept
+} simplify_mode_t;
+
+// In SIMPLIFY_FILTER mode node is where a NULL result rejects the row like FALSE: the top of the
+// filter or a term of an AND which is.  Its terms are only there if node is an AND.
+static size_t simplify_boolean_node(sql_node_t *node, simplify_mode_t mode) {
     if (!node || node->num_parameters == 0) {
-        return;
+        return 0;
     }
 
+    sql_token_type_t node_type = node->token_type;
+    simplify_mode_t child_mode = mode;
+    if (mode == SIMPLIFY_FILTER && node_type != SQL_AND)
+        child_mode = SIMPLIFY_VALUE;
+
     // Simplify child nodes first
+    size_t rewrites = 0;
     for (size_t i = 0; i < node->num_parameters; i++) {
-        simplify_logical_expressions(node->parameters[i]);
+        rewrites += simplify_boolean_node(node->parameters[i], child_mode);
     }
 
-    sql_token_type_t node_type = node->token_type;
+    if (node_type != SQL_AND && node_type != SQL_OR) {
+        return rewrites;
+    }
 
-    // Handle AND simplifications
-    if (node_type == SQL_AND) {
-        // Check if any literal `false` exists
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (is_literal(node->parameters[i]) &&
-                node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                !node->parameters[i]->value.bool_value) {
-                // Simplify to `false`
-                node->token = "FALSE";
-                node->type = node->parameters[i]->type;
-                node->token_type = node->parameters[i]->token_type;
-                node->func = NULL;
-                node->num_parameters = 0;
-                node->parameters = NULL;
-                node->data_type = SQL_TYPE_BOOL;
-                node->value.bool_value = false;
-                node->is_null = false;
-                return;
-            }
+    // a literal `false` decides an AND, a literal `true` decides an OR
+    bool deciding_value = node_type == SQL_OR;
+    bool decides = mode == SIMPLIFY_STANDARD || (mode == SIMPLIFY_FILTER && node_type == SQL_AND);
+    for (size_t i = 0; decides && i < node->num_parameters; i++) {
+        if (is_bool_literal(node->parameters[i], deciding_value)) {
+            set_bool_literal(node, deciding_value);
+            return rewrites + 1;
         }
+    }
 
-        // Remove literal `true` values
-        size_t write_index = 0;
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (!(is_literal(node->parameters[i]) &&
-                  node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                  node->parameters[i]->value.bool_value)) {
-                node->parameters[write_index++] = node->parameters[i];
-            }
+    // Remove the literals which don't affect the result
+    size_t write_index = 0;
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        if (!is_bool_literal(node->parameters[i], !deciding_value)) {
+            node->parameters[write_index++] = node->parameters[i];
         }
-        node->num_parameters = write_index;
+    }
+    if (write_index == node->num_parameters) {
+        return rewrites;
+    }
+    rewrites++;
+    node->num_parameters = write_index;
+
+    if (node->num_parameters == 0) {
+        // every term was the identity
+        set_bool_literal(node, !deciding_value);
+    } else if (node->num_parameters == 1) {
+        // If only one term remains, replace the AND / OR with that term
+        *node = *node->parameters[0];
+    }
+    return rewrites;
+}
 
-        // If only one term remains, replace the AND with that term
-        if (node->num_parameters == 1) {
-            *node = *node->parameters[0];
-        }
+size_t simplify_boolean_expressions(sql_ctx_t *ctx, sql_node_t *node) {
+    return simplify_boolean_node(node, SIMPLIFY_STANDARD);
+}
+
+size_t simplify_filter_booleans(sql_ctx_t *ctx, sql_node_t *node) {
+    return simplify_boolean_node(node, SIMPLIFY_FILTER);
+}
+
+size_t simplify_value_booleans(sql_ctx_t *ctx, sql_node_t *node) {
+    return simplify_boolean_node(node, SIMPLIFY_VALUE);
+}
+
+void simplify_tree(sql_ctx_t *ctx, sql_node_t *node) {
+    // folding may produce boolean literals and removing them may allow more folding
+    while (fold_constant_expressions(ctx, node) + simplify_boolean_node(node, SIMPLIFY_STANDARD) > 0)
+        ;
+}
+
+sql_node_t *copy_nodes(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node) {
+        return NULL;
     }
 
-    // Handle OR simplifications
-    else if (node_type == SQL_OR) {
-        // Check if any literal `true` exists
+    sql_node_t *new_node = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
+    *new_node = *node;
+    if(node->num_parameters) {
+        new_node->parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, node->num_parameters * sizeof(sql_node_t *));
         for (size_t i = 0; i < node->num_parameters; i++) {
-            if (is_literal(node->parameters[i]) &&
-                node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                node->parameters[i]->value.bool_value) {
-                // Simplify to `true`
-                node->token = "TRUE";
-                node->type = node->parameters[i]->type;
-                node->token_type = node->parameters[i]->token_type;
-                node->func = NULL;
-                node->num_parameters = 0;
-                node->parameters = NULL;
-                node->data_type = SQL_TYPE_BOOL;
-                node->value.bool_value = true;
-                node->is_null = false;
-                return;
-            }
+            new_node->parameters[i] = copy_nodes(ctx, node->parameters[i]);
         }
+    }
+    return new_node;
+}
 
-        // Remove literal `false` values
-        size_t write_index = 0;
-        for (size_t i = 0; i < node->num_parameters; i++) {
-            if (!(is_literal(node->parameters[i]) &&
-                  node->parameters[i]->data_type == SQL_TYPE_BOOL &&
-                  !node->parameters[i]->value.bool_value)) {
-                node->parameters[write_index++] = node->parameters[i];
-            }
-        }
-        node->num_parameters = write_index;
+void simplify_func_tree(sql_ctx_t *ctx, sql_node_t *node ) {
+    fold_constant_expressions(ctx, node);
+}
 
-        // If only one term remains, replace the OR with that term
-        if (node->num_parameters == 1) {
-            *node = *node->parameters[0];
-        }
-    }
+void simplify_logical_expressions(sql_node_t *node) {
+    simplify_boolean_node(node, SIMPLIFY_STANDARD);
 }
 
 void print_node(sql_ctx_t *ctx, sql_node_t *node, int depth) {
@@ -487,11 +522,29 @@ void print_node(sql_ctx_t *ctx, sql_node_t *node, int depth) {
 }
 
 sql_node_t *sql_eval(sql_ctx_t *ctx, sql_node_t *f) {
+    if (f->memo) {
+        sql_node_memo_t *memo = f->memo->index < ctx->num_memos ? ctx->memos + f->memo->index : f->memo;
+        size_t generation = ctx->row_generation && ctx->row ? ctx->row_generation(ctx->row) : 0;
+        if (!memo->result || memo->row != ctx->row || memo->row_id != ctx->row_id ||
+            memo->generation != generation) {
+            memo->result = f->func(ctx, f);
+            memo->row = ctx->row;
+            memo->row_id = ctx->row_id;
+            memo->generation = generation;
+        }
+        return memo->result;
+    }
     if (f->func)
         return f->func(ctx, f);
     return f;
 }
 
+sql_node_memo_t *sql_memo_init(sql_ctx_t *ctx) {
+    sql_node_memo_t *memo = (sql_node_memo_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_memo_t));
+    memo->index = SIZE_MAX;
+    return memo;
+}
+
 sql_node_t *sql_bool_init(sql_ctx_t *ctx, bool value, bool is_null) {
     sql_node_t *result = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
     result->func = NULL;
@@ -527,7 +580,8 @@ sql_node_t *sql_int_init(sql_ctx_t *ctx, int value, bool is_null) {
     result->data_type = SQL_TYPE_INT;
     result->type = SQL_LITERAL;
     result->token_type = SQL_LITERAL;
-    result->token = aml_pool_strdupf(ctx->pool, "%d", value);
+    char buffer[SQL_INT_BUFFER_SIZE];
+    result->token = aml_pool_dup(ctx->pool, buffer, sql_format_int(buffer, value) + 1);
     result->value.int_value = value;
     result->is_null = is_null;
     return result;
@@ -541,7 +595,8 @@ sql_node_t *sql_double_init(sql_ctx_t *ctx, double value, bool is_null) {
     result->data_type = SQL_TYPE_DOUBLE;
     result->type = SQL_LITERAL;
     result->token_type = SQL_LITERAL;
-    result->token = aml_pool_strdupf(ctx->pool, "%f", value);
+    char buffer[SQL_DOUBLE_BUFFER_SIZE];
+    result->token = aml_pool_dup(ctx->pool, buffer, sql_format_double(buffer, value) + 1);
     result->value.double_value = value;
     result->is_null = is_null;
     return result;
@@ -549,6 +604,20 @@ sql_node_t *sql_double_init(sql_ctx_t *ctx, double value, bool is_null) {
 
 sql_node_t *sql_string_init(sql_ctx_t *ctx, const char *value, bool is_null) {
     if(!value) value = "";
+    return sql_string_init_length(ctx, value, strlen(value), is_null);
+}
+
+sql_node_t *sql_string_init_length(sql_ctx_t *ctx, const char *value, size_t length, bool is_null) {
+    if(!value) {
+        value = "";
+        length = 0;
+    }
+    sql_node_t *result = sql_string_view_init(ctx, aml_pool_strndup(ctx->pool, value, length), length);
+    result->is_null = is_null;
+    return result;
+}
+
+sql_node_t *sql_string_view_init(sql_ctx_t *ctx, const char *value, size_t length) {
     sql_node_t *result = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
     result->func = NULL;
     result->num_parameters = 0;
@@ -556,9 +625,10 @@ sql_node_t *sql_string_init(sql_ctx_t *ctx, const char *value, bool is_null) {
     result->data_type = SQL_TYPE_STRING;
     result->type = SQL_LITERAL;
     result->token_type = SQL_LITERAL;
-    result->token = aml_pool_strdup(ctx->pool, value);
+    // the token shares the value
+    result->token = (char *)value;
     result->value.string_value = value;
-    result->is_null = is_null;
+    result->value.string_length = length;
     return result;
 }
 
@@ -585,7 +655,8 @@ sql_node_t *sql_datetime_init(sql_ctx_t *ctx, time_t epoch, bool is_null) {
     result->data_type = SQL_TYPE_DATETIME;
     result->type = SQL_LITERAL;
     result->token_type = SQL_LITERAL;
-    result->token = aml_pool_strdupf(ctx->pool, "%ld", epoch);
+    char buffer[SQL_INT_BUFFER_SIZE];
+    result->token = aml_pool_dup(ctx->pool, buffer, sql_format_int64(buffer, (int64_t)epoch) + 1);
     result->value.epoch = epoch;
     result->is_null = is_null;
     return result;
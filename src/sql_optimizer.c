@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#define _XOPEN_SOURCE 700
+
+#include "sql-parser-library/sql_optimizer.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/*
+    Runs the rewrite passes over a tree in order, repeating the whole sequence
+    until an iteration makes no rewrites (a fixpoint) or max_iterations is
+    reached.  One pass often creates work for another (folding a constant
+    leaves a TRUE in an AND, merging ranges leaves TRUE / FALSE terms behind),
+    so a single ordered run isn't always enough.
+
+    Each pass is expected to report 0 once the tree is stable, otherwise the
+    optimizer stops at max_iterations.  Final passes run once afterwards.
+*/
+
+static uint64_t now_nanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+sql_optimizer_t *sql_optimizer_init(sql_ctx_t *ctx) {
+    sql_optimizer_t *opt = (sql_optimizer_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_optimizer_t));
+    opt->ctx = ctx;
+    opt->max_iterations = 8;
+    return opt;
+}
+
+sql_optimizer_t *sql_optimizer_default(sql_ctx_t *ctx) {
+    sql_optimizer_t *opt = sql_optimizer_init(ctx);
+    sql_optimizer_add_pass(opt, "fold_constants", fold_constant_expressions);
+    sql_optimizer_add_pass(opt, "push_negations", push_down_negations);
+    sql_optimizer_add_pass(opt, "date_ranges", rewrite_date_predicates);
+    sql_optimizer_add_pass(opt, "flatten_logical", flatten_logical_expressions);
+    sql_optimizer_add_pass(opt, "merge_ranges", merge_range_predicates);
+    sql_optimizer_add_pass(opt, "simplify_booleans", simplify_boolean_expressions);
+    sql_optimizer_add_final_pass(opt, "dictionary_codes", rewrite_dictionary_predicates);
+    sql_optimizer_add_final_pass(opt, "share_subexpressions", share_common_subexpressions);
+    return opt;
+}
+
+sql_optimizer_t *sql_optimizer_value(sql_ctx_t *ctx) {
+    sql_optimizer_t *opt = sql_optimizer_init(ctx);
+    sql_optimizer_add_pass(opt, "fold_constants", fold_constant_expressions);
+    sql_optimizer_add_pass(opt, "push_negations", push_down_value_negations);
+    sql_optimizer_add_pass(opt, "date_ranges", rewrite_date_predicates);
+    sql_optimizer_add_pass(opt, "flatten_logical", flatten_logical_expressions);
+    sql_optimizer_add_pass(opt, "merge_ranges", merge_value_range_predicates);
+    sql_optimizer_add_pass(opt, "simplify_booleans", simplify_value_booleans);
+    sql_optimizer_add_final_pass(opt, "dictionary_codes", rewrite_dictionary_predicates);
+    sql_optimizer_add_final_pass(opt, "share_subexpressions", share_common_subexpressions);
+    return opt;
+}
+
+void sql_optimizer_add_pass(sql_optimizer_t *opt, const char *name, sql_optimizer_pass_cb pass) {
+    if (opt->num_passes == opt->size) {
+        size_t size = opt->size ? opt->size * 2 : 8;
+        sql_optimizer_pass_t *passes =
+            (sql_optimizer_pass_t *)aml_pool_zalloc(opt->ctx->pool, size * sizeof(sql_optimizer_pass_t));
+        if (opt->num_passes)
+            memcpy(passes, opt->passes, opt->num_passes * sizeof(sql_optimizer_pass_t));
+        opt->passes = passes;
+        opt->size = size;
+    }
+    sql_optimizer_pass_t *p = opt->passes + opt->num_passes++;
+    p->name = aml_pool_strdup(opt->ctx->pool, name);
+    p->pass = pass;
+    p->enabled = true;
+}
+
+void sql_optimizer_add_final_pass(sql_optimizer_t *opt, const char *name, sql_optimizer_pass_cb pass) {
+    sql_optimizer_add_pass(opt, name, pass);
+    opt->passes[opt->num_passes - 1].final = true;
+}
+
+static size_t run_pass(sql_optimizer_t *opt, sql_optimizer_pass_t *p, sql_node_t *node) {
+    uint64_t start = now_nanoseconds();
+    size_t rewrites = p->pass(opt->ctx, node);
+    p->nanoseconds += now_nanoseconds() - start;
+    p->runs++;
+    p->rewrites += rewrites;
+    return rewrites;
+}
+
+bool sql_optimizer_enable_pass(sql_optimizer_t *opt, const char *name, bool enabled) {
+    for (size_t i = 0; i < opt->num_passes; i++) {
+        if (!strcasecmp(opt->passes[i].name, name)) {
+            opt->passes[i].enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+void sql_optimizer_set_max_iterations(sql_optimizer_t *opt, size_t max_iterations) {
+    opt->max_iterations = max_iterations ? max_iterations : 1;
+}
+
+sql_node_t *sql_optimize(sql_optimizer_t *opt, sql_node_t *node) {
+    opt->iterations = 0;
+    opt->fixpoint = false;
+    if (!node)
+        return NULL;
+
+    while (opt->iterations < opt->max_iterations) {
+        opt->iterations++;
+        size_t rewrites = 0;
+        for (size_t i = 0; i < opt->num_passes; i++) {
+            sql_optimizer_pass_t *p = opt->passes + i;
+            if (p->enabled && !p->final)
+                rewrites += run_pass(opt, p, node);
+        }
+        if (!rewrites) {
+            opt->fixpoint = true;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < opt->num_passes; i++) {
+        sql_optimizer_pass_t *p = opt->passes + i;
+        if (p->enabled && p->final)
+            run_pass(opt, p, node);
+    }
+    return node;
+}
+
+void sql_optimizer_print_stats(sql_optimizer_t *opt) {
+    printf("optimizer: %zu iteration(s)%s\n", opt->iterations,
+           opt->fixpoint ? "" : " (stopped before reaching a fixpoint)");
+    for (size_t i = 0; i < opt->num_passes; i++) {
+        sql_optimizer_pass_t *p = opt->passes + i;
+        printf("  %-22s %s runs: %zu rewrites: %zu time: %.3f us\n", p->name,
+               p->enabled ? "  " : "- ", p->runs, p->rewrites, p->nanoseconds / 1000.0);
+    }
+}
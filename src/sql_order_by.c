@@ -0,0 +1,379 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_order_by.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_strcase.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Top-K for ORDER BY ... LIMIT.
+
+        SELECT * FROM events WHERE kind = 'login' ORDER BY created DESC LIMIT 50
+
+    With LIMIT the rows kept are a max-heap of OFFSET + LIMIT entries whose
+    root is the row which sorts last.  A new row is compared (by its evaluated
+    keys, nothing is copied yet) against the root and either dropped or
+    written over it, so a scan takes O(N log K) time and K entries of memory.
+    Each entry keeps its typed keys and a copy of the caller's row, a string
+    key is copied into a buffer owned by the entry which is only reallocated
+    for a longer value.  Without LIMIT every row is kept (the heap is still
+    used for the final sort).
+
+    Rows are numbered as they are added and the number is the last key, so
+    rows with equal keys keep their order.  Without ORDER BY the rows are
+    already in order: they are appended after skipping OFFSET rows and the
+    scan can stop as soon as LIMIT rows are kept.
+*/
+
+typedef struct {
+    bool is_null;
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        time_t epoch;
+        const char *string_value;
+    } value;
+    size_t length;            // of string_value, which needn't be NUL-terminated until it's copied
+    char *buffer;             // the copy of a string value owned by an entry
+    size_t size;
+} sql_sort_value_t;
+
+typedef struct {
+    size_t sequence;          // the order the row was added in
+    sql_sort_value_t keys[];  // followed by the copy of the row
+} sql_sort_entry_t;
+
+typedef struct {
+    sql_node_t *expr;
+    bool descending;
+    bool nulls_first;
+} sql_sort_key_t;
+
+struct sql_order_by_s {
+    aml_pool_t *pool;
+
+    sql_sort_key_t *keys;
+    size_t num_keys;
+
+    bool has_limit;
+    size_t limit;
+    size_t offset;
+    size_t capacity;          // OFFSET + LIMIT, the entries kept with LIMIT
+
+    size_t row_size;
+    size_t row_offset;        // of the copy of the row within an entry
+    size_t entry_size;
+
+    sql_sort_entry_t **entries;
+    size_t num_entries;
+    size_t entries_size;
+
+    sql_sort_entry_t *candidate;  // the keys of the row being added (strings point into the row)
+    size_t num_added;
+    size_t first;             // the first entry in the result
+};
+
+static int compare_values(sql_sort_key_t *key, const sql_sort_value_t *a, const sql_sort_value_t *b) {
+    if (a->is_null || b->is_null) {
+        if (a->is_null == b->is_null)
+            return 0;
+        // nulls_first doesn't depend on the direction
+        return (a->is_null ? -1 : 1) * (key->nulls_first ? 1 : -1);
+    }
+    int result = 0;
+    switch (key->expr->data_type) {
+        case SQL_TYPE_BOOL:
+            result = (int)a->value.bool_value - (int)b->value.bool_value;
+            break;
+        case SQL_TYPE_INT:
+            result = (a->value.int_value > b->value.int_value) - (a->value.int_value < b->value.int_value);
+            break;
+        case SQL_TYPE_DOUBLE:
+            result = (a->value.double_value > b->value.double_value) -
+                     (a->value.double_value < b->value.double_value);
+            break;
+        case SQL_TYPE_DATETIME:
+            result = (a->value.epoch > b->value.epoch) - (a->value.epoch < b->value.epoch);
+            break;
+        case SQL_TYPE_STRING:
+            result = sql_strcase_compare(a->value.string_value, a->length, b->value.string_value, b->length);
+            break;
+        default:
+            break;
+    }
+    return key->descending ? -result : result;
+}
+
+// < 0 if a sorts before b
+static int compare_entries(sql_order_by_t *o, const sql_sort_entry_t *a, const sql_sort_entry_t *b) {
+    for (size_t i = 0; i < o->num_keys; i++) {
+        int result = compare_values(o->keys + i, a->keys + i, b->keys + i);
+        if (result)
+            return result;
+    }
+    return (a->sequence > b->sequence) - (a->sequence < b->sequence);
+}
+
+static void sift_up(sql_order_by_t *o, size_t i) {
+    sql_sort_entry_t **e = o->entries;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (compare_entries(o, e[parent], e[i]) >= 0)
+            break;
+        sql_sort_entry_t *tmp = e[parent];
+        e[parent] = e[i];
+        e[i] = tmp;
+        i = parent;
+    }
+}
+
+// restores the heap below i within the first n entries
+static void sift_down(sql_order_by_t *o, size_t i, size_t n) {
+    sql_sort_entry_t **e = o->entries;
+    for (;;) {
+        size_t largest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < n && compare_entries(o, e[left], e[largest]) > 0)
+            largest = left;
+        if (right < n && compare_entries(o, e[right], e[largest]) > 0)
+            largest = right;
+        if (largest == i)
+            return;
+        sql_sort_entry_t *tmp = e[largest];
+        e[largest] = e[i];
+        e[i] = tmp;
+        i = largest;
+    }
+}
+
+// the keys of ctx->row into the candidate entry
+static void evaluate_keys(sql_ctx_t *ctx, sql_order_by_t *o, size_t sequence) {
+    for (size_t i = 0; i < o->num_keys; i++) {
+        sql_node_t *value = sql_eval(ctx, o->keys[i].expr);
+        sql_sort_value_t *key = o->candidate->keys + i;
+        key->is_null = !value || value->is_null;
+        if (key->is_null)
+            continue;
+        if (o->keys[i].expr->data_type == SQL_TYPE_STRING) {
+            key->value.string_value = value->value.string_value ? value->value.string_value : "";
+            key->length = sql_node_string_length(value);
+        } else
+            memcpy(&key->value, &value->value, sizeof(key->value));
+    }
+    o->candidate->sequence = sequence;
+}
+
+// copies the candidate and row into entry, reusing the entry's string buffers
+static void store_entry(sql_order_by_t *o, sql_sort_entry_t *entry, const void *row) {
+    entry->sequence = o->candidate->sequence;
+    for (size_t i = 0; i < o->num_keys; i++) {
+        sql_sort_value_t *from = o->candidate->keys + i;
+        sql_sort_value_t *to = entry->keys + i;
+        to->is_null = from->is_null;
+        if (to->is_null)
+            continue;
+        if (o->keys[i].expr->data_type != SQL_TYPE_STRING) {
+            to->value = from->value;
+            continue;
+        }
+        if (from->length + 1 > to->size) {
+            to->size = (from->length + 1) * 2;
+            to->buffer = (char *)aml_pool_alloc(o->pool, to->size);
+        }
+        memcpy(to->buffer, from->value.string_value, from->length);
+        to->buffer[from->length] = 0;
+        to->value.string_value = to->buffer;
+        to->length = from->length;
+    }
+    if (o->row_size)
+        memcpy((char *)entry + o->row_offset, row, o->row_size);
+}
+
+static sql_sort_entry_t *new_entry(sql_order_by_t *o) {
+    if (o->num_entries == o->entries_size) {
+        size_t size = o->entries_size ? o->entries_size * 2 : 16;
+        sql_sort_entry_t **entries = (sql_sort_entry_t **)aml_pool_alloc(o->pool, size * sizeof(sql_sort_entry_t *));
+        if (o->num_entries)
+            memcpy(entries, o->entries, o->num_entries * sizeof(sql_sort_entry_t *));
+        o->entries = entries;
+        o->entries_size = size;
+    }
+    sql_sort_entry_t *entry = (sql_sort_entry_t *)aml_pool_zalloc(o->pool, o->entry_size);
+    o->entries[o->num_entries++] = entry;
+    return entry;
+}
+
+static size_t parse_count(sql_ast_node_t *clause) {
+    return clause && clause->left ? (size_t)strtoull(clause->left->value, NULL, 10) : 0;
+}
+
+static bool is_column(sql_ctx_t *ctx, const char *name) {
+    for (size_t i = 0; i < ctx->column_count; i++) {
+        if (!strcasecmp(ctx->columns[i].name, name))
+            return true;
+    }
+    return false;
+}
+
+// A column of the row for a position of SELECT * (the AST has no node for it)
+static sql_ast_node_t *column_ast(sql_ctx_t *ctx, sql_ctx_column_t *column) {
+    sql_ast_node_t *node = (sql_ast_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_ast_node_t));
+    node->type = SQL_IDENTIFIER;
+    node->value = aml_pool_strdup(ctx->pool, column->name);
+    return node;
+}
+
+// The expression an ORDER BY item sorts by.  An alias of the SELECT list (which wins over a column
+// of the same name) or an integer position in it (1 for the first item) stands for that item,
+// anything else is an expression of the row.  Returns NULL (with an error on ctx) for a position
+// outside the SELECT list or a name which is neither an alias nor a column.
+static sql_ast_node_t *resolve_key(sql_ctx_t *ctx, sql_ast_node_t *ast, sql_ast_node_t *expr, size_t index) {
+    sql_ast_node_t *select_clause = find_clause(ast, "SELECT");
+    sql_ast_node_t *items = select_clause ? select_clause->left : NULL;
+    if (expr->type == SQL_IDENTIFIER) {
+        for (sql_ast_node_t *item = items; item; item = item->next) {
+            if (item->type == SQL_KEYWORD && item->right && !strcasecmp(item->right->value, expr->value))
+                return item->left;
+        }
+        if (!is_column(ctx, expr->value)) {
+            sql_ctx_error(ctx, "ORDER BY expression %d (%s) is neither a column nor a SELECT alias",
+                          (int)index + 1, expr->value);
+            return NULL;
+        }
+        return expr;
+    }
+    if (expr->type != SQL_NUMBER || strspn(expr->value, "0123456789") != strlen(expr->value))
+        return expr;
+
+    size_t position = (size_t)strtoull(expr->value, NULL, 10);
+    size_t n = 0;
+    for (sql_ast_node_t *item = items; item; item = item->next) {
+        if (item->type == SQL_STAR) {
+            if (position > n && position <= n + ctx->column_count)
+                return column_ast(ctx, ctx->columns + (position - n - 1));
+            n += ctx->column_count;
+        } else if (++n == position) {
+            return item->type == SQL_KEYWORD ? item->left : item;
+        }
+    }
+    sql_ctx_error(ctx, "ORDER BY position %s is not in the SELECT list (1 to %zu)", expr->value, n);
+    return NULL;
+}
+
+sql_order_by_t *sql_order_by_init(sql_ctx_t *ctx, sql_ast_node_t *ast, size_t row_size) {
+    sql_ast_node_t *order_clause = find_clause(ast, "ORDER BY");
+    size_t num_keys = 0;
+    for (sql_ast_node_t *item = order_clause ? order_clause->left : NULL; item; item = item->next)
+        num_keys++;
+
+    sql_sort_key_t *keys = (sql_sort_key_t *)aml_pool_zalloc(ctx->pool, (num_keys + 1) * sizeof(sql_sort_key_t));
+    // fold_constant_expressions would read columns from the row
+    void *row = ctx->row;
+    ctx->row = NULL;
+    size_t i = 0;
+    for (sql_ast_node_t *item = order_clause ? order_clause->left : NULL; item; item = item->next, i++) {
+        sql_sort_key_t *key = keys + i;
+        sql_ast_node_t *expr = resolve_key(ctx, ast, item->left, i);
+        key->expr = expr ? convert_ast_to_node(ctx, expr) : NULL;
+        if (!key->expr)
+            break;
+        apply_type_conversions(ctx, key->expr);
+        sql_optimize(sql_optimizer_value(ctx), key->expr);
+        switch (key->expr->data_type) {
+            case SQL_TYPE_BOOL:
+            case SQL_TYPE_INT:
+            case SQL_TYPE_DOUBLE:
+            case SQL_TYPE_DATETIME:
+            case SQL_TYPE_STRING:
+                break;
+            default:
+                sql_ctx_error(ctx, "ORDER BY expression %d has a type which can't be sorted (%s)",
+                              (int)i + 1, sql_data_type_name(key->expr->data_type));
+                break;
+        }
+        key->descending = strcasecmp(item->value, "DESC") == 0;
+        key->nulls_first = item->right ? strcasecmp(item->right->value, "NULLS FIRST") == 0 : key->descending;
+    }
+    ctx->row = row;
+    if (ctx->errors)
+        return NULL;
+
+    aml_pool_t *pool = aml_pool_init(16384);
+    sql_order_by_t *o = (sql_order_by_t *)aml_pool_zalloc(pool, sizeof(sql_order_by_t));
+    o->pool = pool;
+    o->keys = keys;
+    o->num_keys = num_keys;
+
+    sql_ast_node_t *limit_clause = find_clause(ast, "LIMIT");
+    o->has_limit = limit_clause != NULL;
+    o->limit = parse_count(limit_clause);
+    o->offset = parse_count(find_clause(ast, "OFFSET"));
+    o->capacity = o->offset + o->limit < o->offset ? (size_t)-1 : o->offset + o->limit;
+
+    size_t alignment = _Alignof(max_align_t);
+    o->row_size = row_size;
+    o->row_offset = (offsetof(sql_sort_entry_t, keys) + num_keys * sizeof(sql_sort_value_t) + alignment - 1) &
+                    ~(alignment - 1);
+    o->entry_size = o->row_offset + row_size;
+    o->candidate = (sql_sort_entry_t *)aml_pool_zalloc(pool, o->entry_size);
+    return o;
+}
+
+void sql_order_by_destroy(sql_order_by_t *order_by) {
+    aml_pool_destroy(order_by->pool);
+}
+
+bool sql_order_by_add(sql_ctx_t *ctx, sql_order_by_t *o, const void *row) {
+    size_t sequence = o->num_added++;
+    if (o->has_limit && !o->limit)
+        return false;
+
+    if (!o->num_keys) {
+        // rows arrive in order, keep the ones after OFFSET until LIMIT of them are kept
+        if (sequence >= o->offset) {
+            o->candidate->sequence = sequence;
+            store_entry(o, new_entry(o), row);
+        }
+        return !o->has_limit || sequence + 1 < o->capacity;
+    }
+
+    evaluate_keys(ctx, o, sequence);
+    if (!o->has_limit || o->num_entries < o->capacity) {
+        store_entry(o, new_entry(o), row);
+        sift_up(o, o->num_entries - 1);
+    } else if (compare_entries(o, o->candidate, o->entries[0]) < 0) {
+        store_entry(o, o->entries[0], row);
+        sift_down(o, 0, o->num_entries);
+    }
+    return true;
+}
+
+void sql_order_by_finish(sql_order_by_t *o) {
+    if (!o->num_keys)
+        return;
+    // heap sort, the root (the row which sorts last) is moved to the end each time
+    for (size_t n = o->num_entries; n > 1; n--) {
+        sql_sort_entry_t *tmp = o->entries[0];
+        o->entries[0] = o->entries[n - 1];
+        o->entries[n - 1] = tmp;
+        sift_down(o, 0, n - 1);
+    }
+    o->first = o->offset < o->num_entries ? o->offset : o->num_entries;
+}
+
+size_t sql_order_by_num_rows(sql_order_by_t *order_by) {
+    return order_by->num_entries - order_by->first;
+}
+
+const void *sql_order_by_row(sql_order_by_t *order_by, size_t row) {
+    if (row >= order_by->num_entries - order_by->first)
+        return NULL;
+    return (char *)order_by->entries[order_by->first + row] + order_by->row_offset;
+}
@@ -0,0 +1,281 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_parallel_aggregate.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/*
+    Parallel hash aggregation.
+
+        SELECT region, COUNT(*), AVG(amount) FROM t WHERE amount > 0 GROUP BY region
+
+    Each worker has a copy of the ctx with its own pool and compiles its own
+    WHERE and SELECT from the shared AST, so nothing a worker evaluates (memos,
+    values, errors) is seen by another.  The rows are split into morsels which
+    the workers claim from an atomic counter until none are left, so a worker
+    which gets cheap rows simply claims more of them.  Each worker accumulates
+    into a table of its own, without locks.
+
+    When a worker runs out of rows it splits its table into partitions by the
+    hash of the keys.  The partitions are then merged by the same workers (each
+    claims partitions from a second counter), partition p of every worker's
+    table going into the final table for p.  A group only lives in one
+    partition, so the final tables are built at the same time without sharing
+    anything and the result is their concatenation.
+
+    The final tables use the select compiled on the caller's ctx, merging only
+    touches the states, so it's safe to share until groups are finalized (one
+    at a time by the caller).
+*/
+
+typedef struct sql_parallel_worker_s sql_parallel_worker_t;
+
+struct sql_parallel_worker_s {
+    sql_parallel_aggregate_t *parallel;
+    sql_ctx_t ctx;
+    sql_select_t *select;
+    sql_node_t *where;
+    sql_group_by_t *group_by;
+};
+
+struct sql_parallel_aggregate_s {
+    aml_pool_t *pool;
+    sql_select_t *select;
+
+    sql_parallel_worker_t *workers;
+    size_t num_workers;
+
+    sql_group_by_t **partitions;
+    size_t *partition_groups;     // the first group of each partition (num_partitions + 1)
+    size_t num_partitions;
+
+    sql_row_source_cb source;
+    void *arg;
+    size_t num_rows;
+    size_t morsel_size;
+
+    atomic_size_t next_row;
+    atomic_size_t next_partition;
+    atomic_bool failed;
+};
+
+#define SQL_PARALLEL_MORSEL_SIZE 16384
+
+// the values evaluated for a morsel go to a scratch pool, cleared before the next morsel (the
+// groups and their states live in the table's pool)
+static void *scan_rows(void *arg) {
+    sql_parallel_worker_t *w = (sql_parallel_worker_t *)arg;
+    sql_parallel_aggregate_t *p = w->parallel;
+    bool ok = true;
+    sql_ctx_begin_scratch(&w->ctx);
+    while (ok && !atomic_load(&p->failed)) {
+        size_t start = atomic_fetch_add(&p->next_row, p->morsel_size);
+        if (start >= p->num_rows)
+            break;
+        size_t end = p->num_rows - start > p->morsel_size ? start + p->morsel_size : p->num_rows;
+        for (size_t i = start; i < end; i++) {
+            sql_ctx_set_row(&w->ctx, p->source(p->arg, i));
+            if (w->where) {
+                sql_node_t *match = sql_eval(&w->ctx, w->where);
+                if (!match || match->is_null || !match->value.bool_value)
+                    continue;
+            }
+            if (!sql_group_by_accumulate(&w->ctx, w->group_by)) {
+                atomic_store(&p->failed, true);
+                ok = false;
+                break;
+            }
+        }
+        sql_ctx_reset_scratch(&w->ctx);
+    }
+    sql_ctx_end_scratch(&w->ctx);
+    if (ok)
+        sql_group_by_partition(w->group_by, p->num_partitions);
+    return NULL;
+}
+
+static void *merge_partitions(void *arg) {
+    sql_parallel_worker_t *w = (sql_parallel_worker_t *)arg;
+    sql_parallel_aggregate_t *p = w->parallel;
+    while (!atomic_load(&p->failed)) {
+        size_t partition = atomic_fetch_add(&p->next_partition, 1);
+        if (partition >= p->num_partitions)
+            break;
+        for (size_t i = 0; i < p->num_workers; i++) {
+            if (!sql_group_by_merge(&w->ctx, p->partitions[partition], p->workers[i].group_by, partition)) {
+                atomic_store(&p->failed, true);
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+// runs fn for every worker, the first on the calling thread (or all of them if threads can't be created)
+static void run_workers(sql_parallel_aggregate_t *p, void *(*fn)(void *)) {
+    pthread_t *threads = (pthread_t *)aml_pool_alloc(p->pool, p->num_workers * sizeof(pthread_t));
+    bool *started = (bool *)aml_pool_zalloc(p->pool, p->num_workers * sizeof(bool));
+    for (size_t i = 1; i < p->num_workers; i++)
+        started[i] = pthread_create(threads + i, NULL, fn, p->workers + i) == 0;
+    fn(p->workers);
+    for (size_t i = 1; i < p->num_workers; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            fn(p->workers + i);
+    }
+}
+
+static void copy_errors(sql_ctx_t *ctx, sql_ctx_t *from) {
+    size_t num_errors = 0;
+    char **errors = sql_ctx_get_errors(from, &num_errors);
+    for (size_t i = 0; i < num_errors; i++)
+        sql_ctx_error(ctx, "%s", errors[i]);
+}
+
+static void init_worker(sql_ctx_t *ctx, sql_parallel_aggregate_t *p, sql_parallel_worker_t *w,
+                        sql_ast_node_t *ast, size_t max_memory) {
+    w->parallel = p;
+    w->ctx = *ctx;
+    w->ctx.pool = aml_pool_init(16384);
+    w->ctx.errors = NULL;
+    w->ctx.warnings = NULL;
+    w->ctx.row = NULL;
+    w->ctx.row_id = 0;
+    w->ctx.plan_pool = NULL;
+    w->ctx.memos = NULL;
+    w->ctx.num_memos = 0;
+
+    w->select = sql_select_compile(&w->ctx, ast);
+    sql_ast_node_t *where_clause = find_clause(ast, "WHERE");
+    if (where_clause && where_clause->left) {
+        w->where = convert_ast_to_node(&w->ctx, where_clause->left);
+        if (w->where) {
+            apply_type_conversions(&w->ctx, w->where);
+            if (w->where->data_type != SQL_TYPE_BOOL)
+                sql_ctx_error(&w->ctx, "WHERE must be a boolean expression");
+            else
+                sql_optimize(sql_optimizer_default(&w->ctx), w->where);
+        }
+    }
+    if (w->select && !w->ctx.errors)
+        w->group_by = sql_group_by_init(&w->ctx, w->select, max_memory);
+}
+
+sql_parallel_aggregate_t *sql_parallel_aggregate(sql_ctx_t *ctx, sql_ast_node_t *ast,
+                                                 sql_row_source_cb source, void *arg, size_t num_rows,
+                                                 sql_parallel_options_t *options) {
+    // compiling on ctx first registers the callbacks the workers look up (their copies share them)
+    sql_select_t *select = sql_select_compile(ctx, ast);
+    if (!select)
+        return NULL;
+
+    size_t num_threads = options ? options->num_threads : 0;
+    size_t morsel_size = options && options->morsel_size ? options->morsel_size : SQL_PARALLEL_MORSEL_SIZE;
+    size_t max_memory = options ? options->max_memory : 0;
+    if (!num_threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (size_t)online : 1;
+    }
+    size_t num_morsels = (num_rows + morsel_size - 1) / morsel_size;
+    if (num_threads > num_morsels)
+        num_threads = num_morsels ? num_morsels : 1;
+
+    aml_pool_t *pool = aml_pool_init(4096);
+    sql_parallel_aggregate_t *p = (sql_parallel_aggregate_t *)aml_pool_zalloc(pool, sizeof(sql_parallel_aggregate_t));
+    p->pool = pool;
+    p->select = select;
+    p->source = source;
+    p->arg = arg;
+    p->num_rows = num_rows;
+    p->morsel_size = morsel_size;
+    atomic_init(&p->next_row, 0);
+    atomic_init(&p->next_partition, 0);
+    atomic_init(&p->failed, false);
+
+    // without GROUP BY there is one group, which must only be merged once
+    p->num_partitions = sql_select_num_group_keys(select) ? num_threads : 1;
+    p->num_workers = num_threads;
+    p->workers = (sql_parallel_worker_t *)aml_pool_zalloc(pool, num_threads * sizeof(sql_parallel_worker_t));
+    for (size_t i = 0; i < num_threads; i++) {
+        sql_parallel_worker_t *w = p->workers + i;
+        init_worker(ctx, p, w, ast, max_memory);
+        if (!w->group_by) {
+            copy_errors(ctx, &w->ctx);
+            sql_parallel_aggregate_destroy(p);
+            return NULL;
+        }
+    }
+
+    p->partitions = (sql_group_by_t **)aml_pool_zalloc(pool, p->num_partitions * sizeof(sql_group_by_t *));
+    for (size_t i = 0; i < p->num_partitions; i++)
+        p->partitions[i] = sql_group_by_init(ctx, select, max_memory);
+
+    run_workers(p, scan_rows);
+    if (!atomic_load(&p->failed))
+        run_workers(p, merge_partitions);
+    if (atomic_load(&p->failed)) {
+        for (size_t i = 0; i < p->num_workers; i++)
+            copy_errors(ctx, &p->workers[i].ctx);
+        sql_parallel_aggregate_destroy(p);
+        return NULL;
+    }
+
+    // the states were copied into the partitions
+    for (size_t i = 0; i < p->num_workers; i++) {
+        sql_group_by_destroy(p->workers[i].group_by);
+        p->workers[i].group_by = NULL;
+    }
+
+    p->partition_groups = (size_t *)aml_pool_zalloc(pool, (p->num_partitions + 1) * sizeof(size_t));
+    for (size_t i = 0; i < p->num_partitions; i++)
+        p->partition_groups[i + 1] = p->partition_groups[i] + sql_group_by_num_groups(p->partitions[i]);
+    return p;
+}
+
+void sql_parallel_aggregate_destroy(sql_parallel_aggregate_t *p) {
+    for (size_t i = 0; p->partitions && i < p->num_partitions; i++) {
+        if (p->partitions[i])
+            sql_group_by_destroy(p->partitions[i]);
+    }
+    for (size_t i = 0; i < p->num_workers; i++) {
+        sql_parallel_worker_t *w = p->workers + i;
+        if (w->group_by)
+            sql_group_by_destroy(w->group_by);
+        // the merged MIN / MAX strings were allocated from the worker's pool
+        if (w->ctx.pool)
+            aml_pool_destroy(w->ctx.pool);
+    }
+    aml_pool_destroy(p->pool);
+}
+
+sql_select_t *sql_parallel_aggregate_select(sql_parallel_aggregate_t *parallel) {
+    return parallel->select;
+}
+
+size_t sql_parallel_aggregate_num_groups(sql_parallel_aggregate_t *parallel) {
+    return parallel->partition_groups[parallel->num_partitions];
+}
+
+size_t sql_parallel_aggregate_num_partitions(sql_parallel_aggregate_t *parallel) {
+    return parallel->num_partitions;
+}
+
+size_t sql_parallel_aggregate_partition_groups(sql_parallel_aggregate_t *parallel, size_t partition) {
+    if (partition >= parallel->num_partitions)
+        return 0;
+    return parallel->partition_groups[partition + 1] - parallel->partition_groups[partition];
+}
+
+bool sql_parallel_aggregate_result(sql_ctx_t *ctx, sql_parallel_aggregate_t *p, size_t group,
+                                   sql_node_t **results) {
+    for (size_t i = 0; i < p->num_partitions; i++) {
+        if (group < p->partition_groups[i + 1])
+            return sql_group_by_result(ctx, p->partitions[i], group - p->partition_groups[i], results);
+    }
+    return false;
+}
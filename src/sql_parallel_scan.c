@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_parallel_scan.h"
+#include "a-memory-library/aml_buffer.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/*
+    Morsel-driven parallel scan with work stealing.
+
+        SELECT id, LOWER(name) FROM t WHERE LOWER(name) LIKE '%a%'
+
+    The rows are split into morsels and each worker starts with an equal run
+    of consecutive morsels, which it scans from the front.  A worker which
+    runs out steals the back half of the remaining morsels of another
+    worker, so workers which get cheap rows (few matches, short strings) take
+    over the work of slower ones and all of them finish at about the same
+    time.  Every worker evaluates the shared plan with an exec context of its
+    own, resetting it after each morsel.
+
+    Ordered, each worker collects the matches of a morsel and hands them to a
+    reorder buffer.  The worker which completes the next morsel to report
+    reports it, along with any later morsels already completed, one at a time
+    under a lock.  Only morsels completed ahead of the next one to report are
+    held, and their match buffers are reused once reported.
+*/
+
+#define SQL_SCAN_MORSEL_SIZE 16384
+
+typedef struct sql_scan_s sql_scan_t;
+
+typedef struct {
+    sql_scan_t *scan;
+    sql_exec_t *exec;
+    aml_buffer_t *matches;     // of the morsel being scanned (ordered)
+
+    pthread_mutex_t lock;      // of next and end, the morsels not claimed yet
+    size_t next;
+    size_t end;
+} sql_scan_worker_t;
+
+struct sql_scan_s {
+    aml_pool_t *pool;
+    sql_scan_worker_t *workers;
+    size_t num_workers;
+
+    sql_row_source_cb source;
+    void *source_arg;
+    size_t num_rows;
+    size_t morsel_size;
+    size_t num_morsels;
+    sql_scan_match_cb match;
+    void *match_arg;
+
+    atomic_bool stopped;
+    atomic_bool failed;
+
+    // the reorder buffer (ordered)
+    pthread_mutex_t order_lock;
+    size_t next_report;
+    aml_buffer_t **completed;  // matches of each morsel completed before it could be reported
+    aml_buffer_t **spare;      // buffers which have been reported
+    size_t num_spare;
+};
+
+static bool claim(sql_scan_worker_t *w, size_t *morsel) {
+    pthread_mutex_lock(&w->lock);
+    bool claimed = w->next < w->end;
+    if (claimed)
+        *morsel = w->next++;
+    pthread_mutex_unlock(&w->lock);
+    return claimed;
+}
+
+// takes the back half of the morsels another worker hasn't claimed (one lock is held at a time)
+static bool steal(sql_scan_worker_t *w) {
+    sql_scan_t *s = w->scan;
+    for (size_t i = 1; i < s->num_workers; i++) {
+        sql_scan_worker_t *victim = s->workers + (w - s->workers + i) % s->num_workers;
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->next;
+        size_t end = victim->end;
+        victim->end -= (remaining + 1) / 2;
+        pthread_mutex_unlock(&victim->lock);
+        if (!remaining)
+            continue;
+        pthread_mutex_lock(&w->lock);
+        w->next = end - (remaining + 1) / 2;
+        w->end = end;
+        pthread_mutex_unlock(&w->lock);
+        return true;
+    }
+    return false;
+}
+
+static bool next_morsel(sql_scan_worker_t *w, size_t *morsel) {
+    while (!claim(w, morsel)) {
+        if (!steal(w))
+            return false;
+    }
+    return true;
+}
+
+// reports the matches of a morsel on w's exec context (called with order_lock held)
+static bool report(sql_scan_worker_t *w, aml_buffer_t *matches) {
+    sql_scan_t *s = w->scan;
+    size_t *rows = (size_t *)aml_buffer_data(matches);
+    size_t num_rows = aml_buffer_length(matches) / sizeof(size_t);
+    for (size_t i = 0; i < num_rows && !atomic_load(&s->stopped); i++) {
+        sql_ctx_set_row(sql_exec_ctx(w->exec), s->source(s->source_arg, rows[i]));
+        if (!s->match(s->match_arg, w->exec, rows[i]))
+            atomic_store(&s->stopped, true);
+    }
+    aml_buffer_clear(matches);
+    return !atomic_load(&s->stopped);
+}
+
+static void complete_morsel(sql_scan_worker_t *w, size_t morsel) {
+    sql_scan_t *s = w->scan;
+    pthread_mutex_lock(&s->order_lock);
+    if (morsel != s->next_report) {
+        // held until the morsels before it are reported, the worker continues with a spare buffer
+        s->completed[morsel] = w->matches;
+        w->matches = s->num_spare ? s->spare[--s->num_spare] : aml_buffer_init(256);
+    } else if (report(w, w->matches)) {
+        s->next_report++;
+        while (s->next_report < s->num_morsels && s->completed[s->next_report]) {
+            aml_buffer_t *matches = s->completed[s->next_report];
+            s->completed[s->next_report] = NULL;
+            s->spare[s->num_spare++] = matches;
+            if (!report(w, matches))
+                break;
+            s->next_report++;
+        }
+    }
+    pthread_mutex_unlock(&s->order_lock);
+}
+
+static void *scan_morsels(void *arg) {
+    sql_scan_worker_t *w = (sql_scan_worker_t *)arg;
+    sql_scan_t *s = w->scan;
+    size_t morsel;
+    while (!atomic_load(&s->stopped) && next_morsel(w, &morsel)) {
+        size_t start = morsel * s->morsel_size;
+        size_t end = s->num_rows - start > s->morsel_size ? start + s->morsel_size : s->num_rows;
+        for (size_t i = start; i < end; i++) {
+            if (!sql_exec_matches(w->exec, s->source(s->source_arg, i)))
+                continue;
+            if (w->matches)
+                aml_buffer_append(w->matches, &i, sizeof(size_t));
+            else if (!s->match(s->match_arg, w->exec, i)) {
+                atomic_store(&s->stopped, true);
+                break;
+            }
+        }
+        if (sql_exec_ctx(w->exec)->errors) {
+            // the errors stay on the exec context until the scan is done
+            atomic_store(&s->failed, true);
+            atomic_store(&s->stopped, true);
+            break;
+        }
+        if (w->matches)
+            complete_morsel(w, morsel);
+        sql_exec_reset(w->exec);
+    }
+    return NULL;
+}
+
+// runs scan_morsels for every worker, the first on the calling thread (or all of them if threads
+// can't be created)
+static void run_workers(sql_scan_t *s) {
+    pthread_t *threads = (pthread_t *)aml_pool_alloc(s->pool, s->num_workers * sizeof(pthread_t));
+    bool *started = (bool *)aml_pool_zalloc(s->pool, s->num_workers * sizeof(bool));
+    for (size_t i = 1; i < s->num_workers; i++)
+        started[i] = pthread_create(threads + i, NULL, scan_morsels, s->workers + i) == 0;
+    scan_morsels(s->workers);
+    for (size_t i = 1; i < s->num_workers; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            scan_morsels(s->workers + i);
+    }
+}
+
+static void copy_errors(sql_ctx_t *ctx, sql_ctx_t *from) {
+    size_t num_errors = 0;
+    char **errors = sql_ctx_get_errors(from, &num_errors);
+    for (size_t i = 0; i < num_errors; i++)
+        sql_ctx_error(ctx, "%s", errors[i]);
+}
+
+bool sql_parallel_scan(sql_ctx_t *ctx, sql_plan_t *plan, sql_row_source_cb source, void *source_arg,
+                       size_t num_rows, sql_scan_match_cb match, void *match_arg,
+                       sql_parallel_scan_options_t *options) {
+    size_t num_threads = options ? options->num_threads : 0;
+    size_t morsel_size = options && options->morsel_size ? options->morsel_size : SQL_SCAN_MORSEL_SIZE;
+    bool ordered = options && options->ordered;
+    if (!num_threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (size_t)online : 1;
+    }
+    size_t num_morsels = (num_rows + morsel_size - 1) / morsel_size;
+    if (num_threads > num_morsels)
+        num_threads = num_morsels ? num_morsels : 1;
+
+    aml_pool_t *pool = aml_pool_init(4096);
+    sql_scan_t *s = (sql_scan_t *)aml_pool_zalloc(pool, sizeof(sql_scan_t));
+    s->pool = pool;
+    s->source = source;
+    s->source_arg = source_arg;
+    s->num_rows = num_rows;
+    s->morsel_size = morsel_size;
+    s->num_morsels = num_morsels;
+    s->match = match;
+    s->match_arg = match_arg;
+    atomic_init(&s->stopped, false);
+    atomic_init(&s->failed, false);
+    pthread_mutex_init(&s->order_lock, NULL);
+    if (ordered) {
+        s->completed = (aml_buffer_t **)aml_pool_zalloc(pool, (num_morsels + 1) * sizeof(aml_buffer_t *));
+        s->spare = (aml_buffer_t **)aml_pool_zalloc(pool, (num_morsels + 1) * sizeof(aml_buffer_t *));
+    }
+
+    // each worker starts with an equal run of consecutive morsels
+    s->num_workers = num_threads;
+    s->workers = (sql_scan_worker_t *)aml_pool_zalloc(pool, num_threads * sizeof(sql_scan_worker_t));
+    for (size_t i = 0; i < num_threads; i++) {
+        sql_scan_worker_t *w = s->workers + i;
+        w->scan = s;
+        w->exec = sql_exec_init(plan);
+        w->matches = ordered ? aml_buffer_init(256) : NULL;
+        pthread_mutex_init(&w->lock, NULL);
+        w->next = num_morsels * i / num_threads;
+        w->end = num_morsels * (i + 1) / num_threads;
+    }
+
+    run_workers(s);
+
+    bool failed = atomic_load(&s->failed);
+    for (size_t i = 0; i < num_threads; i++) {
+        sql_scan_worker_t *w = s->workers + i;
+        if (failed)
+            copy_errors(ctx, sql_exec_ctx(w->exec));
+        sql_exec_destroy(w->exec);
+        if (w->matches)
+            aml_buffer_destroy(w->matches);
+        pthread_mutex_destroy(&w->lock);
+    }
+    for (size_t i = 0; ordered && i < num_morsels; i++) {
+        if (s->completed[i])
+            aml_buffer_destroy(s->completed[i]);
+    }
+    for (size_t i = 0; i < s->num_spare; i++)
+        aml_buffer_destroy(s->spare[i]);
+    pthread_mutex_destroy(&s->order_lock);
+    aml_pool_destroy(pool);
+    return !failed;
+}
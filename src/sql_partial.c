@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_partial.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+    Partial evaluation for partition pruning.
+
+        tenant_id = 7 AND region IN ('eu', 'us') AND amount > 100
+
+    with tenant_id = 7 and region = 'ap' bound becomes FALSE (skip the
+    partition), with tenant_id = 7 and region = 'eu' it becomes amount > 100.
+
+    The bound columns are replaced by literals in a copy of the tree, and the
+    optimizer folds everything that now only depends on literals.  ctx->row is
+    cleared while optimizing, as fold_constant_expressions would otherwise
+    read the unbound columns from it.
+
+    The AND / OR specs return NULL when any term is NULL, so the standard
+    folds of simplify_booleans (AND(FALSE, x) to FALSE and OR(TRUE, x) to
+    TRUE at any depth) would change the result of (tenant_id = 7 OR amount >
+    100) IS NULL for a NULL amount.  simplify_filter_booleans is used
+    instead: it only folds an AND with a FALSE term where a NULL result also
+    rejects the row (the top of the filter, or a term of an AND which is
+    there), and otherwise keeps the literal terms, so the residual gives
+    the same result as where for every row.
+*/
+
+static sql_column_binding_t *find_binding(sql_column_binding_t *bindings, size_t num_bindings,
+                                          const char *name) {
+    for (size_t i = 0; i < num_bindings; i++) {
+        if (bindings[i].name && !strcasecmp(bindings[i].name, name))
+            return bindings + i;
+    }
+    return NULL;
+}
+
+static sql_node_t *bound_value(sql_ctx_t *ctx, sql_node_t *column, sql_node_t *value) {
+    if (value->is_null) {
+        switch (column->data_type) {
+            case SQL_TYPE_INT:
+                return sql_int_init(ctx, 0, true);
+            case SQL_TYPE_DOUBLE:
+                return sql_double_init(ctx, 0, true);
+            case SQL_TYPE_STRING:
+                return sql_string_init(ctx, NULL, true);
+            case SQL_TYPE_DATETIME:
+                return sql_datetime_init(ctx, 0, true);
+            default:
+                return sql_bool_init(ctx, false, true);
+        }
+    }
+    sql_node_t *literal = (sql_node_t *)aml_pool_alloc(ctx->pool, sizeof(sql_node_t));
+    *literal = *value;
+    // a value of another type is converted by the fold_constants pass
+    return sql_convert(ctx, literal, column->data_type);
+}
+
+// copies the tree, the copy doesn't share nodes (share_common_subexpressions runs again)
+static sql_node_t *bind_nodes(sql_ctx_t *ctx, sql_node_t *node,
+                              sql_column_binding_t *bindings, size_t num_bindings) {
+    if (node->token_type == SQL_IDENTIFIER && node->token) {
+        sql_column_binding_t *b = find_binding(bindings, num_bindings, node->token);
+        if (b && b->value)
+            return bound_value(ctx, node, b->value);
+    }
+
+    sql_node_t *copy = (sql_node_t *)aml_pool_alloc(ctx->pool, sizeof(sql_node_t));
+    *copy = *node;
+    copy->memo = NULL;
+    if (node->num_parameters) {
+        copy->parameters = (sql_node_t **)aml_pool_alloc(ctx->pool, node->num_parameters * sizeof(sql_node_t *));
+        for (size_t i = 0; i < node->num_parameters; i++)
+            copy->parameters[i] = bind_nodes(ctx, node->parameters[i], bindings, num_bindings);
+    }
+    return copy;
+}
+
+bool sql_is_bool_literal(sql_node_t *node, bool value) {
+    return node && is_literal(node) && node->data_type == SQL_TYPE_BOOL && !node->is_null &&
+           node->value.bool_value == value;
+}
+
+sql_node_t *sql_partial_eval(sql_ctx_t *ctx, sql_node_t *where,
+                             sql_column_binding_t *bindings, size_t num_bindings) {
+    if (!where)
+        return sql_bool_init(ctx, true, false);
+
+    sql_node_t *residual = bind_nodes(ctx, where, bindings, num_bindings);
+
+    void *row = ctx->row;
+    ctx->row = NULL;
+    sql_optimizer_t *optimizer = sql_optimizer_default(ctx);
+    sql_optimizer_enable_pass(optimizer, "simplify_booleans", false);
+    sql_optimizer_add_pass(optimizer, "simplify_filter_booleans", simplify_filter_booleans);
+    sql_optimize(optimizer, residual);
+    ctx->row = row;
+
+    // the filter only keeps rows where it is TRUE, so NULL can't match either
+    if (is_literal(residual) && residual->token_type != SQL_LIST &&
+        (residual->is_null || residual->data_type == SQL_TYPE_BOOL) &&
+        !sql_is_bool_literal(residual, true))
+        return sql_bool_init(ctx, false, false);
+    return residual;
+}
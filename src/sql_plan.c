@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_plan.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include <stdint.h>
+#include <string.h>
+
+/*
+    A compiled plan shared by several threads.
+
+        SELECT id, LOWER(name) FROM t WHERE LOWER(name) LIKE '%a%' OR LOWER(name) LIKE '%b%'
+
+    Compiling rewrites the trees in place (type conversions, simplify_tree,
+    shared subexpressions), so it's done once, on the caller's ctx, before any
+    thread evaluates.  Once compiled, evaluating a tree only reads it except
+    for the memos of shared subexpressions (LOWER(name) above), which cache a
+    result per row.  Each memo is given an index and every exec context has
+    an array of memos of its own (ctx->memos), so sql_eval caches into the
+    thread's array rather than the node.
+
+    Everything else evaluation writes (results, errors, warnings, the row) is
+    on the exec context's copy of the ctx, whose pool is a scratch pool (see
+    sql_ctx_begin_scratch) which sql_exec_reset clears.  Messages are kept in
+    the exec context's own pool.
+*/
+
+struct sql_plan_s {
+    sql_ctx_t *ctx;
+    sql_node_t *where;
+    sql_select_t *select;
+    size_t num_memos;
+};
+
+struct sql_exec_s {
+    aml_pool_t *pool;
+    sql_plan_t *plan;
+    sql_ctx_t ctx;
+};
+
+// memos start without an index (SIZE_MAX), one reached again through another parent already has it
+static void number_memos(sql_plan_t *plan, sql_node_t *node) {
+    if (!node)
+        return;
+    if (node->memo && node->memo->index == SIZE_MAX)
+        node->memo->index = plan->num_memos++;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        number_memos(plan, node->parameters[i]);
+}
+
+static void number_plan_memos(sql_plan_t *plan) {
+    number_memos(plan, plan->where);
+    if (!plan->select)
+        return;
+    for (size_t i = 0; i < sql_select_num_items(plan->select); i++)
+        number_memos(plan, sql_select_item(plan->select, i));
+    for (size_t i = 0; i < sql_select_num_group_keys(plan->select); i++)
+        number_memos(plan, sql_select_group_key(plan->select, i));
+    for (size_t i = 0; i < sql_select_num_aggregates(plan->select); i++)
+        number_memos(plan, sql_select_aggregate(plan->select, i));
+    number_memos(plan, sql_select_having(plan->select));
+}
+
+sql_plan_t *sql_plan_compile(sql_ctx_t *ctx, sql_ast_node_t *ast) {
+    sql_plan_t *plan = (sql_plan_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_plan_t));
+    plan->ctx = ctx;
+
+    // fold_constant_expressions would read columns from the row
+    void *row = ctx->row;
+    ctx->row = NULL;
+    sql_ast_node_t *where_clause = find_clause(ast, "WHERE");
+    if (where_clause && where_clause->left) {
+        plan->where = convert_ast_to_node(ctx, where_clause->left);
+        if (plan->where) {
+            apply_type_conversions(ctx, plan->where);
+            if (plan->where->data_type != SQL_TYPE_BOOL)
+                sql_ctx_error(ctx, "WHERE must be a boolean expression");
+            else
+                sql_optimize(sql_optimizer_default(ctx), plan->where);
+        }
+    }
+    ctx->row = row;
+    if (find_clause(ast, "SELECT"))
+        plan->select = sql_select_compile(ctx, ast);
+    if (ctx->errors)
+        return NULL;
+
+    number_plan_memos(plan);
+    return plan;
+}
+
+sql_node_t *sql_plan_where(sql_plan_t *plan) {
+    return plan->where;
+}
+
+sql_select_t *sql_plan_select(sql_plan_t *plan) {
+    return plan->select;
+}
+
+sql_exec_t *sql_exec_init(sql_plan_t *plan) {
+    aml_pool_t *pool = aml_pool_init(1024);
+    sql_exec_t *exec = (sql_exec_t *)aml_pool_zalloc(pool, sizeof(sql_exec_t));
+    exec->pool = pool;
+    exec->plan = plan;
+    exec->ctx = *plan->ctx;
+    exec->ctx.pool = aml_pool_init(16384);
+    exec->ctx.plan_pool = pool;
+    exec->ctx.errors = NULL;
+    exec->ctx.warnings = NULL;
+    exec->ctx.row = NULL;
+    exec->ctx.row_id = 0;
+    exec->ctx.memos = plan->num_memos ?
+        (sql_node_memo_t *)aml_pool_zalloc(pool, plan->num_memos * sizeof(sql_node_memo_t)) : NULL;
+    exec->ctx.num_memos = plan->num_memos;
+    return exec;
+}
+
+void sql_exec_destroy(sql_exec_t *exec) {
+    if (!exec)
+        return;
+    aml_pool_destroy(exec->ctx.pool);
+    aml_pool_destroy(exec->pool);
+}
+
+sql_ctx_t *sql_exec_ctx(sql_exec_t *exec) {
+    return &exec->ctx;
+}
+
+bool sql_exec_matches(sql_exec_t *exec, void *row) {
+    sql_ctx_set_row(&exec->ctx, row);
+    if (!exec->plan->where)
+        return true;
+    sql_node_t *result = sql_eval(&exec->ctx, exec->plan->where);
+    return result && !result->is_null && result->value.bool_value;
+}
+
+bool sql_exec_project(sql_exec_t *exec, sql_select_value_t *row) {
+    if (!exec->plan->select) {
+        sql_ctx_error(&exec->ctx, "The plan has no SELECT list");
+        return false;
+    }
+    return sql_select_project(&exec->ctx, exec->plan->select, row);
+}
+
+void sql_exec_reset(sql_exec_t *exec) {
+    sql_ctx_reset_scratch(&exec->ctx);
+}
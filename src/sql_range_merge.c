@@ -0,0 +1,476 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_sargable.h"
+#include "a-memory-library/aml_buffer.h"
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Merges comparison, BETWEEN, and IN predicates on the same column within an
+    AND (or OR) chain into a single range or IN set.
+
+        x > 5 AND x > 10 AND x BETWEEN 0 AND 100  => x BETWEEN 11 AND 100
+        x IN (1, 2, 3) AND x >= 2                 => x IN (2, 3)
+        x < 3 AND x > 7                           => FALSE
+        x < 5 OR x < 10                           => x < 10
+        x < 5 OR x >= 5                           => x IS NOT NULL
+
+    AND / OR return NULL when any input is NULL, so folding a conjunction to
+    FALSE (or a disjunction to IS NOT NULL) only holds where NULL and FALSE are
+    both treated as "no match" - the root of the filter and the terms of an AND
+    at the root.  Elsewhere, and anywhere in a value expression
+    (merge_value_range_predicates), the terms are merged but never folded.
+
+    Bounds must already be literals, so this is expected to run after
+    simplify_func_tree.
+*/
+
+static bool is_range_type(sql_data_type_t type) {
+    return type == SQL_TYPE_INT || type == SQL_TYPE_DOUBLE ||
+           type == SQL_TYPE_STRING || type == SQL_TYPE_DATETIME;
+}
+
+// Comparisons follow the implementations in comparison.c (strings are case-insensitive)
+static int compare_values(sql_data_type_t type, sql_node_t *a, sql_node_t *b) {
+    switch (type) {
+        case SQL_TYPE_INT:
+            return (a->value.int_value > b->value.int_value) - (a->value.int_value < b->value.int_value);
+        case SQL_TYPE_DOUBLE:
+            return (a->value.double_value > b->value.double_value) - (a->value.double_value < b->value.double_value);
+        case SQL_TYPE_DATETIME:
+            return (a->value.epoch > b->value.epoch) - (a->value.epoch < b->value.epoch);
+        default:
+            return strcasecmp(a->value.string_value, b->value.string_value);
+    }
+}
+
+static bool is_bound(sql_node_t *node, sql_data_type_t type) {
+    return node->token_type != SQL_LIST && is_literal(node) && !node->is_null && node->data_type == type;
+}
+
+static bool is_range_column(sql_node_t *node) {
+    return node->token_type == SQL_IDENTIFIER && is_range_type(node->data_type);
+}
+
+static void set_lo(sql_ctx_t *ctx, sql_range_t *r, sql_node_t *value, bool inclusive) {
+    // integers only use inclusive bounds, so x > 5 AND x < 6 is seen as empty
+    if (r->type == SQL_TYPE_INT && !inclusive) {
+        if (value->value.int_value == INT_MAX) {
+            r->empty = true;
+            return;
+        }
+        value = sql_int_init(ctx, value->value.int_value + 1, false);
+        inclusive = true;
+    }
+    r->lo = value;
+    r->lo_inclusive = inclusive;
+}
+
+static void set_hi(sql_ctx_t *ctx, sql_range_t *r, sql_node_t *value, bool inclusive) {
+    if (r->type == SQL_TYPE_INT && !inclusive) {
+        if (value->value.int_value == INT_MIN) {
+            r->empty = true;
+            return;
+        }
+        value = sql_int_init(ctx, value->value.int_value - 1, false);
+        inclusive = true;
+    }
+    r->hi = value;
+    r->hi_inclusive = inclusive;
+}
+
+bool sql_range_init(sql_ctx_t *ctx, sql_node_t *term, sql_range_t *r) {
+    memset(r, 0, sizeof(*r));
+    if (term->token_type != SQL_COMPARISON || !term->func || term->num_parameters < 2)
+        return false;
+
+    const char *op = term->token;
+    sql_node_t **p = term->parameters;
+
+    if (term->num_parameters == 3) {
+        if (strcasecmp(op, "BETWEEN") || !is_range_column(p[0]) ||
+            !is_bound(p[1], p[0]->data_type) || !is_bound(p[2], p[0]->data_type))
+            return false;
+        r->column = p[0];
+        r->type = p[0]->data_type;
+        set_lo(ctx, r, p[1], true);
+        set_hi(ctx, r, p[2], true);
+        return true;
+    }
+
+    if (!strcasecmp(op, "IN")) {
+        sql_node_t *list = p[1];
+        if (!is_range_column(p[0]) || list->token_type != SQL_LIST || !list->num_parameters)
+            return false;
+        for (size_t i = 0; i < list->num_parameters; i++) {
+            if (!is_bound(list->parameters[i], p[0]->data_type))
+                return false;
+        }
+        r->column = p[0];
+        r->type = p[0]->data_type;
+        r->values = list->parameters;
+        r->num_values = list->num_parameters;
+        return true;
+    }
+
+    bool column_first = is_range_column(p[0]);
+    sql_node_t *column = column_first ? p[0] : p[1];
+    sql_node_t *value = column_first ? p[1] : p[0];
+    if (!is_range_column(column) || !is_bound(value, column->data_type))
+        return false;
+
+    r->column = column;
+    r->type = column->data_type;
+    if (!strcmp(op, "=") || !strcmp(op, "==")) {
+        set_lo(ctx, r, value, true);
+        set_hi(ctx, r, value, true);
+    } else if (!strcmp(op, "<") || !strcmp(op, "<=")) {
+        bool inclusive = op[1] == '=';
+        if (column_first)
+            set_hi(ctx, r, value, inclusive);
+        else
+            set_lo(ctx, r, value, inclusive);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool value_in_bounds(sql_range_t *r, sql_node_t *value) {
+    if (r->lo) {
+        int cmp = compare_values(r->type, value, r->lo);
+        if (cmp < 0 || (cmp == 0 && !r->lo_inclusive))
+            return false;
+    }
+    if (r->hi) {
+        int cmp = compare_values(r->type, value, r->hi);
+        if (cmp > 0 || (cmp == 0 && !r->hi_inclusive))
+            return false;
+    }
+    return true;
+}
+
+static bool contains_value(sql_data_type_t type, sql_node_t **values, size_t num_values, sql_node_t *value) {
+    for (size_t i = 0; i < num_values; i++) {
+        if (compare_values(type, values[i], value) == 0)
+            return true;
+    }
+    return false;
+}
+
+void sql_range_intersect(sql_ctx_t *ctx, sql_range_t *r, sql_range_t *s) {
+    r->empty = r->empty || s->empty;
+
+    if (s->lo) {
+        int cmp = r->lo ? compare_values(r->type, s->lo, r->lo) : 1;
+        if (cmp > 0 || (cmp == 0 && !s->lo_inclusive)) {
+            r->lo = s->lo;
+            r->lo_inclusive = s->lo_inclusive;
+        }
+    }
+    if (s->hi) {
+        int cmp = r->hi ? compare_values(r->type, s->hi, r->hi) : -1;
+        if (cmp < 0 || (cmp == 0 && !s->hi_inclusive)) {
+            r->hi = s->hi;
+            r->hi_inclusive = s->hi_inclusive;
+        }
+    }
+
+    if (s->values) {
+        if (!r->values) {
+            r->values = s->values;
+            r->num_values = s->num_values;
+        } else {
+            sql_node_t **values = (sql_node_t **)aml_pool_alloc(ctx->pool, r->num_values * sizeof(sql_node_t *));
+            size_t num_values = 0;
+            for (size_t i = 0; i < r->num_values; i++) {
+                if (contains_value(r->type, s->values, s->num_values, r->values[i]))
+                    values[num_values++] = r->values[i];
+            }
+            r->values = values;
+            r->num_values = num_values;
+        }
+    }
+}
+
+void sql_range_normalize(sql_ctx_t *ctx, sql_range_t *r) {
+    if (r->values) {
+        sql_node_t **values = (sql_node_t **)aml_pool_alloc(ctx->pool, (r->num_values + 1) * sizeof(sql_node_t *));
+        size_t num_values = 0;
+        for (size_t i = 0; i < r->num_values; i++) {
+            if (value_in_bounds(r, r->values[i]) &&
+                !contains_value(r->type, values, num_values, r->values[i]))
+                values[num_values++] = r->values[i];
+        }
+        r->values = values;
+        r->num_values = num_values;
+        r->lo = r->hi = NULL;
+        if (!num_values)
+            r->empty = true;
+    } else if (r->lo && r->hi) {
+        int cmp = compare_values(r->type, r->lo, r->hi);
+        if (cmp > 0 || (cmp == 0 && !(r->lo_inclusive && r->hi_inclusive)))
+            r->empty = true;
+    }
+}
+
+// The number of comparisons range_predicate builds for a range
+static size_t range_size(sql_range_t *r) {
+    if (r->lo && r->hi && !r->values && compare_values(r->type, r->lo, r->hi) != 0 &&
+        !(r->lo_inclusive && r->hi_inclusive))
+        return 2;
+    return 1;
+}
+
+static sql_node_t *bound_init(sql_ctx_t *ctx, sql_range_t *r, const char *op, sql_node_t *value, bool column_first) {
+    sql_node_t *parameters[2];
+    parameters[0] = column_first ? copy_nodes(ctx, r->column) : value;
+    parameters[1] = column_first ? value : copy_nodes(ctx, r->column);
+    return sql_operation_init(ctx, SQL_COMPARISON, op, parameters, 2);
+}
+
+// Builds the predicate for a normalized, non-empty range
+static sql_node_t *range_predicate(sql_ctx_t *ctx, sql_range_t *r) {
+    if (r->values) {
+        if (r->num_values == 1)
+            return bound_init(ctx, r, "=", r->values[0], true);
+
+        sql_node_t *list = sql_list_init(ctx, r->num_values, false);
+        list->data_type = r->type;
+        for (size_t i = 0; i < r->num_values; i++)
+            list->parameters[i] = r->values[i];
+        sql_node_t *parameters[2] = { copy_nodes(ctx, r->column), list };
+        return sql_operation_init(ctx, SQL_COMPARISON, "IN", parameters, 2);
+    }
+
+    if (r->lo && r->hi) {
+        if (compare_values(r->type, r->lo, r->hi) == 0)
+            return bound_init(ctx, r, "=", r->lo, true);
+        if (r->lo_inclusive && r->hi_inclusive) {
+            sql_node_t *parameters[3] = { copy_nodes(ctx, r->column), r->lo, r->hi };
+            return sql_operation_init(ctx, SQL_COMPARISON, "BETWEEN", parameters, 3);
+        }
+    }
+
+    sql_node_t *lo = r->lo ? bound_init(ctx, r, r->lo_inclusive ? "<=" : "<", r->lo, false) : NULL;
+    sql_node_t *hi = r->hi ? bound_init(ctx, r, r->hi_inclusive ? "<=" : "<", r->hi, true) : NULL;
+    if (lo && hi) {
+        sql_node_t *parameters[2] = { lo, hi };
+        return sql_operation_init(ctx, SQL_AND, "AND", parameters, 2);
+    }
+    return lo ? lo : hi;
+}
+
+static int compare_lower_bounds(sql_range_t *a, sql_range_t *b) {
+    if (!a->lo || !b->lo)
+        return (a->lo != NULL) - (b->lo != NULL);
+    int cmp = compare_values(a->type, a->lo, b->lo);
+    if (cmp)
+        return cmp;
+    return (int)b->lo_inclusive - (int)a->lo_inclusive;
+}
+
+// True if the range b starts before the range a ends (or right where it ends)
+static bool ranges_touch(sql_range_t *a, sql_range_t *b) {
+    if (!a->hi || !b->lo)
+        return true;
+    if (a->type == SQL_TYPE_INT)
+        return (long long)b->lo->value.int_value <= (long long)a->hi->value.int_value + 1;
+    int cmp = compare_values(a->type, b->lo, a->hi);
+    return cmp < 0 || (cmp == 0 && (a->hi_inclusive || b->lo_inclusive));
+}
+
+// ranges[0] = ranges[0] OR ... OR ranges[n-1], returns false if the union isn't a single range
+static bool union_ranges(sql_ctx_t *ctx, sql_range_t *ranges, size_t num_ranges) {
+    bool all_sets = true;
+    size_t num_values = 0;
+    for (size_t i = 0; i < num_ranges; i++) {
+        if (ranges[i].empty)
+            return false;
+        if (!ranges[i].values)
+            all_sets = false;
+        num_values += ranges[i].num_values;
+    }
+
+    if (all_sets) {
+        sql_node_t **values = (sql_node_t **)aml_pool_alloc(ctx->pool, num_values * sizeof(sql_node_t *));
+        size_t n = 0;
+        for (size_t i = 0; i < num_ranges; i++) {
+            for (size_t j = 0; j < ranges[i].num_values; j++) {
+                if (!contains_value(ranges[0].type, values, n, ranges[i].values[j]))
+                    values[n++] = ranges[i].values[j];
+            }
+        }
+        ranges[0].values = values;
+        ranges[0].num_values = n;
+        return true;
+    }
+
+    // IN sets take part as a run of single value ranges
+    aml_buffer_t *bh = aml_buffer_pool_init(ctx->pool, sizeof(sql_range_t) * (num_ranges + num_values));
+    for (size_t i = 0; i < num_ranges; i++) {
+        if (!ranges[i].values) {
+            aml_buffer_append(bh, ranges + i, sizeof(sql_range_t));
+            continue;
+        }
+        for (size_t j = 0; j < ranges[i].num_values; j++) {
+            sql_range_t point = ranges[i];
+            point.values = NULL;
+            point.num_values = 0;
+            point.lo = point.hi = ranges[i].values[j];
+            point.lo_inclusive = point.hi_inclusive = true;
+            aml_buffer_append(bh, &point, sizeof(sql_range_t));
+        }
+    }
+    sql_range_t *parts = (sql_range_t *)aml_buffer_data(bh);
+    size_t num_parts = aml_buffer_length(bh) / sizeof(sql_range_t);
+
+    // insertion sort by lower bound (these lists are short)
+    for (size_t i = 1; i < num_parts; i++) {
+        sql_range_t tmp = parts[i];
+        size_t j = i;
+        while (j > 0 && compare_lower_bounds(parts + j - 1, &tmp) > 0) {
+            parts[j] = parts[j - 1];
+            j--;
+        }
+        parts[j] = tmp;
+    }
+
+    sql_range_t merged = parts[0];
+    for (size_t i = 1; i < num_parts; i++) {
+        if (!ranges_touch(&merged, parts + i))
+            return false;
+        if (merged.hi) {
+            int cmp = parts[i].hi ? compare_values(merged.type, parts[i].hi, merged.hi) : 1;
+            if (cmp > 0 || (cmp == 0 && parts[i].hi_inclusive)) {
+                merged.hi = parts[i].hi;
+                merged.hi_inclusive = parts[i].hi_inclusive;
+            }
+        }
+    }
+    ranges[0] = merged;
+    return true;
+}
+
+static void collect_terms(aml_buffer_t *bh, sql_node_t *node, sql_token_type_t token_type) {
+    if (node->token_type == token_type) {
+        for (size_t i = 0; i < node->num_parameters; i++)
+            collect_terms(bh, node->parameters[i], token_type);
+    } else {
+        aml_buffer_append(bh, &node, sizeof(sql_node_t *));
+    }
+}
+
+static size_t merge_node(sql_ctx_t *ctx, sql_node_t *node, bool filter);
+
+static size_t merge_terms(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    bool conjunction = node->token_type == SQL_AND;
+    aml_buffer_t *bh = aml_buffer_pool_init(ctx->pool, sizeof(sql_node_t *) * 8);
+    collect_terms(bh, node, node->token_type);
+    sql_node_t **terms = (sql_node_t **)aml_buffer_data(bh);
+    size_t num_terms = aml_buffer_length(bh) / sizeof(sql_node_t *);
+
+    size_t rewrites = 0;
+    for (size_t i = 0; i < num_terms; i++)
+        rewrites += merge_node(ctx, terms[i], filter && conjunction);
+
+    sql_range_t *ranges = (sql_range_t *)aml_pool_alloc(ctx->pool, num_terms * sizeof(sql_range_t));
+    bool *is_range = (bool *)aml_pool_zalloc(ctx->pool, num_terms * sizeof(bool));
+    for (size_t i = 0; i < num_terms; i++)
+        is_range[i] = sql_range_init(ctx, terms[i], ranges + i);
+
+    sql_node_t **group = (sql_node_t **)aml_pool_alloc(ctx->pool, num_terms * sizeof(sql_node_t *));
+    sql_range_t *group_ranges = (sql_range_t *)aml_pool_alloc(ctx->pool, num_terms * sizeof(sql_range_t));
+    for (size_t i = 0; i < num_terms; i++) {
+        if (!is_range[i])
+            continue;
+
+        // gather the terms on the same column (and type)
+        size_t group_size = 0;
+        for (size_t j = i; j < num_terms; j++) {
+            if (is_range[j] && ranges[j].type == ranges[i].type &&
+                !strcasecmp(ranges[j].column->token, ranges[i].column->token)) {
+                group[group_size] = terms[j];
+                group_ranges[group_size++] = ranges[j];
+                is_range[j] = false;
+            }
+        }
+
+        sql_range_t merged = group_ranges[0];
+        if (conjunction) {
+            for (size_t j = 1; j < group_size; j++)
+                sql_range_intersect(ctx, &merged, group_ranges + j);
+            sql_range_normalize(ctx, &merged);
+            if (merged.empty) {
+                if (filter) {
+                    *node = *sql_bool_init(ctx, false, false);
+                    return rewrites + 1;
+                }
+                continue;
+            }
+        } else {
+            for (size_t j = 0; j < group_size; j++)
+                sql_range_normalize(ctx, group_ranges + j);
+            if (group_size < 2 || !union_ranges(ctx, group_ranges, group_size))
+                continue;
+            merged = group_ranges[0];
+        }
+
+        // nothing to gain unless the group shrinks (this also keeps the pass stable)
+        if (group_size <= range_size(&merged))
+            continue;
+
+        sql_node_t *replacement = NULL;
+        if (!merged.lo && !merged.hi && !merged.values) {
+            // the terms cover every value, only a NULL column fails them
+            if (!filter || group_size != num_terms)
+                continue;
+            sql_node_t *parameters[1] = { copy_nodes(ctx, merged.column) };
+            replacement = sql_operation_init(ctx, SQL_COMPARISON, "IS NOT NULL", parameters, 1);
+        } else {
+            replacement = range_predicate(ctx, &merged);
+        }
+        if (!replacement)
+            continue;
+
+        *group[0] = *replacement;
+        for (size_t j = 1; j < group_size; j++)
+            *group[j] = *sql_bool_init(ctx, conjunction, false);
+        rewrites++;
+    }
+    return rewrites;
+}
+
+static size_t merge_node(sql_ctx_t *ctx, sql_node_t *node, bool filter) {
+    if (!node)
+        return 0;
+
+    if (node->token_type == SQL_AND || node->token_type == SQL_OR)
+        return merge_terms(ctx, node, filter);
+
+    size_t rewrites = 0;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        rewrites += merge_node(ctx, node->parameters[i], false);
+
+    // a single impossible predicate (x BETWEEN 10 AND 1) at the top of the filter
+    sql_range_t r;
+    if (filter && sql_range_init(ctx, node, &r)) {
+        sql_range_normalize(ctx, &r);
+        if (r.empty) {
+            *node = *sql_bool_init(ctx, false, false);
+            rewrites++;
+        }
+    }
+    return rewrites;
+}
+
+size_t merge_range_predicates(sql_ctx_t *ctx, sql_node_t *node) {
+    return merge_node(ctx, node, true);
+}
+
+size_t merge_value_range_predicates(sql_ctx_t *ctx, sql_node_t *node) {
+    return merge_node(ctx, node, false);
+}
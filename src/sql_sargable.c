@@ -0,0 +1,265 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_sargable.h"
+#include "sql-parser-library/date_utils.h"
+#include "a-memory-library/aml_buffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Splits a filter into what a storage layer can use to find rows and what
+    must still be evaluated per row.
+
+        id BETWEEN 10 AND 20 AND name LIKE 'ab%' AND LENGTH(name) > 3
+
+    becomes
+
+        id       [10, 20]
+        name     prefix 'ab'
+        residual LENGTH(name) > 3
+
+    Only the terms of the top level AND are used, as a term anywhere else
+    doesn't have to hold for every matching row.  A term is dropped from the
+    residual only when its constraint describes it exactly (LIKE 'ab%c' adds
+    the prefix 'ab' but stays in the residual).
+*/
+
+static void collect_terms(aml_buffer_t *bh, sql_node_t *node) {
+    if (node->token_type == SQL_AND) {
+        for (size_t i = 0; i < node->num_parameters; i++)
+            collect_terms(bh, node->parameters[i]);
+        return;
+    }
+    aml_buffer_append(bh, &node, sizeof(node));
+}
+
+static sql_column_constraint_t *get_constraint(sql_sargable_t *s, sql_node_t *column) {
+    sql_column_constraint_t *c = sql_sargable_column(s, column->token);
+    if (c)
+        return c;
+    c = s->columns + s->num_columns++;
+    c->name = column->token;
+    c->type = column->data_type;
+    return c;
+}
+
+static bool is_string_literal(sql_node_t *node) {
+    return is_literal(node) && node->token_type != SQL_LIST && !node->is_null &&
+           node->data_type == SQL_TYPE_STRING && node->value.string_value;
+}
+
+// LIKE treats '%', '_', and ' ' as wildcards (see like.c)
+static bool is_wildcard(char ch) {
+    return ch == '%' || ch == '_' || ch == ' ';
+}
+
+static void add_prefix(sql_column_constraint_t *c, const char *prefix, size_t length) {
+    if (!c->prefix) {
+        c->prefix = prefix;
+        return;
+    }
+    size_t current = strlen(c->prefix);
+    if (strncasecmp(c->prefix, prefix, current < length ? current : length))
+        c->empty = true;
+    else if (length > current)
+        c->prefix = prefix;
+}
+
+// Returns true if the LIKE is fully described by the constraint
+static bool like_constraint(sql_ctx_t *ctx, sql_sargable_t *s, sql_node_t *term) {
+    sql_node_t *column = term->parameters[0];
+    sql_node_t *pattern = term->parameters[1];
+    if (column->token_type != SQL_IDENTIFIER || !is_string_literal(pattern))
+        return false;
+
+    const char *p = pattern->value.string_value;
+    size_t length = 0;
+    while (p[length] && !is_wildcard(p[length]))
+        length++;
+    if (!length)
+        return false;
+
+    sql_column_constraint_t *c = get_constraint(s, column);
+    c->is_not_null = true;
+    if (!p[length]) {
+        // no wildcards, LIKE 'abc' is the same as = 'abc' (both ignore case)
+        sql_range_t r;
+        memset(&r, 0, sizeof(r));
+        r.column = column;
+        r.type = SQL_TYPE_STRING;
+        r.lo = r.hi = pattern;
+        r.lo_inclusive = r.hi_inclusive = true;
+        if (c->has_range)
+            sql_range_intersect(ctx, &c->range, &r);
+        else
+            c->range = r;
+        c->has_range = true;
+        return true;
+    }
+
+    add_prefix(c, aml_pool_strndup(ctx->pool, p, length), length);
+    const char *rest = p + length;
+    while (*rest == '%' || *rest == ' ')
+        rest++;
+    return *rest == '\0';
+}
+
+// Returns true if the term is fully described by the constraints
+static bool add_term(sql_ctx_t *ctx, sql_sargable_t *s, sql_node_t *term) {
+    if (is_literal(term) && term->data_type == SQL_TYPE_BOOL) {
+        if (term->is_null || !term->value.bool_value)
+            s->always_false = true;
+        return true;
+    }
+
+    sql_range_t r;
+    if (sql_range_init(ctx, term, &r)) {
+        sql_column_constraint_t *c = get_constraint(s, r.column);
+        if (c->has_range)
+            sql_range_intersect(ctx, &c->range, &r);
+        else
+            c->range = r;
+        c->has_range = true;
+        c->is_not_null = true;
+        return true;
+    }
+
+    if (term->token_type != SQL_COMPARISON || !term->spec || !term->num_parameters)
+        return false;
+
+    const char *name = term->spec->name;
+    sql_node_t *column = term->parameters[0];
+    if (!strcasecmp(name, "LIKE") && term->num_parameters == 2)
+        return like_constraint(ctx, s, term);
+
+    if (column->token_type != SQL_IDENTIFIER || term->num_parameters != 1)
+        return false;
+    if (!strcasecmp(name, "IS NULL")) {
+        get_constraint(s, column)->is_null = true;
+        return true;
+    }
+    if (!strcasecmp(name, "IS NOT NULL")) {
+        get_constraint(s, column)->is_not_null = true;
+        return true;
+    }
+    return false;
+}
+
+sql_column_constraint_t *sql_sargable_column(sql_sargable_t *s, const char *name) {
+    for (size_t i = 0; i < s->num_columns; i++) {
+        if (!strcasecmp(s->columns[i].name, name))
+            return s->columns + i;
+    }
+    return NULL;
+}
+
+sql_sargable_t *sql_extract_sargable(sql_ctx_t *ctx, sql_node_t *where) {
+    sql_sargable_t *s = (sql_sargable_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_sargable_t));
+    if (!where) {
+        s->residual = sql_bool_init(ctx, true, false);
+        return s;
+    }
+
+    aml_buffer_t *bh = aml_buffer_pool_init(ctx->pool, 16 * sizeof(sql_node_t *));
+    collect_terms(bh, where);
+    sql_node_t **terms = (sql_node_t **)aml_buffer_data(bh);
+    size_t num_terms = aml_buffer_length(bh) / sizeof(sql_node_t *);
+
+    s->columns = (sql_column_constraint_t *)aml_pool_zalloc(ctx->pool, num_terms * sizeof(sql_column_constraint_t));
+    sql_node_t **residual = (sql_node_t **)aml_pool_alloc(ctx->pool, num_terms * sizeof(sql_node_t *));
+    size_t num_residual = 0;
+    for (size_t i = 0; i < num_terms; i++) {
+        if (!add_term(ctx, s, terms[i]))
+            residual[num_residual++] = terms[i];
+    }
+
+    for (size_t i = 0; i < s->num_columns; i++) {
+        sql_column_constraint_t *c = s->columns + i;
+        if (c->has_range) {
+            sql_range_normalize(ctx, &c->range);
+            if (c->range.empty)
+                c->empty = true;
+        }
+        if (c->is_null && c->is_not_null)
+            c->empty = true;
+        if (c->empty)
+            s->always_false = true;
+    }
+
+    if (!num_residual)
+        s->residual = sql_bool_init(ctx, true, false);
+    else if (num_residual == 1)
+        s->residual = residual[0];
+    else
+        s->residual = sql_operation_init(ctx, SQL_AND, "AND", residual, num_residual);
+    if (!s->residual)
+        s->residual = where;
+    return s;
+}
+
+static void print_value(sql_ctx_t *ctx, sql_node_t *node) {
+    switch (node->data_type) {
+        case SQL_TYPE_INT:
+            printf("%d", node->value.int_value);
+            break;
+        case SQL_TYPE_DOUBLE:
+            printf("%g", node->value.double_value);
+            break;
+        case SQL_TYPE_DATETIME:
+            printf("%s", convert_epoch_to_iso_utc(ctx->pool, node->value.epoch));
+            break;
+        case SQL_TYPE_STRING:
+            printf("'%s'", node->value.string_value);
+            break;
+        default:
+            printf("%s", node->token);
+            break;
+    }
+}
+
+void sql_print_sargable(sql_ctx_t *ctx, sql_sargable_t *s) {
+    if (s->always_false)
+        printf("always false\n");
+    for (size_t i = 0; i < s->num_columns; i++) {
+        sql_column_constraint_t *c = s->columns + i;
+        printf("  %s:", c->name);
+        if (c->empty)
+            printf(" empty");
+        if (c->is_null)
+            printf(" IS NULL");
+        else if (c->is_not_null)
+            printf(" IS NOT NULL");
+        if (c->has_range && !c->range.empty) {
+            sql_range_t *r = &c->range;
+            if (r->values) {
+                printf(" IN (");
+                for (size_t j = 0; j < r->num_values; j++) {
+                    if (j)
+                        printf(", ");
+                    print_value(ctx, r->values[j]);
+                }
+                printf(")");
+            } else if (r->lo || r->hi) {
+                printf(" %s", r->lo_inclusive ? "[" : "(");
+                if (r->lo)
+                    print_value(ctx, r->lo);
+                else
+                    printf("-inf");
+                printf(", ");
+                if (r->hi)
+                    print_value(ctx, r->hi);
+                else
+                    printf("inf");
+                printf("%s", r->hi_inclusive ? "]" : ")");
+            }
+        }
+        if (c->prefix)
+            printf(" prefix '%s'", c->prefix);
+        printf("\n");
+    }
+    printf("  residual:\n");
+    print_node(ctx, s->residual, 2);
+}
@@ -0,0 +1,439 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_select.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Aggregation over a stream of rows.
+
+        SELECT COUNT(*), AVG(price), MAX(price) - MIN(price) FROM t WHERE ...
+
+    Each aggregate call is moved out of its item into a slot and replaced by a
+    node which returns the slot's result.  The caller owns the accumulator
+    states (one block for all of the slots), accumulates each matching row
+    into it, and finalizes once the scan is done, which fills in the slot
+    results and then evaluates the items.  States built from different parts
+    of the input are combined with sql_select_merge.
+
+        SELECT LOWER(name), COUNT(*) FROM t GROUP BY LOWER(name) HAVING COUNT(*) > 1
+
+    With GROUP BY, a subtree of an item or HAVING which is the same as one of
+    the keys is replaced by a node returning the key of the group being
+    finalized (see sql_group_by.h for the hash table of groups), so LOWER(name)
+    above isn't treated as a column outside of an aggregate.
+
+    The items aren't given share_subexpressions, a memo is keyed by the row
+    and would return a stale result when a state is finalized again without
+    the row changing.
+
+        SELECT id, LOWER(name), num_bytes / 1024 AS kb FROM t WHERE ...
+
+    A query without aggregates is projected row by row: sql_select_project
+    evaluates each item for the current row into a typed output row.  The
+    columns are only read by evaluating the items, so a column nothing uses
+    is never fetched, and a column used by several items is a single node
+    with a memo, so it is fetched once per row.
+*/
+
+typedef struct {
+    sql_node_t *call;                // parameters are evaluated for each row
+    sql_ctx_aggregate_t *aggregate;
+    size_t offset;                   // of the accumulator within the state
+    sql_node_t *result;              // set by sql_select_finalize
+} sql_select_slot_t;
+
+typedef struct {
+    sql_node_t *expr;                // evaluated for each row
+    sql_node_t *result;              // the key of the group being finalized
+} sql_select_key_t;
+
+struct sql_select_s {
+    sql_node_t **items;
+    const char **names;
+    size_t num_items;
+
+    sql_select_key_t *keys;
+    size_t num_keys;
+    sql_node_t *having;
+
+    sql_select_slot_t *slots;
+    size_t num_slots;
+    size_t state_size;
+};
+
+static bool is_aggregate_call(sql_node_t *node) {
+    return node->token_type == SQL_FUNCTION && node->func && node->spec && node->spec->aggregate &&
+           node->num_parameters == node->spec->aggregate->num_parameters;
+}
+
+static size_t count_aggregates(sql_node_t *node) {
+    if (is_aggregate_call(node))
+        return 1;
+    size_t count = 0;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        count += count_aggregates(node->parameters[i]);
+    return count;
+}
+
+// the node which replaces an aggregate call in its item (value.custom is the slot)
+static sql_node_t *slot_result(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_select_slot_t *slot = (sql_select_slot_t *)f->value.custom;
+    return slot->result;
+}
+
+// the node which replaces a GROUP BY key in an item (value.custom is the key)
+static sql_node_t *key_result(sql_ctx_t *ctx, sql_node_t *f) {
+    sql_select_key_t *key = (sql_select_key_t *)f->value.custom;
+    return key->result;
+}
+
+static size_t align_state(size_t size) {
+    size_t alignment = _Alignof(max_align_t);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static sql_node_t *extract_aggregates(sql_ctx_t *ctx, sql_select_t *select, sql_node_t *node) {
+    if (!is_aggregate_call(node)) {
+        for (size_t i = 0; i < node->num_parameters; i++)
+            node->parameters[i] = extract_aggregates(ctx, select, node->parameters[i]);
+        return node;
+    }
+
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        if (count_aggregates(node->parameters[i])) {
+            sql_ctx_error(ctx, "Aggregate functions can't be nested (%s)", node->token);
+            return node;
+        }
+        sql_optimize(sql_optimizer_value(ctx), node->parameters[i]);
+    }
+
+    sql_select_slot_t *slot = select->slots + select->num_slots++;
+    slot->call = node;
+    slot->aggregate = node->spec->aggregate;
+    slot->offset = select->state_size;
+    select->state_size += align_state(slot->aggregate->state_size);
+
+    sql_node_t *result = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
+    result->token_type = SQL_FUNCTION;
+    result->type = SQL_FUNCTION;
+    result->token = node->token;
+    result->data_type = node->data_type;
+    result->func = slot_result;
+    result->value.custom = slot;
+    return result;
+}
+
+static sql_node_t *replace_keys(sql_ctx_t *ctx, sql_select_t *select, sql_node_t *node) {
+    for (size_t i = 0; i < select->num_keys; i++) {
+        if (!sql_same_expression(node, select->keys[i].expr))
+            continue;
+        sql_node_t *result = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
+        result->token_type = SQL_FUNCTION;
+        result->type = SQL_FUNCTION;
+        result->token = node->token;
+        result->data_type = node->data_type;
+        result->func = key_result;
+        result->value.custom = select->keys + i;
+        return result;
+    }
+    for (size_t i = 0; i < node->num_parameters; i++)
+        node->parameters[i] = replace_keys(ctx, select, node->parameters[i]);
+    return node;
+}
+
+// '*' is only a parameter of COUNT(*), columns have to be inside an aggregate (or a GROUP BY key)
+// when there are any
+static void check_item(sql_ctx_t *ctx, sql_select_t *select, sql_node_t *node, sql_node_t *parent) {
+    if (node->token_type == SQL_STAR &&
+        (!parent || !parent->spec || strcasecmp(parent->spec->name, "COUNT"))) {
+        sql_ctx_error(ctx, "'*' can only be used as COUNT(*)");
+        return;
+    }
+    if (node->token_type == SQL_IDENTIFIER && node->func && (select->num_slots || select->num_keys)) {
+        if (select->num_keys)
+            sql_ctx_error(ctx, "Column '%s' must be in GROUP BY or used in an aggregate function", node->token);
+        else
+            sql_ctx_error(ctx, "Column '%s' must be used in an aggregate function", node->token);
+        return;
+    }
+    for (size_t i = 0; i < node->num_parameters; i++)
+        check_item(ctx, select, node->parameters[i], node);
+}
+
+static sql_node_t *column_node(sql_ctx_t *ctx, sql_ctx_column_t *column) {
+    sql_node_t *node = (sql_node_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_node_t));
+    node->token_type = SQL_IDENTIFIER;
+    node->type = SQL_IDENTIFIER;
+    node->token = aml_pool_strdup(ctx->pool, column->name);
+    node->data_type = column->type;
+    node->func = column->func;
+    node->value.custom = column;
+    return node;
+}
+
+static const char *item_name(sql_ast_node_t *item) {
+    if (item->type == SQL_KEYWORD && item->right)
+        return item->right->value;  // AS alias
+    if ((item->type == SQL_IDENTIFIER || item->type == SQL_FUNCTION) && item->value)
+        return item->value;
+    return "?column?";
+}
+
+// makes every use of a column the node of its first use, so it is read once per row
+static void share_column_nodes(sql_ctx_t *ctx, sql_node_t **node, sql_node_t **columns, size_t *num_columns) {
+    sql_node_t *n = *node;
+    if (n->token_type == SQL_IDENTIFIER && n->func) {
+        for (size_t i = 0; i < *num_columns; i++) {
+            if (columns[i] == n || strcasecmp(columns[i]->token, n->token))
+                continue;
+            if (!columns[i]->memo)
+                columns[i]->memo = sql_memo_init(ctx);
+            *node = columns[i];
+            return;
+        }
+        if (*num_columns < ctx->column_count)
+            columns[(*num_columns)++] = n;
+        return;
+    }
+    for (size_t i = 0; i < n->num_parameters; i++)
+        share_column_nodes(ctx, n->parameters + i, columns, num_columns);
+}
+
+sql_select_t *sql_select_compile(sql_ctx_t *ctx, sql_ast_node_t *ast) {
+    sql_ast_node_t *select_clause = find_clause(ast, "SELECT");
+    if (!select_clause || !select_clause->left) {
+        sql_ctx_error(ctx, "Missing SELECT list");
+        return NULL;
+    }
+
+    size_t num_items = 0;
+    for (sql_ast_node_t *item = select_clause->left; item; item = item->next)
+        num_items += item->type == SQL_STAR ? ctx->column_count : 1;
+
+    sql_select_t *select = (sql_select_t *)aml_pool_zalloc(ctx->pool, sizeof(sql_select_t));
+    select->items = (sql_node_t **)aml_pool_alloc(ctx->pool, num_items * sizeof(sql_node_t *));
+    select->names = (const char **)aml_pool_alloc(ctx->pool, num_items * sizeof(const char *));
+    for (sql_ast_node_t *item = select_clause->left; item; item = item->next) {
+        if (item->type == SQL_STAR) {
+            for (size_t i = 0; i < ctx->column_count; i++) {
+                select->names[select->num_items] = ctx->columns[i].name;
+                select->items[select->num_items++] = column_node(ctx, ctx->columns + i);
+            }
+            continue;
+        }
+        select->names[select->num_items] = item_name(item);
+        sql_node_t *node = convert_ast_to_node(ctx, item->type == SQL_KEYWORD ? item->left : item);
+        apply_type_conversions(ctx, node);
+        select->items[select->num_items++] = node;
+    }
+
+    sql_ast_node_t *group_clause = find_clause(ast, "GROUP BY");
+    if (group_clause) {
+        for (sql_ast_node_t *key = group_clause->left; key; key = key->next)
+            select->num_keys++;
+        select->keys = (sql_select_key_t *)aml_pool_zalloc(ctx->pool, select->num_keys * sizeof(sql_select_key_t));
+        size_t i = 0;
+        for (sql_ast_node_t *key = group_clause->left; key; key = key->next, i++) {
+            select->keys[i].expr = convert_ast_to_node(ctx, key);
+            apply_type_conversions(ctx, select->keys[i].expr);
+        }
+    }
+
+    sql_ast_node_t *having_clause = find_clause(ast, "HAVING");
+    if (having_clause && having_clause->left) {
+        select->having = convert_ast_to_node(ctx, having_clause->left);
+        apply_type_conversions(ctx, select->having);
+        if (select->having->data_type != SQL_TYPE_BOOL)
+            sql_ctx_error(ctx, "HAVING must be a boolean expression");
+    }
+    if (ctx->errors)
+        return NULL;
+
+    size_t num_slots = select->having ? count_aggregates(select->having) : 0;
+    for (size_t i = 0; i < select->num_items; i++)
+        num_slots += count_aggregates(select->items[i]);
+    if (num_slots)
+        select->slots = (sql_select_slot_t *)aml_pool_zalloc(ctx->pool, num_slots * sizeof(sql_select_slot_t));
+
+    // fold_constant_expressions would read columns from the row
+    void *row = ctx->row;
+    ctx->row = NULL;
+    for (size_t i = 0; i < select->num_keys; i++) {
+        if (count_aggregates(select->keys[i].expr))
+            sql_ctx_error(ctx, "Aggregate functions are not allowed in GROUP BY");
+        else if (select->keys[i].expr->token_type == SQL_STAR)
+            sql_ctx_error(ctx, "'*' can't be used in GROUP BY");
+    }
+    for (size_t i = 0; i < select->num_items; i++) {
+        select->items[i] = extract_aggregates(ctx, select, select->items[i]);
+        select->items[i] = replace_keys(ctx, select, select->items[i]);
+    }
+    if (select->having) {
+        select->having = extract_aggregates(ctx, select, select->having);
+        select->having = replace_keys(ctx, select, select->having);
+    }
+    for (size_t i = 0; i < select->num_items; i++)
+        check_item(ctx, select, select->items[i], NULL);
+    if (select->having)
+        check_item(ctx, select, select->having, NULL);
+
+    // the items and keys are values (a NULL result is kept), HAVING is a filter
+    for (size_t i = 0; i < select->num_items; i++) {
+        sql_optimizer_t *optimizer = sql_optimizer_value(ctx);
+        sql_optimizer_enable_pass(optimizer, "share_subexpressions", false);
+        sql_optimize(optimizer, select->items[i]);
+    }
+    if (select->having) {
+        sql_optimizer_t *optimizer = sql_optimizer_default(ctx);
+        sql_optimizer_enable_pass(optimizer, "share_subexpressions", false);
+        sql_optimize(optimizer, select->having);
+    }
+    for (size_t i = 0; i < select->num_keys; i++)
+        sql_optimize(sql_optimizer_value(ctx), select->keys[i].expr);
+    ctx->row = row;
+
+    if (!select->num_slots && !select->num_keys && ctx->column_count) {
+        sql_node_t **columns = (sql_node_t **)aml_pool_alloc(ctx->pool, ctx->column_count * sizeof(sql_node_t *));
+        size_t num_columns = 0;
+        for (size_t i = 0; i < select->num_items; i++)
+            share_column_nodes(ctx, select->items + i, columns, &num_columns);
+    }
+
+    if (!sql_ctx_get_callback_name(ctx, slot_result)) {
+        sql_ctx_register_callback(ctx, slot_result, "aggregate_result",
+                                  "Returns the finalized result of an aggregate.");
+        sql_ctx_register_callback(ctx, key_result, "group_key",
+                                  "Returns the GROUP BY key of the group being finalized.");
+    }
+    return ctx->errors ? NULL : select;
+}
+
+size_t sql_select_num_items(sql_select_t *select) {
+    return select->num_items;
+}
+
+sql_node_t *sql_select_item(sql_select_t *select, size_t item) {
+    return item < select->num_items ? select->items[item] : NULL;
+}
+
+const char *sql_select_item_name(sql_select_t *select, size_t item) {
+    return item < select->num_items ? select->names[item] : NULL;
+}
+
+sql_data_type_t sql_select_item_type(sql_select_t *select, size_t item) {
+    return item < select->num_items ? select->items[item]->data_type : SQL_TYPE_UNKNOWN;
+}
+
+size_t sql_select_num_group_keys(sql_select_t *select) {
+    return select->num_keys;
+}
+
+sql_node_t *sql_select_group_key(sql_select_t *select, size_t key) {
+    return key < select->num_keys ? select->keys[key].expr : NULL;
+}
+
+size_t sql_select_num_aggregates(sql_select_t *select) {
+    return select->num_slots;
+}
+
+sql_node_t *sql_select_aggregate(sql_select_t *select, size_t aggregate) {
+    return aggregate < select->num_slots ? select->slots[aggregate].call : NULL;
+}
+
+sql_node_t *sql_select_having(sql_select_t *select) {
+    return select->having;
+}
+
+size_t sql_select_state_size(sql_select_t *select) {
+    return select->state_size;
+}
+
+void sql_select_state_init(sql_ctx_t *ctx, sql_select_t *select, void *state) {
+    for (size_t i = 0; i < select->num_slots; i++) {
+        sql_select_slot_t *slot = select->slots + i;
+        slot->aggregate->init(ctx, slot->call, (char *)state + slot->offset);
+    }
+}
+
+void sql_select_accumulate(sql_ctx_t *ctx, sql_select_t *select, void *state) {
+    for (size_t i = 0; i < select->num_slots; i++) {
+        sql_select_slot_t *slot = select->slots + i;
+        slot->aggregate->accumulate(ctx, slot->call, (char *)state + slot->offset);
+    }
+}
+
+void sql_select_merge(sql_ctx_t *ctx, sql_select_t *select, void *state, const void *other) {
+    for (size_t i = 0; i < select->num_slots; i++) {
+        sql_select_slot_t *slot = select->slots + i;
+        slot->aggregate->merge(ctx, slot->call, (char *)state + slot->offset,
+                               (const char *)other + slot->offset);
+    }
+}
+
+bool sql_select_finalize_group(sql_ctx_t *ctx, sql_select_t *select, sql_node_t **keys, void *state,
+                               sql_node_t **results) {
+    for (size_t i = 0; keys && i < select->num_keys; i++)
+        select->keys[i].result = keys[i];
+    for (size_t i = 0; i < select->num_slots; i++) {
+        sql_select_slot_t *slot = select->slots + i;
+        slot->result = slot->aggregate->finalize(ctx, slot->call, (char *)state + slot->offset);
+    }
+    if (select->having) {
+        sql_node_t *result = sql_eval(ctx, select->having);
+        if (!result || result->is_null || !result->value.bool_value)
+            return false;
+    }
+    for (size_t i = 0; i < select->num_items; i++)
+        results[i] = sql_eval(ctx, select->items[i]);
+    return true;
+}
+
+bool sql_select_finalize(sql_ctx_t *ctx, sql_select_t *select, void *state, sql_node_t **results) {
+    return sql_select_finalize_group(ctx, select, NULL, state, results);
+}
+
+bool sql_select_project(sql_ctx_t *ctx, sql_select_t *select, sql_select_value_t *row) {
+    if (select->num_slots || select->num_keys) {
+        sql_ctx_error(ctx, "A query with aggregates or GROUP BY can't be projected row by row");
+        return false;
+    }
+    if (select->having) {
+        sql_node_t *result = sql_eval(ctx, select->having);
+        if (!result || result->is_null || !result->value.bool_value)
+            return false;
+    }
+    for (size_t i = 0; i < select->num_items; i++) {
+        sql_node_t *result = sql_eval(ctx, select->items[i]);
+        sql_select_value_t *v = row + i;
+        v->is_null = !result || result->is_null;
+        if (v->is_null)
+            continue;
+        switch (select->items[i]->data_type) {
+            case SQL_TYPE_BOOL:
+                v->value.bool_value = result->value.bool_value;
+                break;
+            case SQL_TYPE_INT:
+                v->value.int_value = result->value.int_value;
+                break;
+            case SQL_TYPE_DOUBLE:
+                v->value.double_value = result->value.double_value;
+                break;
+            case SQL_TYPE_DATETIME:
+                v->value.epoch = result->value.epoch;
+                break;
+            case SQL_TYPE_STRING:
+                v->value.string_value = result->value.string_value;
+                break;
+            default:
+                // a type which has no value member (a NULL literal, custom types)
+                v->is_null = true;
+                break;
+        }
+    }
+    return true;
+}
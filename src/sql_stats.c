@@ -0,0 +1,638 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_stats.h"
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Evaluates a filter over what a block of rows may contain rather than over
+    a row.  Every node is reduced to the set of values it may take across the
+    block - whether it may be NULL, whether it may be non-NULL, and bounds on
+    the non-NULL values.
+
+        price * 2 < 10      price [8, 20], no NULLs     => [16, 40] < 10
+                                                        => ALWAYS_FALSE
+
+    Booleans use the bounds [0, 1] (FALSE = 0, TRUE = 1), so AND / OR / NOT
+    and the comparisons all work on the same representation.  Arithmetic uses
+    interval arithmetic, monotonic functions (DATE_TRUNC, EXTRACT(YEAR),
+    LOWER, ROUND, ...) are called on the bounds, and anything else may be any
+    value.  Siblings are treated as independent (x < 5 AND x > 3 is MAYBE for
+    x in [4, 4] even though it is always true), so the answer is sound but not
+    always exact.
+*/
+
+typedef struct {
+    bool null;      // may be NULL
+    bool value;     // may be non-NULL
+    bool bounded;   // the non-NULL values are within lo / hi (slo / shi for strings)
+    double lo;
+    double hi;
+    const char *slo;
+    const char *shi;
+} stats_value_t;
+
+typedef struct {
+    sql_ctx_t *ctx;
+    sql_column_stats_t *stats;
+    size_t num_stats;
+} stats_ctx_t;
+
+static void eval_node(stats_ctx_t *s, sql_node_t *node, stats_value_t *v);
+
+static void set_unknown(stats_value_t *v, sql_data_type_t type) {
+    memset(v, 0, sizeof(*v));
+    v->null = true;
+    v->value = true;
+    if (type == SQL_TYPE_BOOL) {
+        v->bounded = true;
+        v->hi = 1;
+    }
+}
+
+static void set_bool(stats_value_t *v, bool null, bool may_be_true, bool may_be_false) {
+    memset(v, 0, sizeof(*v));
+    v->null = null;
+    v->value = may_be_true || may_be_false;
+    v->bounded = true;
+    v->lo = may_be_false ? 0 : 1;
+    v->hi = may_be_true ? 1 : 0;
+}
+
+static bool may_be_true(stats_value_t *v) {
+    return v->value && (!v->bounded || v->hi >= 1);
+}
+
+static bool may_be_false(stats_value_t *v) {
+    return v->value && (!v->bounded || v->lo <= 0);
+}
+
+static bool is_numeric_type(sql_data_type_t type) {
+    return type == SQL_TYPE_INT || type == SQL_TYPE_DOUBLE ||
+           type == SQL_TYPE_DATETIME || type == SQL_TYPE_BOOL;
+}
+
+static bool get_number(sql_node_t *node, double *d) {
+    switch (node->data_type) {
+        case SQL_TYPE_INT:
+            *d = node->value.int_value;
+            return true;
+        case SQL_TYPE_DOUBLE:
+            *d = node->value.double_value;
+            return true;
+        case SQL_TYPE_DATETIME:
+            *d = (double)node->value.epoch;
+            return true;
+        case SQL_TYPE_BOOL:
+            *d = node->value.bool_value ? 1 : 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_value(sql_node_t *node) {
+    return node && is_literal(node) && node->token_type != SQL_LIST && !node->is_null;
+}
+
+// sets v to the bounds [min, max] if they can be used for a column of type
+static void set_bounds(stats_value_t *v, sql_data_type_t type, sql_node_t *min, sql_node_t *max) {
+    if (!is_value(min) || !is_value(max))
+        return;
+    if (type == SQL_TYPE_STRING) {
+        if (min->data_type != SQL_TYPE_STRING || max->data_type != SQL_TYPE_STRING ||
+            !min->value.string_value || !max->value.string_value)
+            return;
+        v->slo = min->value.string_value;
+        v->shi = max->value.string_value;
+        v->bounded = true;
+    } else if (is_numeric_type(type) && get_number(min, &v->lo) && get_number(max, &v->hi)) {
+        v->bounded = true;
+    }
+}
+
+static void eval_literal(sql_node_t *node, stats_value_t *v) {
+    set_unknown(v, node->data_type);
+    if (node->is_null) {
+        v->value = false;
+        return;
+    }
+    v->null = false;
+    set_bounds(v, node->data_type, node, node);
+}
+
+static sql_column_stats_t *find_stats(stats_ctx_t *s, const char *name) {
+    for (size_t i = 0; i < s->num_stats; i++) {
+        if (s->stats[i].name && !strcasecmp(s->stats[i].name, name))
+            return s->stats + i;
+    }
+    return NULL;
+}
+
+static void eval_column(stats_ctx_t *s, sql_node_t *node, stats_value_t *v) {
+    set_unknown(v, node->data_type);
+    sql_column_stats_t *cs = node->token ? find_stats(s, node->token) : NULL;
+    if (!cs)
+        return;
+    v->null = cs->null_count > 0;
+    v->value = cs->null_count < cs->row_count;
+    set_bounds(v, node->data_type, cs->min, cs->max);
+}
+
+/* Logical operators, all of them return NULL if any input is NULL (see boolean.c) */
+
+static void eval_and_or(stats_ctx_t *s, sql_node_t *node, bool is_and, stats_value_t *v) {
+    bool null = false, all_values = true, all_true = true, all_false = true;
+    bool any_true = false, any_false = false;
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        stats_value_t c;
+        eval_node(s, node->parameters[i], &c);
+        null = null || c.null;
+        all_values = all_values && c.value;
+        all_true = all_true && may_be_true(&c);
+        all_false = all_false && may_be_false(&c);
+        any_true = any_true || may_be_true(&c);
+        any_false = any_false || may_be_false(&c);
+    }
+    if (is_and)
+        set_bool(v, null, all_true, all_values && any_false);
+    else
+        set_bool(v, null, all_values && any_true, all_false);
+}
+
+static void eval_not(stats_ctx_t *s, sql_node_t *node, stats_value_t *v) {
+    stats_value_t c;
+    eval_node(s, node->parameters[0], &c);
+    set_bool(v, c.null, may_be_false(&c), may_be_true(&c));
+}
+
+/* Comparisons */
+
+static int compare_bounds(sql_data_type_t type, stats_value_t *a, bool a_hi, stats_value_t *b, bool b_hi) {
+    if (type == SQL_TYPE_STRING)
+        return strcasecmp(a_hi ? a->shi : a->slo, b_hi ? b->shi : b->slo);
+    double x = a_hi ? a->hi : a->lo;
+    double y = b_hi ? b->hi : b->lo;
+    return (x > y) - (x < y);
+}
+
+static bool is_single_value(sql_data_type_t type, stats_value_t *v) {
+    return v->bounded && compare_bounds(type, v, false, v, true) == 0;
+}
+
+static bool may_be_equal(sql_data_type_t type, stats_value_t *a, stats_value_t *b) {
+    if (!a->bounded || !b->bounded)
+        return true;
+    return compare_bounds(type, a, false, b, true) <= 0 && compare_bounds(type, b, false, a, true) <= 0;
+}
+
+static bool may_differ(sql_data_type_t type, stats_value_t *a, stats_value_t *b) {
+    return !is_single_value(type, a) || !is_single_value(type, b) ||
+           compare_bounds(type, a, false, b, false) != 0;
+}
+
+// a < b (or a <= b)
+static bool may_be_less(sql_data_type_t type, stats_value_t *a, stats_value_t *b, bool inclusive) {
+    if (!a->bounded || !b->bounded)
+        return true;
+    int cmp = compare_bounds(type, a, false, b, true);
+    return inclusive ? cmp <= 0 : cmp < 0;
+}
+
+// the parameters are converted to a common type when the tree is built (apply_type_conversions)
+static bool same_types(sql_node_t *node) {
+    for (size_t i = 1; i < node->num_parameters; i++) {
+        if (node->parameters[i]->data_type != node->parameters[0]->data_type)
+            return false;
+    }
+    return true;
+}
+
+static void eval_comparison(stats_ctx_t *s, sql_node_t *node, const char *op, stats_value_t *v) {
+    sql_data_type_t type = node->parameters[0]->data_type;
+    if (!same_types(node)) {
+        set_bool(v, true, true, true);
+        return;
+    }
+    stats_value_t a, b;
+    eval_node(s, node->parameters[0], &a);
+    eval_node(s, node->parameters[1], &b);
+    bool null = a.null || b.null;
+    if (!a.value || !b.value) {
+        set_bool(v, null, false, false);
+        return;
+    }
+
+    bool t, f;
+    if (!strcmp(op, "<") || !strcmp(op, "<=")) {
+        bool inclusive = op[1] == '=';
+        t = may_be_less(type, &a, &b, inclusive);
+        f = may_be_less(type, &b, &a, !inclusive);
+    } else if (!strcmp(op, "!=")) {
+        t = may_differ(type, &a, &b);
+        f = may_be_equal(type, &a, &b);
+    } else {
+        t = may_be_equal(type, &a, &b);
+        f = may_differ(type, &a, &b);
+    }
+    set_bool(v, null, t, f);
+}
+
+static void eval_between(stats_ctx_t *s, sql_node_t *node, bool negate, stats_value_t *v) {
+    sql_data_type_t type = node->parameters[0]->data_type;
+    if (!same_types(node)) {
+        set_bool(v, true, true, true);
+        return;
+    }
+    stats_value_t x, lo, hi;
+    eval_node(s, node->parameters[0], &x);
+    eval_node(s, node->parameters[1], &lo);
+    eval_node(s, node->parameters[2], &hi);
+    bool null = x.null || lo.null || hi.null;
+    if (!x.value || !lo.value || !hi.value) {
+        set_bool(v, null, false, false);
+        return;
+    }
+    bool t = may_be_less(type, &lo, &x, true) && may_be_less(type, &x, &hi, true);
+    bool f = may_be_less(type, &x, &lo, false) || may_be_less(type, &hi, &x, false);
+    set_bool(v, null, negate ? f : t, negate ? t : f);
+}
+
+// NOT IN is never NULL, it is TRUE when x is NULL or the list has a NULL (see in.c)
+static void eval_in(stats_ctx_t *s, sql_node_t *node, bool negate, stats_value_t *v) {
+    sql_data_type_t type = node->parameters[0]->data_type;
+    sql_node_t *list = node->parameters[1];
+    stats_value_t x;
+    eval_node(s, node->parameters[0], &x);
+    if (list->token_type != SQL_LIST) {
+        set_bool(v, !negate, true, true);
+        return;
+    }
+
+    // IN is FALSE when no element matches and none is NULL, NULL when no element matches
+    // but one is NULL
+    bool found = false, list_null = false, missing = x.value, not_found = x.value;
+    for (size_t i = 0; i < list->num_parameters; i++) {
+        sql_node_t *p = list->parameters[i];
+        stats_value_t e;
+        eval_node(s, p, &e);
+        if (p->data_type != type)
+            set_unknown(&e, type);
+        list_null = list_null || e.null;
+        if (x.value && e.value && may_be_equal(type, &x, &e))
+            found = true;
+        if (!e.null && !may_differ(type, &x, &e))
+            missing = false;
+        if (!e.value || !may_differ(type, &x, &e))
+            not_found = false;
+    }
+    if (negate)
+        set_bool(v, false, x.null || missing, found);
+    else
+        set_bool(v, x.null || (missing && list_null), found, not_found);
+}
+
+static bool is_wildcard(char ch) {
+    return ch == '%' || ch == '_' || ch == ' ';
+}
+
+static void eval_like(stats_ctx_t *s, sql_node_t *node, bool negate, stats_value_t *v) {
+    stats_value_t x, pattern;
+    eval_node(s, node->parameters[0], &x);
+    eval_node(s, node->parameters[1], &pattern);
+    bool null = x.null || pattern.null;
+    if (!x.value || !pattern.value) {
+        set_bool(v, null, false, false);
+        return;
+    }
+
+    // every match starts with the pattern's prefix (ignoring case)
+    bool t = true;
+    sql_node_t *p = node->parameters[1];
+    if (x.bounded && node->parameters[0]->data_type == SQL_TYPE_STRING && is_value(p) && p->data_type == SQL_TYPE_STRING && p->value.string_value) {
+        const char *prefix = p->value.string_value;
+        size_t length = 0;
+        while (prefix[length] && !is_wildcard(prefix[length]))
+            length++;
+        if (length && (strncasecmp(x.shi, prefix, length) < 0 || strncasecmp(x.slo, prefix, length) > 0))
+            t = false;
+    }
+    set_bool(v, null, negate ? true : t, negate ? t : true);
+}
+
+static void eval_is(stats_ctx_t *s, sql_node_t *node, const char *op, stats_value_t *v) {
+    stats_value_t c;
+    eval_node(s, node->parameters[0], &c);
+    bool t, f;
+    if (!strcasecmp(op, "IS NULL") || !strcasecmp(op, "IS NOT NULL")) {
+        t = c.null;
+        f = c.value;
+    } else if (!strcasecmp(op, "IS TRUE") || !strcasecmp(op, "IS NOT TRUE")) {
+        t = may_be_true(&c);
+        f = c.null || may_be_false(&c);
+    } else {
+        t = may_be_false(&c);
+        f = c.null || may_be_true(&c);
+    }
+    if (!strncasecmp(op, "IS NOT ", 7))
+        set_bool(v, false, f, t);
+    else
+        set_bool(v, false, t, f);
+}
+
+/* Arithmetic */
+
+static double min4(double a, double b, double c, double d) {
+    double m = a < b ? a : b;
+    m = m < c ? m : c;
+    return m < d ? m : d;
+}
+
+static double max4(double a, double b, double c, double d) {
+    double m = a > b ? a : b;
+    m = m > c ? m : c;
+    return m > d ? m : d;
+}
+
+static void interval_add(stats_value_t *r, stats_value_t *a, stats_value_t *b, double scale) {
+    r->lo = a->lo + (scale < 0 ? b->hi * scale : b->lo * scale);
+    r->hi = a->hi + (scale < 0 ? b->lo * scale : b->hi * scale);
+}
+
+static void interval_multiply(stats_value_t *r, stats_value_t *a, stats_value_t *b) {
+    double p1 = a->lo * b->lo, p2 = a->lo * b->hi, p3 = a->hi * b->lo, p4 = a->hi * b->hi;
+    r->lo = min4(p1, p2, p3, p4);
+    r->hi = max4(p1, p2, p3, p4);
+}
+
+// the divisor doesn't contain 0
+static void interval_divide(stats_value_t *r, stats_value_t *a, stats_value_t *b) {
+    double q1 = a->lo / b->lo, q2 = a->lo / b->hi, q3 = a->hi / b->lo, q4 = a->hi / b->hi;
+    r->lo = min4(q1, q2, q3, q4);
+    r->hi = max4(q1, q2, q3, q4);
+}
+
+static bool eval_arithmetic(stats_ctx_t *s, sql_node_t *node, const char *name, stats_value_t *v) {
+    bool is_int = !strncmp(name, "int_", 4);
+    bool is_datetime = !strncmp(name, "datetime_", 9);
+    if (!is_int && !is_datetime && strncmp(name, "double_", 7))
+        return false;
+    const char *op = strchr(name, '_') + 1;
+    if (is_datetime) {
+        // adding an INTERVAL isn't monotonic (months vary in length)
+        if (strcmp(op, "subtract") && strcmp(op, "int_add") && strcmp(op, "int_subtract") &&
+            strcmp(op, "double_add") && strcmp(op, "double_subtract"))
+            return false;
+    } else if (strcmp(op, "add") && strcmp(op, "subtract") && strcmp(op, "multiply") && strcmp(op, "divide")) {
+        return false;
+    }
+
+    set_unknown(v, node->data_type);
+    v->null = false;
+    bool bounded = true;
+    stats_value_t r;
+    memset(&r, 0, sizeof(r));
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        stats_value_t c;
+        eval_node(s, node->parameters[i], &c);
+        v->null = v->null || c.null;
+        v->value = v->value && c.value;
+        if (i && !strcmp(op, "divide") && (!c.bounded || (c.lo <= 0 && c.hi >= 0))) {
+            // dividing by 0 is NULL (see arithmetic.c)
+            v->null = true;
+            if (c.bounded && c.lo == 0 && c.hi == 0)
+                v->value = false;
+            bounded = false;
+        }
+        bounded = bounded && c.bounded;
+        if (!bounded)
+            continue;
+        if (!i) {
+            r = c;
+            continue;
+        }
+        if (is_datetime) {
+            // DATETIME +/- days (see adjust_time_by_seconds) or DATETIME - DATETIME in seconds
+            if (!strcmp(op, "subtract")) {
+                interval_add(&r, &r, &c, -1);
+                continue;
+            }
+            if (op[0] == 'i' && (c.lo < INT_MIN / 86400 || c.hi > INT_MAX / 86400))
+                bounded = false;
+            interval_add(&r, &r, &c, strstr(op, "subtract") ? -86400 : 86400);
+            if (op[0] == 'd') {
+                // fractional seconds are truncated
+                r.lo -= 1;
+                r.hi += 1;
+            }
+        } else if (!strcmp(op, "add")) {
+            interval_add(&r, &r, &c, 1);
+        } else if (!strcmp(op, "subtract")) {
+            interval_add(&r, &r, &c, -1);
+        } else if (!strcmp(op, "multiply")) {
+            interval_multiply(&r, &r, &c);
+        } else {
+            interval_divide(&r, &r, &c);
+        }
+    }
+
+    // integer overflow wraps around
+    if (bounded && is_int && strcmp(op, "divide") && (r.lo < INT_MIN || r.hi > INT_MAX))
+        bounded = false;
+    if (bounded && node->num_parameters) {
+        v->bounded = true;
+        v->lo = r.lo;
+        v->hi = r.hi;
+    }
+    return true;
+}
+
+/* Monotonic functions */
+
+static const char *monotonic_functions[] = {
+    "convert_int_to_double", "convert_int_to_datetime", "convert_double_to_int",
+    "extract_year", "lower", "upper", "round", "round_with_decimal_places", "floor", "ceil",
+    NULL
+};
+
+// f(x) <= f(y) whenever x <= y
+static bool is_monotonic(const char *name) {
+    if (!strncmp(name, "trunc_", 6))
+        return true;
+    for (size_t i = 0; monotonic_functions[i]; i++) {
+        if (!strcmp(name, monotonic_functions[i]))
+            return true;
+    }
+    return false;
+}
+
+static sql_node_t *bound_literal(sql_ctx_t *ctx, sql_data_type_t type, stats_value_t *v, bool hi) {
+    switch (type) {
+        case SQL_TYPE_INT:
+            return sql_int_init(ctx, (int)(hi ? v->hi : v->lo), false);
+        case SQL_TYPE_DOUBLE:
+            return sql_double_init(ctx, hi ? v->hi : v->lo, false);
+        case SQL_TYPE_DATETIME:
+            return sql_datetime_init(ctx, (time_t)(hi ? v->hi : v->lo), false);
+        case SQL_TYPE_STRING:
+            return sql_string_init(ctx, hi ? v->shi : v->slo, false);
+        default:
+            return NULL;
+    }
+}
+
+// calls the function with the varying parameter set to a bound
+static sql_node_t *call_at_bound(stats_ctx_t *s, sql_node_t *node, size_t index, sql_node_t *bound) {
+    if (!bound)
+        return NULL;
+    sql_node_t call = *node;
+    call.memo = NULL;
+    call.parameters = (sql_node_t **)aml_pool_dup(s->ctx->pool, node->parameters,
+                                                  node->num_parameters * sizeof(sql_node_t *));
+    call.parameters[index] = bound;
+    sql_node_t *result = node->func(s->ctx, &call);
+    return is_value(result) ? result : NULL;
+}
+
+static bool eval_monotonic(stats_ctx_t *s, sql_node_t *node, stats_value_t *v) {
+    // exactly one parameter may vary, the others must be literals (DATE_TRUNC('day', x))
+    size_t index = node->num_parameters;
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        if (is_value(node->parameters[i]))
+            continue;
+        if (index != node->num_parameters)
+            return false;
+        index = i;
+    }
+    if (index == node->num_parameters)
+        return false;
+
+    sql_node_t *param = node->parameters[index];
+    stats_value_t c;
+    eval_node(s, param, &c);
+    set_unknown(v, node->data_type);
+    v->null = c.null;
+    v->value = c.value;
+    if (!c.value || !c.bounded)
+        return true;
+    if (param->data_type == SQL_TYPE_INT && (c.lo < INT_MIN || c.hi > INT_MAX))
+        return true;
+    if (node->data_type == SQL_TYPE_INT && param->data_type == SQL_TYPE_DOUBLE &&
+        (c.lo <= (double)INT_MIN - 1 || c.hi >= (double)INT_MAX + 1))
+        return true;
+
+    sql_node_t *lo = call_at_bound(s, node, index, bound_literal(s->ctx, param->data_type, &c, false));
+    sql_node_t *hi = call_at_bound(s, node, index, bound_literal(s->ctx, param->data_type, &c, true));
+    if (!lo || !hi) {
+        v->null = true;
+        return true;
+    }
+    set_bounds(v, node->data_type, lo, hi);
+    return true;
+}
+
+// a function of literals which hasn't been folded yet (such as the CONVERT of a literal)
+static bool is_constant(sql_node_t *node) {
+    if (node->token_type == SQL_IDENTIFIER || node->token_type == SQL_LIST)
+        return false;
+    if (!node->func)
+        return is_literal(node);
+    if (!node->num_parameters)
+        return false;   // NOW() and other functions without parameters
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        if (!is_constant(node->parameters[i]))
+            return false;
+    }
+    return true;
+}
+
+static void eval_node(stats_ctx_t *s, sql_node_t *node, stats_value_t *v) {
+    if (node->token_type == SQL_IDENTIFIER) {
+        eval_column(s, node, v);
+        return;
+    }
+    if (is_constant(node)) {
+        sql_node_t *result = node->func ? node->func(s->ctx, node) : node;
+        if (result && is_literal(result) && result->token_type != SQL_LIST)
+            eval_literal(result, v);
+        else
+            set_unknown(v, node->data_type);
+        return;
+    }
+
+    const char *op = node->spec ? node->spec->name : NULL;
+    size_t n = node->num_parameters;
+    if (op && node->func) {
+        if (!strcasecmp(op, "AND") || !strcasecmp(op, "OR")) {
+            eval_and_or(s, node, !strcasecmp(op, "AND"), v);
+            return;
+        }
+        if (!strcasecmp(op, "NOT") && n == 1) {
+            eval_not(s, node, v);
+            return;
+        }
+        if (n == 2 && (!strcmp(op, "<") || !strcmp(op, "<=") || !strcmp(op, "=") ||
+                       !strcmp(op, "==") || !strcmp(op, "!="))) {
+            eval_comparison(s, node, op, v);
+            return;
+        }
+        if (n == 3 && (!strcasecmp(op, "BETWEEN") || !strcasecmp(op, "NOT BETWEEN"))) {
+            eval_between(s, node, !strcasecmp(op, "NOT BETWEEN"), v);
+            return;
+        }
+        if (n == 2 && (!strcasecmp(op, "IN") || !strcasecmp(op, "NOT IN"))) {
+            eval_in(s, node, !strcasecmp(op, "NOT IN"), v);
+            return;
+        }
+        if (n == 2 && (!strcasecmp(op, "LIKE") || !strcasecmp(op, "NOT LIKE"))) {
+            eval_like(s, node, !strcasecmp(op, "NOT LIKE"), v);
+            return;
+        }
+        if (n == 1 && !strncasecmp(op, "IS ", 3)) {
+            eval_is(s, node, op, v);
+            return;
+        }
+    }
+
+    const char *name = node->func ? sql_ctx_get_callback_name(s->ctx, node->func) : NULL;
+    if (name && n) {
+        if (eval_arithmetic(s, node, name, v))
+            return;
+        if (is_monotonic(name) && eval_monotonic(s, node, v))
+            return;
+    }
+    set_unknown(v, node->data_type);
+}
+
+const char *sql_stats_result_name(sql_stats_result_t result) {
+    switch (result) {
+        case SQL_STATS_ALWAYS_FALSE:
+            return "ALWAYS_FALSE";
+        case SQL_STATS_ALWAYS_TRUE:
+            return "ALWAYS_TRUE";
+        default:
+            return "MAYBE";
+    }
+}
+
+sql_stats_result_t sql_eval_stats(sql_ctx_t *ctx, sql_node_t *where,
+                                  sql_column_stats_t *stats, size_t num_stats) {
+    if (!where)
+        return SQL_STATS_ALWAYS_TRUE;
+
+    stats_ctx_t s;
+    s.ctx = ctx;
+    s.stats = stats;
+    s.num_stats = num_stats;
+
+    stats_value_t v;
+    eval_node(&s, where, &v);
+    if (!may_be_true(&v))
+        return SQL_STATS_ALWAYS_FALSE;
+    if (!v.null && !may_be_false(&v))
+        return SQL_STATS_ALWAYS_TRUE;
+    return SQL_STATS_MAYBE;
+}
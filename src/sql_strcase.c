@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_strcase.h"
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// A byte is in 'A'..'Z' if it is > 'A' - 1 and < 'Z' + 1.  The compares are signed, so bytes of
+// 0x80 and above (negative) are never in the range.
+#if defined(__AVX2__)
+static inline __m256i in_range32(__m256i x, char first, char last) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(first - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(last + 1), x));
+}
+
+static inline __m256i lower32(__m256i x) {
+    return _mm256_or_si256(x, _mm256_and_si256(in_range32(x, 'A', 'Z'), _mm256_set1_epi8(0x20)));
+}
+
+static inline __m256i upper32(__m256i x) {
+    return _mm256_xor_si256(x, _mm256_and_si256(in_range32(x, 'a', 'z'), _mm256_set1_epi8(0x20)));
+}
+
+static inline __m256i load32(const char *p) {
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+#endif
+
+#if defined(__SSE2__)
+static inline __m128i in_range16(__m128i x, char first, char last) {
+    return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(first - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(last + 1), x));
+}
+
+static inline __m128i lower16(__m128i x) {
+    return _mm_or_si128(x, _mm_and_si128(in_range16(x, 'A', 'Z'), _mm_set1_epi8(0x20)));
+}
+
+static inline __m128i upper16(__m128i x) {
+    return _mm_xor_si128(x, _mm_and_si128(in_range16(x, 'a', 'z'), _mm_set1_epi8(0x20)));
+}
+
+static inline __m128i load16(const char *p) {
+    return _mm_loadu_si128((const __m128i *)p);
+}
+#endif
+
+// the first index where a and b differ ignoring case (length if they don't)
+static size_t mismatch(const char *a, const char *b, size_t length) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32) {
+        __m256i same = _mm256_cmpeq_epi8(lower32(load32(a + i)), lower32(load32(b + i)));
+        uint32_t diff = ~(uint32_t)_mm256_movemask_epi8(same);
+        if (diff)
+            return i + __builtin_ctz(diff);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16) {
+        __m128i same = _mm_cmpeq_epi8(lower16(load16(a + i)), lower16(load16(b + i)));
+        uint32_t diff = ~(uint32_t)_mm_movemask_epi8(same) & 0xFFFF;
+        if (diff)
+            return i + __builtin_ctz(diff);
+    }
+#endif
+    while (i < length && sql_ascii_tolower(a[i]) == sql_ascii_tolower(b[i]))
+        i++;
+    return i;
+}
+
+bool sql_strcase_equal(const char *a, size_t a_length, const char *b, size_t b_length) {
+    return a_length == b_length && mismatch(a, b, a_length) == a_length;
+}
+
+int sql_strcase_compare(const char *a, size_t a_length, const char *b, size_t b_length) {
+    size_t length = a_length < b_length ? a_length : b_length;
+    size_t i = mismatch(a, b, length);
+    if (i < length)
+        return (int)(unsigned char)sql_ascii_tolower(a[i]) - (int)(unsigned char)sql_ascii_tolower(b[i]);
+    return (a_length > b_length) - (a_length < b_length);
+}
+
+bool sql_strcase_prefix(const char *s, size_t length, const char *prefix, size_t prefix_length) {
+    return length >= prefix_length && mismatch(s, prefix, prefix_length) == prefix_length;
+}
+
+bool sql_strcase_suffix(const char *s, size_t length, const char *suffix, size_t suffix_length) {
+    return length >= suffix_length &&
+           mismatch(s + length - suffix_length, suffix, suffix_length) == suffix_length;
+}
+
+// Candidates are the positions whose first and last bytes match those of the needle (checked a
+// block of positions at a time), and only they are compared in full.
+const char *sql_strcase_find(const char *s, size_t length, const char *needle, size_t needle_length) {
+    if (!needle_length)
+        return s;
+    if (needle_length > length)
+        return NULL;
+    size_t last = needle_length - 1;
+    size_t end = length - last;  // one past the last position the needle can start at
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i first32 = _mm256_set1_epi8(sql_ascii_tolower(needle[0]));
+    __m256i last32 = _mm256_set1_epi8(sql_ascii_tolower(needle[last]));
+    for (; i + 32 <= end; i += 32) {
+        __m256i candidates = _mm256_and_si256(_mm256_cmpeq_epi8(lower32(load32(s + i)), first32),
+                                              _mm256_cmpeq_epi8(lower32(load32(s + i + last)), last32));
+        uint32_t bits = (uint32_t)_mm256_movemask_epi8(candidates);
+        while (bits) {
+            size_t p = i + __builtin_ctz(bits);
+            if (mismatch(s + p + 1, needle + 1, last) == last)
+                return s + p;
+            bits &= bits - 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i first16 = _mm_set1_epi8(sql_ascii_tolower(needle[0]));
+    __m128i last16 = _mm_set1_epi8(sql_ascii_tolower(needle[last]));
+    for (; i + 16 <= end; i += 16) {
+        __m128i candidates = _mm_and_si128(_mm_cmpeq_epi8(lower16(load16(s + i)), first16),
+                                           _mm_cmpeq_epi8(lower16(load16(s + i + last)), last16));
+        uint32_t bits = (uint32_t)_mm_movemask_epi8(candidates);
+        while (bits) {
+            size_t p = i + __builtin_ctz(bits);
+            if (mismatch(s + p + 1, needle + 1, last) == last)
+                return s + p;
+            bits &= bits - 1;
+        }
+    }
+#endif
+    char first = sql_ascii_tolower(needle[0]);
+    for (; i < end; i++) {
+        if (sql_ascii_tolower(s[i]) == first && mismatch(s + i + 1, needle + 1, last) == last)
+            return s + i;
+    }
+    return NULL;
+}
+
+void sql_ascii_lower(char *dest, const char *src, size_t length) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32)
+        _mm256_storeu_si256((__m256i *)(dest + i), lower32(load32(src + i)));
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16)
+        _mm_storeu_si128((__m128i *)(dest + i), lower16(load16(src + i)));
+#endif
+    for (; i < length; i++)
+        dest[i] = sql_ascii_tolower(src[i]);
+}
+
+void sql_ascii_upper(char *dest, const char *src, size_t length) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= length; i += 32)
+        _mm256_storeu_si256((__m256i *)(dest + i), upper32(load32(src + i)));
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16)
+        _mm_storeu_si128((__m128i *)(dest + i), upper16(load16(src + i)));
+#endif
+    for (; i < length; i++)
+        dest[i] = sql_ascii_toupper(src[i]);
+}
@@ -0,0 +1,255 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/sql_ctx.h"
+#include "the-macro-library/macro_map.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Common subexpression elimination.
+
+        LOWER(subject) LIKE '%a%' OR LOWER(subject) LIKE '%b%'
+
+    Subtrees are hashed by token type, func, spec, data type, and their
+    children (after type conversion, so both LOWER calls above match).  Every
+    repeat of a function / operator subtree is replaced by the first instance,
+    which gets a memo so sql_eval computes it once per row (see
+    sql_ctx_set_row).
+
+    The tree becomes a DAG, so the passes which rewrite nodes in place based
+    on their position must run before this.
+*/
+
+typedef struct {
+    macro_map_t node;
+    uint64_t hash;
+    sql_node_t *expr;
+} sql_subexpression_t;
+
+static int compare_expressions(uint64_t hash, sql_node_t *expr, const sql_subexpression_t *o) {
+    if (hash != o->hash)
+        return hash < o->hash ? -1 : 1;
+    if (expr == o->expr || sql_same_expression(expr, o->expr))
+        return 0;
+    // same hash, different expression - order by address so both can be kept
+    return expr < o->expr ? -1 : 1;
+}
+
+static inline int sql_subexpression_insert_compare(const sql_subexpression_t *a,
+                                                   const sql_subexpression_t *b) {
+    return compare_expressions(a->hash, a->expr, b);
+}
+
+static inline int sql_subexpression_find_compare(const sql_subexpression_t *key,
+                                                 const sql_subexpression_t *o) {
+    return compare_expressions(key->hash, key->expr, o);
+}
+
+static inline
+macro_map_insert(sql_subexpression_insert, sql_subexpression_t,
+                 sql_subexpression_insert_compare);
+
+static inline
+macro_map_find_kv(sql_subexpression_find, sql_subexpression_t, sql_subexpression_t,
+                  sql_subexpression_find_compare);
+
+static uint64_t hash_combine(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+static uint64_t hash_string(uint64_t hash, const char *s, bool ignore_case) {
+    if (!s)
+        return hash_combine(hash, 0);
+    for (; *s; s++)
+        hash = hash_combine(hash, (unsigned char)(ignore_case ? tolower((unsigned char)*s) : *s));
+    return hash;
+}
+
+static bool is_column(sql_node_t *node) {
+    return node->token_type == SQL_IDENTIFIER;
+}
+
+static bool same_value(sql_node_t *a, sql_node_t *b) {
+    if (a->is_null || b->is_null)
+        return a->is_null == b->is_null;
+    switch (a->data_type) {
+        case SQL_TYPE_BOOL:
+            return a->value.bool_value == b->value.bool_value;
+        case SQL_TYPE_INT:
+            return a->value.int_value == b->value.int_value;
+        case SQL_TYPE_DOUBLE:
+            return a->value.double_value == b->value.double_value;
+        case SQL_TYPE_DATETIME:
+            return a->value.epoch == b->value.epoch;
+        case SQL_TYPE_STRING:
+            if (!a->value.string_value || !b->value.string_value)
+                return a->value.string_value == b->value.string_value;
+            return !strcmp(a->value.string_value, b->value.string_value);
+        default:
+            // compound literals and anything else are compared by their text
+            return a->token && b->token && !strcmp(a->token, b->token);
+    }
+}
+
+bool sql_same_expression(sql_node_t *a, sql_node_t *b) {
+    if (a == b)
+        return true;
+    if (a->token_type != b->token_type || a->data_type != b->data_type || a->func != b->func ||
+        a->spec != b->spec || a->num_parameters != b->num_parameters)
+        return false;
+
+    if (is_column(a)) {
+        if (!a->token || !b->token || strcasecmp(a->token, b->token))
+            return false;
+    } else if (!a->num_parameters && !same_value(a, b)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a->num_parameters; i++) {
+        if (!sql_same_expression(a->parameters[i], b->parameters[i]))
+            return false;
+    }
+    return true;
+}
+
+static uint64_t hash_value(uint64_t hash, sql_node_t *node) {
+    hash = hash_combine(hash, node->is_null);
+    if (node->is_null)
+        return hash;
+    switch (node->data_type) {
+        case SQL_TYPE_BOOL:
+            return hash_combine(hash, node->value.bool_value);
+        case SQL_TYPE_INT:
+            return hash_combine(hash, (uint64_t)(int64_t)node->value.int_value);
+        case SQL_TYPE_DOUBLE: {
+            double d = node->value.double_value == 0.0 ? 0.0 : node->value.double_value;
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            return hash_combine(hash, bits);
+        }
+        case SQL_TYPE_DATETIME:
+            return hash_combine(hash, (uint64_t)node->value.epoch);
+        case SQL_TYPE_STRING:
+            return hash_string(hash, node->value.string_value, false);
+        default:
+            return hash_string(hash, node->token, false);
+    }
+}
+
+// counts the parents of each distinct node once the repeats are shared
+typedef struct sql_subexpression_use_s {
+    macro_map_t node;
+    sql_node_t *expr;
+    size_t uses;
+    struct sql_subexpression_use_s *next;
+} sql_subexpression_use_t;
+
+static inline int sql_subexpression_use_insert_compare(const sql_subexpression_use_t *a,
+                                                       const sql_subexpression_use_t *b) {
+    return (a->expr > b->expr) - (a->expr < b->expr);
+}
+
+static inline int sql_subexpression_use_find_compare(const sql_node_t *expr,
+                                                     const sql_subexpression_use_t *o) {
+    return (expr > o->expr) - (expr < o->expr);
+}
+
+static inline
+macro_map_insert(sql_subexpression_use_insert, sql_subexpression_use_t,
+                 sql_subexpression_use_insert_compare);
+
+static inline
+macro_map_find_kv(sql_subexpression_use_find, sql_node_t, sql_subexpression_use_t,
+                  sql_subexpression_use_find_compare);
+
+typedef struct {
+    sql_ctx_t *ctx;
+    macro_map_t *subexpressions;
+    macro_map_t *uses;
+    sql_subexpression_use_t *use_list;
+    size_t rewrites;
+} sql_subexpression_ctx_t;
+
+// only evaluated subtrees are worth sharing (not columns, literals, or lists)
+static bool is_candidate(sql_node_t *node) {
+    return node->func && node->num_parameters && node->token_type != SQL_LIST && !is_column(node);
+}
+
+// Replaces repeated subtrees below node with their first instance, returns the hash of node
+static uint64_t share_node(sql_subexpression_ctx_t *sc, sql_node_t *node) {
+    uint64_t hash = hash_combine(0, node->token_type);
+    hash = hash_combine(hash, node->data_type);
+    hash = hash_combine(hash, (uint64_t)(uintptr_t)node->func);
+    hash = hash_combine(hash, (uint64_t)(uintptr_t)node->spec);
+    hash = hash_combine(hash, node->num_parameters);
+    if (is_column(node))
+        hash = hash_string(hash, node->token, true);
+    else if (!node->num_parameters)
+        hash = hash_value(hash, node);
+
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        sql_node_t *child = node->parameters[i];
+        uint64_t child_hash = share_node(sc, child);
+        hash = hash_combine(hash, child_hash);
+        if (!is_candidate(child))
+            continue;
+
+        sql_subexpression_t key;
+        key.hash = child_hash;
+        key.expr = child;
+        sql_subexpression_t *s = sql_subexpression_find(sc->subexpressions, &key);
+        if (!s) {
+            s = (sql_subexpression_t *)aml_pool_zalloc(sc->ctx->pool, sizeof(sql_subexpression_t));
+            s->hash = child_hash;
+            s->expr = child;
+            sql_subexpression_insert(&sc->subexpressions, s);
+        } else if (s->expr != child) {
+            node->parameters[i] = s->expr;
+            sc->rewrites++;
+        }
+    }
+    return hash;
+}
+
+// A node below a shared node is only evaluated through it, so each node is descended into once
+static void count_uses(sql_subexpression_ctx_t *sc, sql_node_t *node) {
+    for (size_t i = 0; i < node->num_parameters; i++) {
+        sql_node_t *child = node->parameters[i];
+        if (!is_candidate(child)) {
+            count_uses(sc, child);
+            continue;
+        }
+        sql_subexpression_use_t *u = sql_subexpression_use_find(sc->uses, child);
+        if (u) {
+            u->uses++;
+            continue;
+        }
+        u = (sql_subexpression_use_t *)aml_pool_zalloc(sc->ctx->pool, sizeof(sql_subexpression_use_t));
+        u->expr = child;
+        u->uses = 1;
+        u->next = sc->use_list;
+        sc->use_list = u;
+        sql_subexpression_use_insert(&sc->uses, u);
+        count_uses(sc, child);
+    }
+}
+
+size_t share_common_subexpressions(sql_ctx_t *ctx, sql_node_t *node) {
+    if (!node)
+        return 0;
+    sql_subexpression_ctx_t sc;
+    memset(&sc, 0, sizeof(sc));
+    sc.ctx = ctx;
+    share_node(&sc, node);
+    count_uses(&sc, node);
+    for (sql_subexpression_use_t *u = sc.use_list; u; u = u->next) {
+        if (u->uses > 1 && !u->expr->memo)
+            u->expr->memo = sql_memo_init(ctx);
+    }
+    return sc.rewrites;
+}
@@ -0,0 +1,258 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sql-parser-library/number_utils.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// the digits at s (after spaces and a sign) as a magnitude no larger than limit
+static bool parse_magnitude(const char *s, uint64_t limit, bool *negative, uint64_t *value, const char **end) {
+    while (is_space(*s))
+        s++;
+    *negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+    if (!is_digit(*s))
+        return false;
+    uint64_t v = 0;
+    bool overflow = false;
+    for (; is_digit(*s); s++) {
+        uint64_t digit = (uint64_t)(*s - '0');
+        if (v > (limit - digit) / 10)
+            overflow = true;
+        else
+            v = v * 10 + digit;
+    }
+    if (end)
+        *end = s;
+    *value = v;
+    return !overflow;
+}
+
+bool sql_parse_int(const char *s, int *value, const char **end) {
+    bool negative;
+    uint64_t v;
+    // the magnitude of INT_MIN is one more than INT_MAX
+    if (!parse_magnitude(s, (uint64_t)INT_MAX + 1, &negative, &v, end) || (!negative && v > INT_MAX))
+        return false;
+    *value = negative ? (int)(0 - v) : (int)v;
+    return true;
+}
+
+bool sql_parse_int64(const char *s, int64_t *value, const char **end) {
+    bool negative;
+    uint64_t v;
+    if (!parse_magnitude(s, (uint64_t)INT64_MAX + 1, &negative, &v, end) || (!negative && v > INT64_MAX))
+        return false;
+    *value = negative ? (int64_t)(0 - v) : (int64_t)v;
+    return true;
+}
+
+// the powers of ten which are exact doubles
+static const double exact_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// more significant digits than this never change the rounding (beyond whether any of them is
+// non-zero)
+#define SQL_MAX_DIGITS 768
+
+/*
+    A number is read as the integer of its significant digits times a power of
+    ten.  When the integer is exact (at most 2^53) and so is the power (up to
+    1e22), a single multiply or divide rounds correctly.  Otherwise the digits
+    are rewritten as "<digits>e<exponent>" (which has no decimal point, so the
+    locale doesn't matter) for strtod.
+*/
+bool sql_parse_double(const char *s, double *value, const char **end) {
+    while (is_space(*s))
+        s++;
+    bool negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+
+    if (!strncasecmp(s, "inf", 3) || !strncasecmp(s, "nan", 3)) {
+        bool nan = (s[0] | 0x20) == 'n';
+        s += 3;
+        if (!nan && !strncasecmp(s, "inity", 5))
+            s += 5;
+        if (end)
+            *end = s;
+        *value = nan ? (negative ? -NAN : NAN) : (negative ? -INFINITY : INFINITY);
+        return true;
+    }
+
+    char digits[SQL_MAX_DIGITS + 1];
+    size_t num_digits = 0;
+    bool any_digit = false, truncated = false;
+    uint64_t mantissa = 0;
+    long exponent = 0;  // of the last digit kept
+    bool seen_dot = false;
+    for (;; s++) {
+        if (*s == '.' && !seen_dot) {
+            seen_dot = true;
+            continue;
+        }
+        if (!is_digit(*s))
+            break;
+        any_digit = true;
+        if (seen_dot)
+            exponent--;
+        if (*s == '0' && !num_digits)
+            continue;  // leading zero
+        if (num_digits < SQL_MAX_DIGITS) {
+            if (num_digits < 19)
+                mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+            digits[num_digits++] = *s;
+        } else {
+            // dropped, but it still counts toward the exponent
+            exponent++;
+            if (*s != '0')
+                truncated = true;
+        }
+    }
+    if (!any_digit)
+        return false;
+
+    if ((*s == 'e' || *s == 'E') &&
+        (is_digit(s[1]) || ((s[1] == '-' || s[1] == '+') && is_digit(s[2])))) {
+        s++;
+        bool negative_exponent = *s == '-';
+        if (*s == '-' || *s == '+')
+            s++;
+        long e = 0;
+        for (; is_digit(*s); s++) {
+            if (e < 100000)
+                e = e * 10 + (*s - '0');
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    if (end)
+        *end = s;
+
+    double result;
+    if (!num_digits) {
+        result = 0.0;
+    } else if (num_digits <= 19 && mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+        result = (double)mantissa;
+        result = exponent < 0 ? result / exact_powers[-exponent] : result * exact_powers[exponent];
+    } else {
+        // a trailing 1 stands for the non-zero digits dropped
+        if (truncated) {
+            digits[num_digits++] = '1';
+            exponent--;
+        }
+        char buffer[SQL_MAX_DIGITS + 24];
+        memcpy(buffer, digits, num_digits);
+        snprintf(buffer + num_digits, sizeof(buffer) - num_digits, "e%ld", exponent);
+        result = strtod(buffer, NULL);
+    }
+    *value = negative ? -result : result;
+    return true;
+}
+
+// writes the digits of value backwards from the end of buffer, returns where they start
+static char *format_digits(char *end, uint64_t value) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static size_t format_signed(char *buffer, bool negative, uint64_t magnitude) {
+    char digits[24];
+    char *p = format_digits(digits + sizeof(digits), magnitude);
+    size_t length = (size_t)(digits + sizeof(digits) - p);
+    char *out = buffer;
+    if (negative)
+        *out++ = '-';
+    memcpy(out, p, length);
+    out[length] = '\0';
+    return (size_t)(out - buffer) + length;
+}
+
+size_t sql_format_int(char *buffer, int value) {
+    return format_signed(buffer, value < 0, value < 0 ? 0 - (uint64_t)(int64_t)value : (uint64_t)value);
+}
+
+size_t sql_format_int64(char *buffer, int64_t value) {
+    return format_signed(buffer, value < 0, value < 0 ? 0 - (uint64_t)value : (uint64_t)value);
+}
+
+/*
+    A finite double is m * 2^e for integers m < 2^53 and e.  With e < 0, the
+    value times 10^6 is m * 10^6 / 2^-e, and m * 10^6 < 2^73 fits in 128 bits,
+    so the six decimals are rounded (half to even, as printf does) from the
+    exact quotient and remainder.  Values of 2^64 or more (and everything
+    without 128 bit integers) are left to snprintf.
+*/
+size_t sql_format_double(char *buffer, double value) {
+#if defined(__SIZEOF_INT128__)
+    if (isfinite(value)) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        bool negative = bits >> 63;
+        int biased = (int)((bits >> 52) & 0x7FF);
+        uint64_t m = bits & (((uint64_t)1 << 52) - 1);
+        int e = biased ? biased - 1075 : -1074;
+        if (biased)
+            m |= (uint64_t)1 << 52;
+
+        uint64_t integer = 0, fraction = 0;
+        bool fits = true;
+        if (e >= 0) {
+            if (e > 64 - 53 && (e >= 64 || (m >> (64 - e))))
+                fits = false;
+            else
+                integer = m << e;
+        } else {
+            unsigned __int128 n = (unsigned __int128)m * 1000000u;
+            unsigned __int128 q = 0;
+            int k = -e;
+            if (k < 128) {
+                q = n >> k;
+                unsigned __int128 r = n & ((((unsigned __int128)1) << k) - 1);
+                unsigned __int128 half = ((unsigned __int128)1) << (k - 1);
+                if (r > half || (r == half && (q & 1)))
+                    q++;
+            }
+            integer = (uint64_t)(q / 1000000u);
+            fraction = (uint64_t)(q % 1000000u);
+        }
+        if (fits) {
+            char *out = buffer;
+            if (negative)
+                *out++ = '-';
+            char digits[24];
+            char *p = format_digits(digits + sizeof(digits), integer);
+            size_t length = (size_t)(digits + sizeof(digits) - p);
+            memcpy(out, p, length);
+            out += length;
+            *out++ = '.';
+            for (int i = 5; i >= 0; i--) {
+                out[i] = (char)('0' + fraction % 10);
+                fraction /= 10;
+            }
+            out[6] = '\0';
+            return (size_t)(out - buffer) + 6;
+        }
+    }
+#endif
+    int length = snprintf(buffer, SQL_DOUBLE_BUFFER_SIZE, "%f", value);
+    return length < 0 ? 0 : (size_t)length;
+}
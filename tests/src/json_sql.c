@@ -11,6 +11,7 @@
 // Include your existing SQL-related headers
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/sql_node.h"
+#include "sql-parser-library/sql_optimizer.h"
 #include "sql-parser-library/sql_ast.h"
 #include "sql-parser-library/sql_tokenizer.h"
 
@@ -231,14 +232,13 @@ static void run_select_star(sql_ctx_t *ctx, my_table_t *table, const char *sql)
         where_node = convert_ast_to_node(ctx, where_clause->left);
         // optional: apply conversions, simplify, etc.
         apply_type_conversions(ctx, where_node);
-        simplify_func_tree(ctx, where_node);
-        simplify_logical_expressions(where_node);
+        sql_optimize(sql_optimizer_default(ctx), where_node);
     }
 
     // We now "SELECT *" by iterating over each row
     printf("=== Results: ===\n");
     for (size_t r = 0; r < table->num_rows; r++) {
-        ctx->row = &table->rows[r];  // so column getters read from this row
+        sql_ctx_set_row(ctx, &table->rows[r]);  // so column getters read from this row
 
         bool show_row = true;
         if (where_node) {
@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the number parsing and formatting of number_utils against the C library.
+//
+//   number_utils_check [random_values]
+//
+// Integers at and past the limits of int and int64_t, doubles with more significant digits than
+// fit in 64 bits (and more than 768, the most a halfway case can need), subnormals, halfway cases
+// such as 2^53 + 1, and random doubles are parsed and compared bit for bit with strtod.  Formatting
+// is compared with snprintf "%d", "%" PRId64 and "%f" (halfway cases, negative zero, the extremes).
+// The types given to numeric literals are checked last.  Exits with 1 if anything differs.
+
+#include <float.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/number_utils.h"
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_select.h"
+#include "a-memory-library/aml_pool.h"
+
+static size_t checks = 0, failures = 0;
+
+static void check_int(const char *s, bool ok, int expected, size_t length) {
+    checks++;
+    int value = 0;
+    const char *end = NULL;
+    bool parsed = sql_parse_int(s, &value, &end);
+    if (parsed != ok || (ok && (value != expected || (size_t)(end - s) != length))) {
+        printf("sql_parse_int(\"%s\") => FAILED (%s %d)\n", s, parsed ? "parsed" : "rejected", value);
+        failures++;
+    }
+}
+
+static void check_int64(const char *s, bool ok, int64_t expected) {
+    checks++;
+    int64_t value = 0;
+    bool parsed = sql_parse_int64(s, &value, NULL);
+    if (parsed != ok || (ok && value != expected)) {
+        printf("sql_parse_int64(\"%s\") => FAILED (%s %" PRId64 ")\n", s, parsed ? "parsed" : "rejected", value);
+        failures++;
+    }
+}
+
+// the same double as strtod (the same bits, so -0.0 and 0.0 differ) and the same end
+static void check_double(const char *s) {
+    checks++;
+    char *expected_end = NULL;
+    double expected = strtod(s, &expected_end);
+    double value = 0;
+    const char *end = NULL;
+    bool parsed = sql_parse_double(s, &value, &end);
+    if (!parsed || end != expected_end ||
+        (memcmp(&value, &expected, sizeof(double)) && !(isnan(value) && isnan(expected)))) {
+        printf("sql_parse_double(\"%.60s%s\") => FAILED (%.17g, strtod %.17g)\n", s,
+               strlen(s) > 60 ? "..." : "", value, expected);
+        failures++;
+    }
+}
+
+static void check_format_int(int value) {
+    checks++;
+    char buffer[SQL_INT_BUFFER_SIZE], expected[64];
+    size_t length = sql_format_int(buffer, value);
+    snprintf(expected, sizeof(expected), "%d", value);
+    if (strcmp(buffer, expected) || length != strlen(expected)) {
+        printf("sql_format_int(%s) => FAILED (%s)\n", expected, buffer);
+        failures++;
+    }
+}
+
+static void check_format_int64(int64_t value) {
+    checks++;
+    char buffer[SQL_INT_BUFFER_SIZE], expected[64];
+    size_t length = sql_format_int64(buffer, value);
+    snprintf(expected, sizeof(expected), "%" PRId64, value);
+    if (strcmp(buffer, expected) || length != strlen(expected)) {
+        printf("sql_format_int64(%s) => FAILED (%s)\n", expected, buffer);
+        failures++;
+    }
+}
+
+static void check_format_double(double value) {
+    checks++;
+    char buffer[SQL_DOUBLE_BUFFER_SIZE], expected[SQL_DOUBLE_BUFFER_SIZE + 16];
+    size_t length = sql_format_double(buffer, value);
+    snprintf(expected, sizeof(expected), "%f", value);
+    if (strcmp(buffer, expected) || length != strlen(expected)) {
+        printf("sql_format_double(%.17g) => FAILED (%s, printf %s)\n", value, buffer, expected);
+        failures++;
+    }
+}
+
+// the data type of the literal given as the only item of a SELECT
+static void check_literal_type(const char *literal, sql_data_type_t expected) {
+    checks++;
+    aml_pool_t *pool = aml_pool_init(16384);
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = pool;
+    register_ctx(ctx);
+
+    char sql[128];
+    snprintf(sql, sizeof(sql), "SELECT %s", literal);
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_select_t *select = ast ? sql_select_compile(ctx, ast) : NULL;
+    sql_data_type_t type = select ? sql_select_item_type(select, 0) : SQL_TYPE_UNKNOWN;
+    if (type != expected) {
+        printf("%s => FAILED (%s, expected %s)\n", literal, sql_data_type_name(type), sql_data_type_name(expected));
+        failures++;
+    }
+    aml_pool_destroy(pool);
+}
+
+int main(int argc, char **argv) {
+    size_t num_random = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+
+    // int limits, the number ends where the digits do
+    check_int("0", true, 0, 1);
+    check_int("  42abc", true, 42, 4);
+    check_int("-17", true, -17, 3);
+    check_int("+17", true, 17, 3);
+    check_int("2147483647", true, INT_MAX, 10);
+    check_int("-2147483648", true, INT_MIN, 11);
+    check_int("2147483648", false, 0, 0);
+    check_int("-2147483649", false, 0, 0);
+    check_int("99999999999999999999", false, 0, 0);
+    check_int("00000000002147483647", true, INT_MAX, 20);
+    check_int("", false, 0, 0);
+    check_int("-", false, 0, 0);
+    check_int("abc", false, 0, 0);
+    check_int64("9223372036854775807", true, INT64_MAX);
+    check_int64("-9223372036854775808", true, INT64_MIN);
+    check_int64("9223372036854775808", false, 0);
+    check_int64("-9223372036854775809", false, 0);
+    check_int64("18446744073709551616", false, 0);
+
+    // doubles which need more than the first 19 digits, or an exact comparison to round
+    static const char *doubles[] = {
+        "0", "-0", "0.0", "-0.0e10", "1", "-1", "0.1", "0.3", "1.5", "2.5", "123.456", "1e5", "1E+5",
+        "3000000000", "1e23", "8.98846567431158e307", "1.7976931348623157e308", "1.7976931348623158e308",
+        "1.7976931348623159e308", "1e308", "1e309", "-1e400",
+        "9007199254740992", "9007199254740993", "9007199254740994", "9007199254740995",
+        "9007199254740993.0000000000000000000001", "18014398509481985", "18014398509481987",
+        "2.2250738585072011e-308", "2.2250738585072012e-308", "2.2250738585072014e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+        "1e-320", "3e-324", "1e-400", "-5e-324",
+        "1234567890123456789", "12345678901234567890", "123456789012345678901234567890",
+        "0.000000000000000000000000000000000000000001234567890123456789012",
+        "7.2057594037927933e16", "1.0000000000000002", "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124", "1.00000000000000011102230246251565404236316680908203126",
+        "inf", "-Infinity", "nan", "12.5xyz", "  -3.25e-2 ", ".5", "5.", "1e", "1e+",
+    };
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+        check_double(doubles[i]);
+
+    // more than 768 significant digits: halfway between two doubles until the last digit
+    char long_digits[1024];
+    for (int last = 0; last < 3; last++) {
+        size_t n = (size_t)snprintf(long_digits, sizeof(long_digits), "9007199254740993.");
+        while (n < 900)
+            long_digits[n++] = '0';
+        long_digits[n++] = (char)('0' + last);
+        long_digits[n] = '\0';
+        check_double(long_digits);
+    }
+    // 2^-1075 (halfway between 0 and the smallest subnormal) written out in full (751 significant
+    // digits, then zeros), and then with its last zero made a 1
+    snprintf(long_digits, sizeof(long_digits), "%.760Le", ldexpl(1, -1075));
+    check_double(long_digits);
+    strchr(long_digits, 'e')[-1] = '1';
+    check_double(long_digits);
+
+    // random doubles, written with 17 digits, with 25, and exactly with %f where it's short
+    srand(12345);
+    for (size_t i = 0; i < num_random; i++) {
+        uint64_t bits = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (isnan(d))
+            continue;
+        char buffer[512];
+        snprintf(buffer, sizeof(buffer), "%.17g", d);
+        check_double(buffer);
+        snprintf(buffer, sizeof(buffer), "%.25e", d);
+        check_double(buffer);
+        if (fabs(d) < 1e30) {
+            check_format_double(d);
+            check_format_double(d * 1e-6);
+        }
+    }
+
+    // formatting
+    int ints[] = {0, 1, -1, 9, 10, 99, 100, 12345, -12345, INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1};
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++)
+        check_format_int(ints[i]);
+    int64_t int64s[] = {0, -1, 4294967296LL, -4294967296LL, 999999999999999999LL, INT64_MAX, INT64_MIN};
+    for (size_t i = 0; i < sizeof(int64s) / sizeof(int64s[0]); i++)
+        check_format_int64(int64s[i]);
+    double formatted[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 2.5, 0.125, 0.0000005, 0.0000015, 0.0000025, 0.0000035, 1.0000005,
+        -0.0000005, 0.00000049999999999999999, 0.4999995, 123456.7890125, 999999.9999995, 0.9999995,
+        1e22, 1e23, 9007199254740993.0, 1e300, -1e300, DBL_MAX, -DBL_MAX, DBL_MIN, 5e-324,
+        4.35, 2.675, 1.005, 1234567.0000005, INFINITY, -INFINITY,
+    };
+    for (size_t i = 0; i < sizeof(formatted) / sizeof(formatted[0]); i++)
+        check_format_double(formatted[i]);
+    // every halfway case of the sixth decimal which is exact: k / 2^7 * 10^-6 isn't, k / 2^21 is
+    for (int k = -4096; k <= 4096; k++)
+        check_format_double((double)k / (1 << 21));
+
+    // literals which don't fit in an int, or have an exponent, are DOUBLE
+    check_literal_type("12", SQL_TYPE_INT);
+    check_literal_type("2147483647", SQL_TYPE_INT);
+    check_literal_type("2147483648", SQL_TYPE_DOUBLE);
+    check_literal_type("3000000000", SQL_TYPE_DOUBLE);
+    check_literal_type("1e5", SQL_TYPE_DOUBLE);
+    check_literal_type("1.5", SQL_TYPE_DOUBLE);
+
+    printf("%zu checks, %zu failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Scaling of parallel GROUP BY across thread counts.
+//
+//   sql_aggregate_bench [rows] [max_threads] [groups]
+//
+// Runs the same query over generated rows with 1, 2, 4, ... max_threads workers and prints the
+// time, rows per second, speedup, and efficiency (speedup / threads) of each run, and the share of
+// the groups in the largest partition of the merge.  The query is run grouped by a STRING, an INT
+// (sequential ids), and a DATETIME (hourly) key.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_parallel_aggregate.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    const char *region;
+    int quantity;
+    double amount;
+    int id;
+    time_t created;
+} bench_row_t;
+
+static sql_node_t *get_region(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_string_init(ctx, ((bench_row_t *)ctx->row)->region, false);
+}
+
+static sql_node_t *get_quantity(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((bench_row_t *)ctx->row)->quantity, false);
+}
+
+static sql_node_t *get_amount(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_double_init(ctx, ((bench_row_t *)ctx->row)->amount, false);
+}
+
+static sql_node_t *get_id(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((bench_row_t *)ctx->row)->id, false);
+}
+
+static sql_node_t *get_created(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_datetime_init(ctx, ((bench_row_t *)ctx->row)->created, false);
+}
+
+static sql_ctx_column_t columns[] = {
+    {"region", SQL_TYPE_STRING, get_region},
+    {"quantity", SQL_TYPE_INT, get_quantity},
+    {"amount", SQL_TYPE_DOUBLE, get_amount},
+    {"id", SQL_TYPE_INT, get_id},
+    {"created", SQL_TYPE_DATETIME, get_created},
+};
+
+static const char *queries[] = {
+    "SELECT region, COUNT(*), SUM(amount), AVG(quantity), MIN(amount), MAX(amount) "
+    "FROM t WHERE quantity > 10 GROUP BY region",
+    "SELECT id, COUNT(*), SUM(amount), AVG(quantity), MIN(amount), MAX(amount) "
+    "FROM t WHERE quantity > 10 GROUP BY id",
+    "SELECT created, COUNT(*), SUM(amount), AVG(quantity), MIN(amount), MAX(amount) "
+    "FROM t WHERE quantity > 10 GROUP BY created",
+};
+
+static void *row_at(void *arg, size_t index) {
+    return (bench_row_t *)arg + index;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t num_rows = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 2 ? strtoul(argv[2], NULL, 10) : (online > 0 ? (size_t)online : 1);
+    size_t num_regions = argc > 3 ? strtoul(argv[3], NULL, 10) : 1000;
+    if (!num_rows || !max_threads || !num_regions) {
+        fprintf(stderr, "Usage: %s [rows] [max_threads] [groups]\n", argv[0]);
+        return 1;
+    }
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    char **regions = (char **)aml_pool_alloc(pool, num_regions * sizeof(char *));
+    for (size_t i = 0; i < num_regions; i++)
+        regions[i] = aml_pool_strdupf(pool, "region-%zu", i);
+
+    bench_row_t *rows = (bench_row_t *)malloc(num_rows * sizeof(bench_row_t));
+    srand(42);
+    for (size_t i = 0; i < num_rows; i++) {
+        rows[i].region = regions[rand() % num_regions];
+        rows[i].quantity = rand() % 100;
+        rows[i].amount = (rand() % 100000) / 100.0;
+        rows[i].id = rand() % (int)num_regions;
+        rows[i].created = 1704067200 + (time_t)(rand() % num_regions) * 3600;
+    }
+
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const char *sql = queries[q];
+        printf("%s%s\n%zu rows, %zu groups\n\n", q ? "\n" : "", sql, num_rows, num_regions);
+        printf("%8s %10s %14s %8s %10s %10s\n", "threads", "seconds", "rows/sec", "speedup", "efficiency",
+               "largest");
+
+        double base = 0.0;
+        for (size_t threads = 1;; threads *= 2) {
+            if (threads > max_threads)
+                threads = max_threads;
+            sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+            ctx->pool = aml_pool_init(4096);
+            ctx->columns = columns;
+            ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+            register_ctx(ctx);
+
+            size_t token_count = 0;
+            sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+            sql_ast_node_t *ast = build_ast(ctx, tokens, token_count);
+
+            sql_parallel_options_t options = {.num_threads = threads};
+            double start = now();
+            sql_parallel_aggregate_t *parallel = sql_parallel_aggregate(ctx, ast, row_at, rows, num_rows, &options);
+            double seconds = now() - start;
+            if (!parallel) {
+                sql_ctx_print_messages(ctx);
+                return 1;
+            }
+            if (threads == 1)
+                base = seconds;
+            double speedup = base / seconds;
+
+            // the merge of the largest partition is the longest one
+            size_t num_groups = sql_parallel_aggregate_num_groups(parallel), largest = 0;
+            for (size_t p = 0; p < sql_parallel_aggregate_num_partitions(parallel); p++) {
+                size_t groups = sql_parallel_aggregate_partition_groups(parallel, p);
+                if (groups > largest)
+                    largest = groups;
+            }
+            printf("%8zu %10.3f %14.0f %8.2f %9.0f%% %9.0f%%  (%zu groups)\n", threads, seconds,
+                   num_rows / seconds, speedup, 100.0 * speedup / threads,
+                   num_groups ? 100.0 * largest / num_groups : 0.0, num_groups);
+
+            sql_parallel_aggregate_destroy(parallel);
+            aml_pool_destroy(ctx->pool);
+            if (threads >= max_threads)
+                break;
+        }
+    }
+
+    free(rows);
+    aml_pool_destroy(pool);
+    return 0;
+}
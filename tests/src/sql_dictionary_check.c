@@ -0,0 +1,211 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the predicates rewritten by rewrite_dictionary_predicates against the same filters on
+// a column without a dictionary.
+//
+//   sql_dictionary_check
+//
+// The dictionary has 64 entries, so the code of NULL (64) is the first bit of the second word of
+// the bitmaps.  Rows use codes in both words, the NULL code, and codes past it (also NULL).  For
+// each filter the result (TRUE, FALSE or NULL) of every row must be the same with and without the
+// dictionary, and the row must match the same way once sql_partial_eval has bound the column to
+// its value.  The number of predicates rewritten is checked too.  Exits with 1 if anything differs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_partial.h"
+#include "a-memory-library/aml_pool.h"
+
+#define DICTIONARY_SIZE 64
+
+static const char *dictionary[DICTIONARY_SIZE] = {"active", "Pending", "closed", "", "ACTIVE", "pending review"};
+
+typedef struct {
+    uint32_t code;  // DICTIONARY_SIZE or more for NULL
+    int qty;
+} check_row_t;
+
+static check_row_t rows[] = {
+    {0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {10, 7}, {63, 8},
+    {DICTIONARY_SIZE, 9}, {DICTIONARY_SIZE + 6, 1}, {0, 10}, {1, 0},
+};
+
+#define NUM_ROWS (sizeof(rows) / sizeof(rows[0]))
+
+// the filter and the number of predicates which are rewritten
+typedef struct {
+    const char *filter;
+    size_t rewrites;
+} check_filter_t;
+
+static check_filter_t filters[] = {
+    {"status = 'active'", 1},
+    {"status <> 'active'", 1},
+    {"status = ''", 1},
+    {"status IS NULL", 1},
+    {"status IS NOT NULL", 1},
+    {"NOT (status = 'active')", 1},
+    {"(status = 'active') IS NOT TRUE", 1},
+    {"(status = 'active') IS NULL", 1},
+    {"COALESCE(status, 'none') = 'none'", 1},
+    {"status IN ('active', 'closed', 'v63')", 1},
+    {"status NOT IN ('active', 'closed')", 1},
+    {"status = 'active' OR LOWER(status) LIKE 'pend%'", 1},
+    {"status LIKE '%e%' AND LENGTH(status) > 6", 1},
+    {"status = 'active' OR qty > 5", 1},
+    {"status = 'closed' AND qty > 2", 1},
+    {"(status = 'active' OR qty > 5) AND (status IS NULL OR qty < 3)", 2},
+    {"CONCAT(status, qty) = 'active1'", 0},
+    {"qty > 3", 0},
+};
+
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+static sql_node_t *get_status(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    if (row->code >= DICTIONARY_SIZE)
+        return sql_string_init(ctx, NULL, true);
+    return sql_string_init(ctx, dictionary[row->code], false);
+}
+
+static uint32_t get_status_code(sql_ctx_t *ctx, sql_ctx_column_t *column) {
+    return ((check_row_t *)ctx->row)->code;
+}
+
+static sql_node_t *get_qty(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_int_init(ctx, row->qty, false);
+}
+
+static sql_ctx_column_t dictionary_columns[] = {
+    {"status", SQL_TYPE_STRING, get_status, dictionary, DICTIONARY_SIZE, get_status_code},
+    {"qty", SQL_TYPE_INT, get_qty, NULL, 0, NULL},
+};
+
+static sql_ctx_column_t plain_columns[] = {
+    {"status", SQL_TYPE_STRING, get_status, NULL, 0, NULL},
+    {"qty", SQL_TYPE_INT, get_qty, NULL, 0, NULL},
+};
+
+#define NUM_COLUMNS (sizeof(plain_columns) / sizeof(plain_columns[0]))
+
+static sql_ctx_t *init_ctx(sql_ctx_column_t *columns) {
+    aml_pool_t *pool = aml_pool_init(64 * 1024);
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = pool;
+    ctx->columns = columns;
+    ctx->column_count = NUM_COLUMNS;
+    register_ctx(ctx);
+    return ctx;
+}
+
+static sql_node_t *compile_where(sql_ctx_t *ctx, const char *filter) {
+    char sql[512];
+    snprintf(sql, sizeof(sql), "SELECT * FROM t WHERE %s", filter);
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_ast_node_t *where = ast ? find_clause(ast, "WHERE") : NULL;
+    if (!where || !where->left)
+        return NULL;
+    sql_node_t *node = convert_ast_to_node(ctx, where->left);
+    apply_type_conversions(ctx, node);
+    sql_optimize(sql_optimizer_default(ctx), node);
+    return ctx->errors ? NULL : node;
+}
+
+static size_t count_rewrites(sql_node_t *node) {
+    if (node->token && !strcmp(node->token, "DICTIONARY") && node->token_type == SQL_FUNCTION)
+        return 1;
+    size_t n = 0;
+    for (size_t i = 0; i < node->num_parameters; i++)
+        n += count_rewrites(node->parameters[i]);
+    return n;
+}
+
+// 1 for TRUE, 0 for FALSE, -1 for NULL
+static int eval_row(sql_ctx_t *ctx, sql_node_t *node, check_row_t *row) {
+    sql_ctx_set_row(ctx, row);
+    sql_node_t *result = sql_eval(ctx, node);
+    sql_ctx_set_row(ctx, NULL);
+    if (!result || result->data_type != SQL_TYPE_BOOL || result->is_null)
+        return -1;
+    return result->value.bool_value ? 1 : 0;
+}
+
+static const char *result_name(int result) {
+    return result < 0 ? "NULL" : result ? "TRUE" : "FALSE";
+}
+
+int main(void) {
+    // the unused entries are distinct values which no filter mentions (other than v63)
+    char names[DICTIONARY_SIZE][8];
+    for (size_t i = 0; i < DICTIONARY_SIZE; i++) {
+        if (!dictionary[i]) {
+            snprintf(names[i], sizeof(names[i]), "v%zu", i);
+            dictionary[i] = names[i];
+        }
+    }
+
+    size_t failures = 0, checks = 0;
+    for (size_t f = 0; f < NUM_FILTERS; f++) {
+        const char *filter = filters[f].filter;
+        sql_ctx_t *ctx = init_ctx(dictionary_columns);
+        sql_ctx_t *plain_ctx = init_ctx(plain_columns);
+        sql_node_t *where = compile_where(ctx, filter);
+        sql_node_t *plain = compile_where(plain_ctx, filter);
+        if (!where || !plain) {
+            printf("%s => FAILED (compile)\n", filter);
+            failures++;
+            aml_pool_destroy(ctx->pool);
+            aml_pool_destroy(plain_ctx->pool);
+            continue;
+        }
+
+        size_t filter_failures = 0;
+        size_t rewrites = count_rewrites(where);
+        checks++;
+        if (rewrites != filters[f].rewrites) {
+            printf("%s => FAILED\n  %zu predicates rewritten, expected %zu\n", filter, rewrites,
+                   filters[f].rewrites);
+            filter_failures++;
+        }
+
+        for (size_t r = 0; r < NUM_ROWS; r++) {
+            int expected = eval_row(plain_ctx, plain, rows + r);
+            int actual = eval_row(ctx, where, rows + r);
+
+            // the column bound to the row's value, the lookup evaluates the literal it becomes
+            sql_ctx_set_row(ctx, rows + r);
+            sql_column_binding_t binding = {"status", get_status(ctx, NULL)};
+            sql_ctx_set_row(ctx, NULL);
+            sql_node_t *residual = sql_partial_eval(ctx, where, &binding, 1);
+            int bound = eval_row(ctx, residual, rows + r);
+
+            // (the residual is FALSE rather than NULL when the filter can't match)
+            checks++;
+            if (actual != expected || (bound == 1) != (expected == 1)) {
+                if (!filter_failures)
+                    printf("%s => FAILED\n", filter);
+                printf("  row %zu (code %u): expected %s, got %s (%s with the column bound)\n", r,
+                       rows[r].code, result_name(expected), result_name(actual), result_name(bound));
+                filter_failures++;
+            }
+        }
+        if (!filter_failures)
+            printf("%s => OK\n", filter);
+        failures += filter_failures;
+        aml_pool_destroy(ctx->pool);
+        aml_pool_destroy(plain_ctx->pool);
+    }
+
+    printf("%zu checks, %zu failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -15,8 +15,15 @@
 // Include your existing SQL-related headers
 #include "sql-parser-library/sql_ctx.h"
 #include "sql-parser-library/sql_node.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_sargable.h"
 #include "sql-parser-library/sql_ast.h"
 #include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_plan.h"
+#include "sql-parser-library/sql_select.h"
+#include "sql-parser-library/sql_order_by.h"
+#include "sql-parser-library/sql_group_by.h"
+#include "sql-parser-library/sql_strcase.h"
 #include "sql-parser-library/date_utils.h"
 
 #define MAX_PATH_LEN 1024
@@ -209,10 +216,11 @@ static void debug_one_query(my_table_t *table, const char *sql,
         print_node(ctx, where_node, 0);
         apply_type_conversions(ctx, where_node);
         print_node(ctx, where_node, 0);
-        simplify_func_tree(ctx, where_node);
-        print_node(ctx, where_node, 0);
-        simplify_logical_expressions(where_node);
+        sql_optimizer_t *optimizer = sql_optimizer_default(ctx);
+        sql_optimize(optimizer, where_node);
         print_node(ctx, where_node, 0);
+        sql_optimizer_print_stats(optimizer);
+        sql_print_sargable(ctx, sql_extract_sargable(ctx, where_node));
     }
 
     // We'll find the "id" column name if we want to compare row IDs
@@ -236,7 +244,7 @@ static void debug_one_query(my_table_t *table, const char *sql,
         if (!row_obj) continue; // skip invalid
 
         // set context->row to the JSON object
-        ctx->row = row_obj;
+        sql_ctx_set_row(ctx, row_obj);
 
         bool matched = true;
         if (where_node) {
@@ -340,8 +348,7 @@ static void run_one_query(my_table_t *table, const char *sql,
     if (where_clause && where_clause->left) {
         where_node = convert_ast_to_node(ctx, where_clause->left);
         apply_type_conversions(ctx, where_node);
-        simplify_func_tree(ctx, where_node);
-        simplify_logical_expressions(where_node);
+        sql_optimize(sql_optimizer_default(ctx), where_node);
     }
 
     // We'll find the "id" column name if we want to compare row IDs
@@ -365,7 +372,7 @@ static void run_one_query(my_table_t *table, const char *sql,
         if (!row_obj) continue; // skip invalid
 
         // set context->row to the JSON object
-        ctx->row = row_obj;
+        sql_ctx_set_row(ctx, row_obj);
 
         bool matched = true;
         if (where_node) {
@@ -433,6 +440,208 @@ static void run_one_query(my_table_t *table, const char *sql,
     }
 }
 
+//--------------------------------------------------------------
+// Format an output value the way "results" spells it ("NULL" for null)
+//--------------------------------------------------------------
+static char *format_value(aml_pool_t *pool, sql_data_type_t type, bool is_null,
+                          const sql_select_value_t *v)
+{
+    char tmp[64];
+    if (is_null)
+        return (char *)"NULL";
+    switch (type) {
+        case SQL_TYPE_BOOL:
+            return (char *)(v->value.bool_value ? "true" : "false");
+        case SQL_TYPE_INT:
+            snprintf(tmp, sizeof(tmp), "%d", v->value.int_value);
+            return aml_pool_strdup(pool, tmp);
+        case SQL_TYPE_DOUBLE:
+            snprintf(tmp, sizeof(tmp), "%g", v->value.double_value);
+            return aml_pool_strdup(pool, tmp);
+        case SQL_TYPE_DATETIME:
+            return convert_epoch_to_iso_utc(pool, v->value.epoch);
+        default:
+            return (char *)(v->value.string_value ? v->value.string_value : "");
+    }
+}
+
+static char *format_node(aml_pool_t *pool, sql_node_t *node)
+{
+    sql_select_value_t v;
+    memset(&v, 0, sizeof(v));
+    if (!node)
+        return (char *)"NULL";
+    switch (node->data_type) {
+        case SQL_TYPE_BOOL: v.value.bool_value = node->value.bool_value; break;
+        case SQL_TYPE_INT: v.value.int_value = node->value.int_value; break;
+        case SQL_TYPE_DOUBLE: v.value.double_value = node->value.double_value; break;
+        case SQL_TYPE_DATETIME: v.value.epoch = node->value.epoch; break;
+        default: v.value.string_value = node->value.string_value; break;
+    }
+    return format_value(pool, node->data_type, node->is_null, &v);
+}
+
+//--------------------------------------------------------------
+// Evaluate a query through a plan and compare its output rows with
+// "results" (in order).  Plain queries are sorted by ORDER BY (rows
+// are kept in table order without one), aggregates without GROUP BY
+// give one row and groups are in the order they are first seen.
+//--------------------------------------------------------------
+static void run_results_query(my_table_t *table, const char *sql, ajson_t *expected)
+{
+    // Build sql_ctx_t
+    sql_ctx_t *ctx = aml_pool_zalloc(g_pool, sizeof(sql_ctx_t));
+    ctx->pool = g_pool;
+    ctx->columns = table->columns;
+    ctx->column_count = table->num_columns;
+    register_ctx(ctx);
+
+    printf("%s", sql);
+
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    if (!tokens) {
+        printf(" => FAILED (Failed to tokenize.)\n");
+        return;
+    }
+    sql_ast_node_t *ast = build_ast(ctx, tokens, token_count);
+    if (!ast) {
+        printf(" => FAILED (AST build failed.)\n");
+        return;
+    }
+    sql_plan_t *plan = sql_plan_compile(ctx, ast);
+    if (!plan) {
+        printf(" => FAILED (Plan compile failed.)\n");
+        return;
+    }
+    sql_select_t *select = sql_plan_select(plan);
+    size_t num_items = sql_select_num_items(select);
+    sql_exec_t *exec = sql_exec_init(plan);
+    sql_ctx_t *exec_ctx = sql_exec_ctx(exec);
+
+    char ***actual = aml_pool_zalloc(g_pool, (table->num_rows + 1) * sizeof(char **));
+    size_t actual_count = 0;
+    sql_node_t **results = aml_pool_zalloc(g_pool, (num_items + 1) * sizeof(sql_node_t *));
+
+    if (sql_select_num_group_keys(select)) {
+        sql_group_by_t *group_by = sql_group_by_init(exec_ctx, select, 0);
+        for (size_t r = 0; r < table->num_rows; r++)
+            if (table->rows[r] && sql_exec_matches(exec, table->rows[r]))
+                sql_group_by_accumulate(exec_ctx, group_by);
+        for (size_t g = 0; g < sql_group_by_num_groups(group_by); g++) {
+            if (!sql_group_by_result(exec_ctx, group_by, g, results))
+                continue;
+            char **row = aml_pool_alloc(g_pool, (num_items + 1) * sizeof(char *));
+            for (size_t i = 0; i < num_items; i++)
+                row[i] = format_node(g_pool, results[i]);
+            actual[actual_count++] = row;
+        }
+        sql_group_by_destroy(group_by);
+    } else if (sql_select_num_aggregates(select)) {
+        void *state = aml_pool_zalloc(g_pool, sql_select_state_size(select) + 1);
+        sql_select_state_init(exec_ctx, select, state);
+        for (size_t r = 0; r < table->num_rows; r++)
+            if (table->rows[r] && sql_exec_matches(exec, table->rows[r]))
+                sql_select_accumulate(exec_ctx, select, state);
+        if (sql_select_finalize(exec_ctx, select, state, results)) {
+            char **row = aml_pool_alloc(g_pool, (num_items + 1) * sizeof(char *));
+            for (size_t i = 0; i < num_items; i++)
+                row[i] = format_node(g_pool, results[i]);
+            actual[actual_count++] = row;
+        }
+    } else {
+        // the sorted rows are indexes into the table, projected once sorted
+        sql_order_by_t *order_by = sql_order_by_init(ctx, ast, sizeof(size_t));
+        if (!order_by) {
+            printf(" => FAILED (ORDER BY compile failed.)\n");
+            sql_ctx_print_messages(ctx);
+            sql_exec_destroy(exec);
+            return;
+        }
+        for (size_t r = 0; r < table->num_rows; r++)
+            if (table->rows[r] && sql_exec_matches(exec, table->rows[r]) &&
+                !sql_order_by_add(exec_ctx, order_by, &r))
+                break;
+        sql_order_by_finish(order_by);
+        sql_select_value_t *values = aml_pool_zalloc(g_pool, (num_items + 1) * sizeof(sql_select_value_t));
+        for (size_t o = 0; o < sql_order_by_num_rows(order_by); o++) {
+            size_t r = *(const size_t *)sql_order_by_row(order_by, o);
+            if (!sql_exec_matches(exec, table->rows[r]) || !sql_exec_project(exec, values))
+                continue;
+            char **row = aml_pool_alloc(g_pool, (num_items + 1) * sizeof(char *));
+            for (size_t i = 0; i < num_items; i++)
+                row[i] = format_value(g_pool, sql_select_item_type(select, i), values[i].is_null, values + i);
+            actual[actual_count++] = row;
+        }
+        sql_order_by_destroy(order_by);
+    }
+
+    // Compare actual vs. expected, row by row and item by item
+    bool mismatch = exec_ctx->errors || (size_t)ajsona_count(expected) != actual_count;
+    for (size_t r = 0; !mismatch && r < actual_count; r++) {
+        ajson_t *exp_row = ajsona_scan(expected, (int)r);
+        if (!exp_row || ajson_type(exp_row) != array || (size_t)ajsona_count(exp_row) != num_items) {
+            mismatch = true;
+            break;
+        }
+        for (size_t i = 0; i < num_items; i++) {
+            const char *exp_value = ajson_to_strd(g_pool, ajsona_scan(exp_row, (int)i), "");
+            if (strcmp(exp_value, actual[r][i])) {
+                mismatch = true;
+                break;
+            }
+        }
+    }
+    if (mismatch) {
+        printf(" => FAILED\nGot %zu =>", actual_count);
+        for (size_t r = 0; r < actual_count; r++) {
+            printf(" [");
+            for (size_t i = 0; i < num_items; i++)
+                printf(i ? " %s" : "%s", actual[r][i]);
+            printf("]");
+        }
+        printf("\n");
+    } else {
+        printf(" => OK\n");
+    }
+    // the strings of the rows may point into the exec context's pool
+    sql_exec_destroy(exec);
+}
+
+//--------------------------------------------------------------
+// Compile a query which must be rejected with an error containing
+// "error" (case-insensitive), at any step up to ORDER BY.
+//--------------------------------------------------------------
+static void run_error_query(my_table_t *table, const char *sql, const char *error)
+{
+    sql_ctx_t *ctx = aml_pool_zalloc(g_pool, sizeof(sql_ctx_t));
+    ctx->pool = g_pool;
+    ctx->columns = table->columns;
+    ctx->column_count = table->num_columns;
+    register_ctx(ctx);
+
+    printf("%s", sql);
+
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_plan_t *plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    sql_order_by_t *order_by = plan ? sql_order_by_init(ctx, ast, sizeof(size_t)) : NULL;
+    if (order_by)
+        sql_order_by_destroy(order_by);
+
+    size_t num_errors = 0;
+    char **errors = sql_ctx_get_errors(ctx, &num_errors);
+    for (size_t i = 0; i < num_errors; i++) {
+        if (sql_strcase_find(errors[i], strlen(errors[i]), error, strlen(error))) {
+            printf(" => OK\n");
+            return;
+        }
+    }
+    printf(" => FAILED\nExpected an error with \"%s\"\n", error);
+    sql_ctx_print_messages(ctx);
+}
+
 //--------------------------------------------------------------
 // Run all queries in the "queries" array
 //--------------------------------------------------------------
@@ -462,6 +671,20 @@ static void run_all_queries(my_table_t *table, ajson_t *queries_array, int argc,
         if(found)
             continue;
 
+        // "error" is part of the message a query which must be rejected fails with
+        const char *error = ajsono_scan_strd(g_pool, qobj, "error", NULL);
+        if (error) {
+            run_error_query(table, sql, error);
+            continue;
+        }
+
+        // "results" lists the output rows (arrays of values, "NULL" for null)
+        ajson_t *results = ajsono_get(qobj, "results");
+        if (results && !ajson_is_error(results) && ajson_type(results) == array) {
+            run_results_query(table, sql, results);
+            continue;
+        }
+
         // parse the "expected" array
         ajson_t *exp = ajsono_get(qobj, "expected");
         size_t nexp = 0;
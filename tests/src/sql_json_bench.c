@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Filtering JSON objects: sql_json_row against parsing each object into an ajson tree and
+// looking the columns up by name (the getter of sql_driver.c), and sql_ndjson_scan over the
+// objects as lines of one buffer.
+//
+//   sql_json_bench [rows]
+//
+// Generates objects with six columns and three keys which aren't columns, evaluates the same WHERE
+// clause over them each way, and prints the time, rows per second, and matches of each.
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "a-json-library/ajson.h"
+#include "a-memory-library/aml_pool.h"
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_plan.h"
+#include "sql-parser-library/sql_json_row.h"
+#include "sql-parser-library/sql_ndjson.h"
+#include "sql-parser-library/date_utils.h"
+
+static const char *sql = "SELECT id FROM t WHERE LOWER(name) LIKE '%wholesale%' AND quantity > 10 "
+                         "AND amount * 1.2 > 100 AND created >= '2024-01-01' AND active";
+
+// the getter of sql_driver.c: each cell is looked up by name and converted from the tree
+static sql_node_t *ajson_getter(sql_ctx_t *ctx, sql_node_t *f) {
+    ajson_t *valnode = ajsono_get((ajson_t *)ctx->row, f->token);
+    if (!valnode || ajson_is_error(valnode))
+        return sql_string_init(ctx, "", true);
+
+    switch (f->data_type) {
+        case SQL_TYPE_INT:
+            return sql_int_init(ctx, (int)ajson_to_double(valnode, 0.0), false);
+        case SQL_TYPE_DOUBLE:
+            return sql_double_init(ctx, ajson_to_double(valnode, 0.0), false);
+        case SQL_TYPE_DATETIME: {
+            const char *strval = ajson_to_strd(ctx->pool, valnode, "");
+            time_t epoch;
+            if (convert_string_to_datetime(&epoch, ctx->pool, strval))
+                return sql_datetime_init(ctx, epoch, false);
+            return sql_datetime_init(ctx, 0, true);
+        }
+        case SQL_TYPE_BOOL:
+            return sql_bool_init(ctx, ajson_to_bool(valnode, false), false);
+        default:
+            return sql_string_init(ctx, ajson_to_strd(ctx->pool, valnode, ""), false);
+    }
+}
+
+static sql_ctx_column_t ajson_columns[] = {
+    {"id", SQL_TYPE_INT, ajson_getter},
+    {"name", SQL_TYPE_STRING, ajson_getter},
+    {"quantity", SQL_TYPE_INT, ajson_getter},
+    {"amount", SQL_TYPE_DOUBLE, ajson_getter},
+    {"created", SQL_TYPE_DATETIME, ajson_getter},
+    {"active", SQL_TYPE_BOOL, ajson_getter},
+};
+
+// the getters are set by sql_json_schema_init
+static sql_ctx_column_t json_row_columns[] = {
+    {"id", SQL_TYPE_INT},
+    {"name", SQL_TYPE_STRING},
+    {"quantity", SQL_TYPE_INT},
+    {"amount", SQL_TYPE_DOUBLE},
+    {"created", SQL_TYPE_DATETIME},
+    {"active", SQL_TYPE_BOOL},
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static sql_plan_t *compile(sql_ctx_t *ctx) {
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = build_ast(ctx, tokens, token_count);
+    sql_plan_t *plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    if (!plan)
+        sql_ctx_print_messages(ctx);
+    return plan;
+}
+
+static sql_ctx_t *new_ctx(aml_pool_t *pool, sql_ctx_column_t *columns, size_t column_count) {
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = aml_pool_init(4096);
+    ctx->columns = columns;
+    ctx->column_count = column_count;
+    register_ctx(ctx);
+    return ctx;
+}
+
+static bool count_match(void *arg, sql_exec_t *exec, const char *line, size_t length) {
+    atomic_fetch_add((atomic_size_t *)arg, 1);
+    return true;
+}
+
+static void report(const char *name, double seconds, size_t num_rows, size_t matches) {
+    printf("%-12s %10.3f %14.0f %10zu\n", name, seconds, num_rows / seconds, matches);
+}
+
+int main(int argc, char **argv) {
+    size_t num_rows = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    if (!num_rows) {
+        fprintf(stderr, "Usage: %s [rows]\n", argv[0]);
+        return 1;
+    }
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    char **objects = (char **)malloc(num_rows * sizeof(char *));
+    size_t *lengths = (size_t *)malloc(num_rows * sizeof(size_t));
+    srand(42);
+    for (size_t i = 0; i < num_rows; i++) {
+        int customer = rand() % 1000;
+        objects[i] = aml_pool_strdupf(
+            pool,
+            "{\"id\": %zu, \"name\": \"Customer-%d-%s\", \"tags\": [\"a\", \"b\", {\"c\": 1}], "
+            "\"quantity\": %d, \"note\": \"line \\\"%d\\\"\", \"amount\": %d.%02d, "
+            "\"created\": \"202%d-%02d-%02dT%02d:00:00Z\", \"meta\": {\"source\": \"x\", \"n\": [1, 2]}, "
+            "\"active\": %s}",
+            i, customer, customer % 3 ? "retail" : "Wholesale", rand() % 100, rand() % 10,
+            rand() % 1000, rand() % 100, rand() % 5, 1 + rand() % 12, 1 + rand() % 28, rand() % 24,
+            rand() % 2 ? "true" : "false");
+        lengths[i] = strlen(objects[i]);
+    }
+    printf("%s\n%zu rows\n\n", sql, num_rows);
+    printf("%-12s %10s %14s %10s\n", "source", "seconds", "rows/sec", "matches");
+
+    // an ajson tree per object, columns found by name
+    sql_ctx_t *ajson_ctx = new_ctx(pool, ajson_columns, sizeof(ajson_columns) / sizeof(ajson_columns[0]));
+    sql_plan_t *ajson_plan = compile(ajson_ctx);
+    if (!ajson_plan)
+        return 1;
+    sql_exec_t *exec = sql_exec_init(ajson_plan);
+    aml_pool_t *tree_pool = aml_pool_init(4096);
+    size_t matches = 0;
+    double start = now();
+    for (size_t i = 0; i < num_rows; i++) {
+        aml_pool_clear(tree_pool);
+        ajson_t *object = ajson_parse_string(tree_pool, aml_pool_strdup(tree_pool, objects[i]));
+        if (sql_exec_matches(exec, object))
+            matches++;
+        sql_exec_reset(exec);
+    }
+    report("ajson", now() - start, num_rows, matches);
+    sql_exec_destroy(exec);
+    aml_pool_destroy(tree_pool);
+
+    // decoded once into the columns
+    sql_ctx_t *json_row_ctx =
+        new_ctx(pool, json_row_columns, sizeof(json_row_columns) / sizeof(json_row_columns[0]));
+    sql_json_schema_t *schema = sql_json_schema_init(json_row_ctx);
+    sql_plan_t *json_row_plan = compile(json_row_ctx);
+    if (!json_row_plan)
+        return 1;
+    exec = sql_exec_init(json_row_plan);
+    sql_json_row_t *row = sql_json_row_init(schema);
+    matches = 0;
+    start = now();
+    for (size_t i = 0; i < num_rows; i++) {
+        sql_json_row_decode(row, objects[i], lengths[i]);
+        if (sql_exec_matches(exec, row))
+            matches++;
+        sql_exec_reset(exec);
+    }
+    report("sql_json_row", now() - start, num_rows, matches);
+    sql_exec_destroy(exec);
+    sql_json_row_destroy(row);
+
+    // the same objects as newline delimited JSON, scanned by a thread per processor
+    size_t size = 0;
+    for (size_t i = 0; i < num_rows; i++)
+        size += lengths[i] + 1;
+    char *ndjson = (char *)aml_pool_alloc(pool, size);
+    char *p = ndjson;
+    for (size_t i = 0; i < num_rows; i++) {
+        memcpy(p, objects[i], lengths[i]);
+        p += lengths[i];
+        *p++ = '\n';
+    }
+    atomic_size_t scan_matches;
+    atomic_init(&scan_matches, 0);
+    start = now();
+    sql_ndjson_scan(json_row_ctx, json_row_plan, schema, ndjson, size, count_match, &scan_matches, NULL);
+    report("sql_ndjson", now() - start, num_rows, atomic_load(&scan_matches));
+
+    aml_pool_destroy(ajson_ctx->pool);
+    aml_pool_destroy(json_row_ctx->pool);
+    free(objects);
+    free(lengths);
+    aml_pool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,237 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the lines reported by sql_ndjson_scan against the lines which were generated to match.
+//
+//   sql_ndjson_check [lines]
+//
+// The lines are objects (with the keys in either order, escaped newlines and braces in strings,
+// and truncated ones), blank lines, and values which aren't objects, ending in LF or CRLF.  The
+// data is scanned with and without a newline after the last line, with chunks of 1, 3, 17 and 64
+// bytes (so lines span several chunks and chunks hold no line start at all) and the default size,
+// by 1 to 8 threads.  Every matching line must be reported exactly once, at its offset with its
+// length up to the LF (a CR is part of the line), and project its id.  A scan stopped at the first
+// match on one thread must report just that line.  Exits with 1 if anything is wrong.
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_ndjson.h"
+#include "a-memory-library/aml_pool.h"
+
+static sql_ctx_column_t columns[] = {
+    {"id", SQL_TYPE_INT},
+    {"name", SQL_TYPE_STRING},
+    {"qty", SQL_TYPE_INT},
+};
+
+static const char *names[] = {"Alpha", "bravo", "Charlie", "delta", "echo", "golf", "hotel", "oscar"};
+
+typedef struct {
+    size_t offset;
+    size_t length;  // up to the LF
+    int id;         // -1 unless the line should match
+} check_line_t;
+
+static char *data;
+static size_t size;
+static check_line_t *lines;
+static size_t num_lines;
+static int *line_at;  // the line starting at each offset, or -1
+
+static bool matches(const char *name, int qty) {
+    if (qty <= 20)
+        return false;
+    for (const char *p = name; *p; p++)
+        if (*p == 'a' || *p == 'A')
+            return true;
+    return false;
+}
+
+// one line (without its line ending), returns the id if it should match or -1
+static int generate_line(char *p, size_t id) {
+    const char *name = names[rand() % (sizeof(names) / sizeof(names[0]))];
+    int qty = rand() % 40;
+    switch (rand() % 12) {
+        case 0:
+            *p = 0;
+            return -1;
+        case 1:
+            strcpy(p, "   ");
+            return -1;
+        case 2:
+            strcpy(p, rand() % 2 ? "[1, 2, {\"qty\": 30}]" : "42");
+            return -1;
+        case 3:
+            strcpy(p, rand() % 2 ? "\"text\"" : "not json");
+            return -1;
+        case 4:
+            // truncated, as the last line of a file being written can be
+            sprintf(p, "{\"id\": %zu, \"qty\": %d, \"name\": \"%s\"", id, qty, name);
+            return -1;
+        case 5:
+            sprintf(p, "  {\"qty\":%d,\"note\":\"} {\\n\\\"\",\"name\":\"%s\",\"id\":%zu}  ", qty, name, id);
+            break;
+        case 6:
+            sprintf(p, "{\"id\": %zu, \"name\": \"%s\", \"qty\": null}", id, name);
+            return -1;
+        default:
+            sprintf(p, "{\"id\": %zu, \"name\": \"%s\", \"qty\": %d, \"tags\": [\"a\", {\"b\": 1}]}", id, name, qty);
+            break;
+    }
+    return matches(name, qty) ? (int)id : -1;
+}
+
+static void generate(size_t count, bool final_newline) {
+    data = (char *)malloc(count * 160 + 1);
+    lines = (check_line_t *)malloc(count * sizeof(check_line_t));
+    char *p = data;
+    for (size_t i = 0; i < count; i++) {
+        lines[i].offset = (size_t)(p - data);
+        lines[i].id = generate_line(p, i);
+        p += strlen(p);
+        if (rand() % 4 == 0)
+            *p++ = '\r';
+        lines[i].length = (size_t)(p - data) - lines[i].offset;
+        if (i + 1 < count || final_newline)
+            *p++ = '\n';
+    }
+    size = (size_t)(p - data);
+    num_lines = count;
+    line_at = (int *)malloc((size + 1) * sizeof(int));
+    for (size_t i = 0; i <= size; i++)
+        line_at[i] = -1;
+    for (size_t i = 0; i < count; i++)
+        line_at[lines[i].offset] = (int)i;
+}
+
+typedef struct {
+    atomic_uint *seen;  // times each line was reported
+    size_t stop_after;  // stop once this many lines are reported (0 to scan every line)
+    atomic_size_t reported;
+    atomic_size_t errors;
+} check_scan_t;
+
+static void scan_error(check_scan_t *c, const char *message, size_t offset) {
+    if (atomic_fetch_add(&c->errors, 1) < 5)
+        printf("  offset %zu: %s\n", offset, message);
+}
+
+static bool check_match(void *arg, sql_exec_t *exec, const char *line, size_t length) {
+    check_scan_t *c = (check_scan_t *)arg;
+    size_t offset = (size_t)(line - data);
+    int index = offset < size ? line_at[offset] : -1;
+    if (index < 0) {
+        scan_error(c, "reported but no line starts there", offset);
+    } else if (lines[index].id < 0) {
+        scan_error(c, "reported but doesn't match", offset);
+    } else {
+        if (atomic_fetch_add(c->seen + index, 1))
+            scan_error(c, "reported twice", offset);
+        if (length != lines[index].length)
+            scan_error(c, "reported with another length", offset);
+        sql_select_value_t value;
+        if (!sql_exec_project(exec, &value) || value.is_null || value.value.int_value != lines[index].id)
+            scan_error(c, "projected another id", offset);
+    }
+    size_t reported = atomic_fetch_add(&c->reported, 1) + 1;
+    return !c->stop_after || reported < c->stop_after;
+}
+
+// runs one scan and checks it, returns false if anything is wrong
+static bool check_scan(sql_ctx_t *ctx, sql_plan_t *plan, sql_json_schema_t *schema, size_t num_threads,
+                       size_t chunk_size, size_t batch_size, size_t stop_after) {
+    check_scan_t c;
+    c.seen = (atomic_uint *)calloc(num_lines + 1, sizeof(atomic_uint));
+    c.stop_after = stop_after;
+    atomic_init(&c.reported, 0);
+    atomic_init(&c.errors, 0);
+
+    sql_ndjson_options_t options = {num_threads, chunk_size, batch_size};
+    if (!sql_ndjson_scan(ctx, plan, schema, data, size, check_match, &c, &options))
+        scan_error(&c, "the scan failed", 0);
+
+    if (!stop_after) {
+        for (size_t i = 0; i < num_lines; i++) {
+            if (lines[i].id >= 0 && !atomic_load(c.seen + i)) {
+                scan_error(&c, "not reported", lines[i].offset);
+                break;
+            }
+        }
+    } else if (atomic_load(&c.reported) != stop_after) {
+        scan_error(&c, "lines reported after the scan was stopped", atomic_load(&c.reported));
+    }
+
+    size_t errors = atomic_load(&c.errors);
+    printf("%zu threads, chunks of %zu, batches of %zu%s => %s\n", num_threads, chunk_size, batch_size,
+           stop_after ? ", stopped" : "", errors ? "FAILED" : "OK");
+    free(c.seen);
+    return !errors;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = aml_pool_init(64 * 1024);
+    ctx->columns = columns;
+    ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+    register_ctx(ctx);
+    sql_json_schema_t *schema = sql_json_schema_init(ctx);
+    const char *sql = "SELECT id FROM t WHERE qty > 20 AND name LIKE '%a%'";
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_plan_t *plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    if (!plan) {
+        sql_ctx_print_messages(ctx);
+        return 1;
+    }
+
+    size_t checks = 0, failures = 0;
+    size_t thread_counts[] = {1, 2, 4, 8};
+    size_t chunk_sizes[] = {1, 3, 17, 64, 0};
+    srand(5);
+    for (int final_newline = 1; final_newline >= 0; final_newline--) {
+        generate(count, final_newline);
+        size_t num_matches = 0;
+        for (size_t i = 0; i < num_lines; i++)
+            num_matches += lines[i].id >= 0;
+        printf("%s\n%zu lines, %zu matches, %s\n", sql, num_lines, num_matches,
+               final_newline ? "ending with a newline" : "without a newline after the last line");
+
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+            for (size_t s = 0; s < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); s++) {
+                checks++;
+                if (!check_scan(ctx, plan, schema, thread_counts[t], chunk_sizes[s], s % 2 ? 1 : 0, 0))
+                    failures++;
+            }
+        }
+        checks++;
+        if (num_matches && !check_scan(ctx, plan, schema, 1, 17, 0, 1))
+            failures++;
+        free(data);
+        free(lines);
+        free(line_at);
+    }
+
+    // nothing to scan
+    data = NULL;
+    size = num_lines = 0;
+    lines = NULL;
+    line_at = NULL;
+    checks++;
+    if (!check_scan(ctx, plan, schema, 4, 3, 0, 0))
+        failures++;
+
+    printf("%zu scans, %zu failures\n", checks, failures);
+    aml_pool_destroy(ctx->pool);
+    aml_pool_destroy(pool);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the groups of sql_parallel_aggregate and how evenly they are split for the merge.
+//
+//   sql_parallel_aggregate_check
+//
+// Rows are grouped by sequential INT ids, hourly DATETIMEs (a year of them), and strings, with
+// every key in the same number of rows.  With 8 threads every key must be one group with the
+// expected COUNT(*) and SUM, and each of the 8 partitions merged must hold between half and one
+// and a half times its share of the groups (keys which differ only in their low bits must not
+// land in one partition).  Exits with 1 if anything is wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_parallel_aggregate.h"
+#include "a-memory-library/aml_pool.h"
+
+#define NUM_THREADS 8
+#define FIRST_HOUR 1704067200
+
+typedef struct {
+    int id;
+    time_t created;
+    const char *region;
+    int qty;
+} check_row_t;
+
+static sql_node_t *get_id(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((check_row_t *)ctx->row)->id, false);
+}
+
+static sql_node_t *get_created(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_datetime_init(ctx, ((check_row_t *)ctx->row)->created, false);
+}
+
+static sql_node_t *get_region(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_string_init(ctx, ((check_row_t *)ctx->row)->region, false);
+}
+
+static sql_node_t *get_qty(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((check_row_t *)ctx->row)->qty, false);
+}
+
+static sql_ctx_column_t columns[] = {
+    {"id", SQL_TYPE_INT, get_id},
+    {"created", SQL_TYPE_DATETIME, get_created},
+    {"region", SQL_TYPE_STRING, get_region},
+    {"qty", SQL_TYPE_INT, get_qty},
+};
+
+typedef struct {
+    const char *sql;
+    size_t num_keys;
+    size_t rows_per_key;
+} check_query_t;
+
+static check_query_t queries[] = {
+    {"SELECT id, COUNT(*), SUM(qty) FROM t GROUP BY id", 100000, 2},
+    {"SELECT created, COUNT(*), SUM(qty) FROM t GROUP BY created", 8760, 3},
+    {"SELECT region, COUNT(*), SUM(qty) FROM t GROUP BY region", 1000, 5},
+};
+
+#define NUM_QUERIES (sizeof(queries) / sizeof(queries[0]))
+
+static char **regions;
+
+static void *row_at(void *arg, size_t index) {
+    return (check_row_t *)arg + index;
+}
+
+// the key of a group, as the row index it was generated from (or -1)
+static long key_index(sql_node_t *key, size_t num_keys) {
+    long index = -1;
+    switch (key->data_type) {
+        case SQL_TYPE_INT:
+            index = key->value.int_value;
+            break;
+        case SQL_TYPE_DATETIME:
+            index = (long)(key->value.epoch - FIRST_HOUR) / 3600;
+            break;
+        case SQL_TYPE_STRING:
+            index = key->value.string_value ? strtol(key->value.string_value + strlen("region-"), NULL, 10) : -1;
+            break;
+        default:
+            break;
+    }
+    return index >= 0 && (size_t)index < num_keys ? index : -1;
+}
+
+static bool check_query(sql_ctx_t *ctx, check_query_t *q) {
+    size_t num_rows = q->num_keys * q->rows_per_key;
+    check_row_t *rows = (check_row_t *)malloc(num_rows * sizeof(check_row_t));
+    for (size_t i = 0; i < num_rows; i++) {
+        size_t key = i % q->num_keys;
+        rows[i].id = (int)key;
+        rows[i].created = FIRST_HOUR + (time_t)key * 3600;
+        rows[i].region = regions[key % 1000];
+        rows[i].qty = (int)(i / q->num_keys) + 1;
+    }
+
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, q->sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_parallel_options_t options = {.num_threads = NUM_THREADS, .morsel_size = 256};
+    sql_parallel_aggregate_t *parallel = ast ? sql_parallel_aggregate(ctx, ast, row_at, rows, num_rows, &options) : NULL;
+    if (!parallel) {
+        printf("%s => FAILED (aggregate)\n", q->sql);
+        sql_ctx_print_messages(ctx);
+        free(rows);
+        return false;
+    }
+
+    size_t failures = 0;
+    size_t num_groups = sql_parallel_aggregate_num_groups(parallel);
+    if (num_groups != q->num_keys) {
+        printf("  %zu groups, expected %zu\n", num_groups, q->num_keys);
+        failures++;
+    }
+
+    // the sum of 1 to rows_per_key for every key
+    double expected_sum = (double)(q->rows_per_key * (q->rows_per_key + 1) / 2);
+    bool *seen = (bool *)calloc(q->num_keys, sizeof(bool));
+    sql_node_t *results[3];
+    for (size_t g = 0; g < num_groups; g++) {
+        sql_parallel_aggregate_result(ctx, parallel, g, results);
+        long key = key_index(results[0], q->num_keys);
+        bool ok = key >= 0 && !seen[key] && results[1]->value.int_value == (int)q->rows_per_key &&
+                  results[2]->value.double_value == expected_sum;
+        if (key >= 0)
+            seen[key] = true;
+        if (!ok && failures++ < 5)
+            printf("  group %zu (key %ld): COUNT(*) %d, SUM %g\n", g, key, results[1]->value.int_value,
+                   results[2]->value.double_value);
+    }
+    free(seen);
+
+    size_t num_partitions = sql_parallel_aggregate_num_partitions(parallel);
+    double share = (double)num_groups / num_partitions;
+    for (size_t p = 0; p < num_partitions; p++) {
+        size_t groups = sql_parallel_aggregate_partition_groups(parallel, p);
+        if (groups < share / 2 || groups > share * 1.5) {
+            printf("  partition %zu of %zu has %zu groups, expected about %.0f\n", p, num_partitions, groups,
+                   share);
+            failures++;
+        }
+    }
+    if (num_partitions != NUM_THREADS) {
+        printf("  %zu partitions, expected %d\n", num_partitions, NUM_THREADS);
+        failures++;
+    }
+
+    printf("%s => %s\n", q->sql, failures ? "FAILED" : "OK");
+    sql_parallel_aggregate_destroy(parallel);
+    free(rows);
+    return !failures;
+}
+
+int main(void) {
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    regions = (char **)aml_pool_alloc(pool, 1000 * sizeof(char *));
+    for (size_t i = 0; i < 1000; i++)
+        regions[i] = aml_pool_strdupf(pool, "region-%zu", i);
+
+    size_t failed = 0;
+    for (size_t q = 0; q < NUM_QUERIES; q++) {
+        sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+        ctx->pool = aml_pool_init(64 * 1024);
+        ctx->columns = columns;
+        ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+        register_ctx(ctx);
+        if (!check_query(ctx, queries + q))
+            failed++;
+        aml_pool_destroy(ctx->pool);
+    }
+
+    printf("%zu queries, %zu failed\n", NUM_QUERIES, failed);
+    aml_pool_destroy(pool);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the matches reported by sql_parallel_scan against a scan of the rows on one thread.
+//
+//   sql_parallel_scan_check [rows]
+//
+// The first quarter of the rows is made slow to fetch, so the worker which starts with them falls
+// behind and the others steal its morsels.  With 1 to 8 threads and morsels of 1 row up to the
+// default size, every matching row must be reported exactly once with the exec context's row set
+// to it.  Ordered, the rows must be reported in increasing order, one call at a time, and a scan
+// stopped by the callback must have reported exactly the first matches.  Exits with 1 if anything
+// is wrong.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_parallel_scan.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    const char *name;
+    int quantity;
+} check_row_t;
+
+static sql_node_t *get_name(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_string_init(ctx, ((check_row_t *)ctx->row)->name, false);
+}
+
+static sql_node_t *get_quantity(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((check_row_t *)ctx->row)->quantity, false);
+}
+
+static sql_ctx_column_t columns[] = {
+    {"name", SQL_TYPE_STRING, get_name},
+    {"quantity", SQL_TYPE_INT, get_quantity},
+};
+
+static check_row_t *rows;
+static size_t num_rows;
+static bool *expected;      // the row matches
+static atomic_uint *seen;   // times the row was reported
+static pthread_t first_thread;
+static atomic_size_t slow_rows_elsewhere;
+
+static void *row_at(void *arg, size_t index) {
+    if (index < num_rows / 4) {
+        // slow rows, counted when another thread than the caller of the scan fetches them
+        volatile size_t spin = 0;
+        for (size_t i = 0; i < 500; i++)
+            spin += i;
+        if (!pthread_equal(pthread_self(), first_thread))
+            atomic_fetch_add_explicit(&slow_rows_elsewhere, 1, memory_order_relaxed);
+    }
+    return rows + index;
+}
+
+typedef struct {
+    bool ordered;
+    size_t stop_after;       // stop once this many rows are reported (0 to scan every row)
+    atomic_size_t reported;
+    atomic_int in_callback;
+    size_t last;             // the last row reported (ordered)
+    atomic_size_t errors;
+} check_scan_t;
+
+static void scan_error(check_scan_t *c, const char *message, size_t index) {
+    if (atomic_fetch_add(&c->errors, 1) < 5)
+        printf("  row %zu: %s\n", index, message);
+}
+
+static bool check_match(void *arg, sql_exec_t *exec, size_t index) {
+    check_scan_t *c = (check_scan_t *)arg;
+    bool concurrent = atomic_fetch_add(&c->in_callback, 1) > 0;
+    if (c->ordered && concurrent)
+        scan_error(c, "reported while another row was being reported", index);
+    if (index >= num_rows || !expected[index])
+        scan_error(c, "reported but doesn't match", index);
+    else if (atomic_fetch_add(seen + index, 1))
+        scan_error(c, "reported twice", index);
+    if (sql_exec_ctx(exec)->row != rows + index)
+        scan_error(c, "reported with another row set", index);
+    if (c->ordered) {
+        if (atomic_load(&c->reported) && index <= c->last)
+            scan_error(c, "reported out of order", index);
+        c->last = index;
+    }
+
+    sql_select_value_t value;
+    if (!sql_exec_project(exec, &value) || strcmp(value.value.string_value, rows[index].name))
+        scan_error(c, "projected another name", index);
+
+    size_t reported = atomic_fetch_add(&c->reported, 1) + 1;
+    atomic_fetch_sub(&c->in_callback, 1);
+    return !c->stop_after || reported < c->stop_after;
+}
+
+// runs one scan and checks it, returns false if anything is wrong
+static bool check_scan(sql_ctx_t *ctx, sql_plan_t *plan, size_t num_threads, size_t morsel_size,
+                       bool ordered, size_t stop_after) {
+    for (size_t i = 0; i < num_rows; i++)
+        atomic_store(seen + i, 0);
+    check_scan_t c;
+    memset(&c, 0, sizeof(c));
+    c.ordered = ordered;
+    c.stop_after = stop_after;
+    atomic_init(&c.reported, 0);
+    atomic_init(&c.in_callback, 0);
+    atomic_init(&c.errors, 0);
+
+    sql_parallel_scan_options_t options = {.num_threads = num_threads, .morsel_size = morsel_size,
+                                           .ordered = ordered};
+    bool ok = sql_parallel_scan(ctx, plan, row_at, NULL, num_rows, check_match, &c, &options);
+    if (!ok)
+        scan_error(&c, "the scan failed", 0);
+
+    // every match reported, or ordered and stopped, exactly the first stop_after matches
+    size_t reported = 0, first_missing = num_rows;
+    for (size_t i = 0; i < num_rows; i++) {
+        if (atomic_load(seen + i)) {
+            reported++;
+            if (ordered && first_missing < i)
+                scan_error(&c, "reported after an earlier match which wasn't", i);
+        } else if (expected[i] && first_missing == num_rows) {
+            first_missing = i;
+        }
+    }
+    if (!stop_after && first_missing < num_rows)
+        scan_error(&c, "not reported", first_missing);
+    if (stop_after && reported < stop_after)
+        scan_error(&c, "fewer rows reported than the scan was stopped after", reported);
+    if (stop_after && ordered && reported != stop_after)
+        scan_error(&c, "rows reported after the scan was stopped", reported);
+
+    size_t errors = atomic_load(&c.errors);
+    printf("%zu threads, morsels of %zu, %s%s => %s\n", num_threads, morsel_size,
+           ordered ? "ordered" : "unordered", stop_after ? ", stopped" : "", errors ? "FAILED" : "OK");
+    return !errors;
+}
+
+int main(int argc, char **argv) {
+    num_rows = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    first_thread = pthread_self();
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    static const char *names[] = {"alpha", "Bravo", "charlie", "delta", "echo", "FOXTROT", "golf"};
+    rows = (check_row_t *)malloc((num_rows + 1) * sizeof(check_row_t));
+    expected = (bool *)calloc(num_rows + 1, sizeof(bool));
+    seen = (atomic_uint *)calloc(num_rows + 1, sizeof(atomic_uint));
+    srand(11);
+    for (size_t i = 0; i < num_rows; i++) {
+        rows[i].name = names[rand() % (sizeof(names) / sizeof(names[0]))];
+        rows[i].quantity = rand() % 100;
+    }
+
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = aml_pool_init(64 * 1024);
+    ctx->columns = columns;
+    ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+    register_ctx(ctx);
+    const char *sql = "SELECT name FROM t WHERE quantity > 40 AND LOWER(name) LIKE '%a%'";
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_plan_t *plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    if (!plan) {
+        sql_ctx_print_messages(ctx);
+        return 1;
+    }
+
+    // the expected matches, from one exec context
+    sql_exec_t *exec = sql_exec_init(plan);
+    size_t num_matches = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        expected[i] = sql_exec_matches(exec, rows + i);
+        num_matches += expected[i];
+        sql_exec_reset(exec);
+    }
+    sql_exec_destroy(exec);
+    printf("%s\n%zu rows, %zu matches\n", sql, num_rows, num_matches);
+
+    size_t checks = 0, failures = 0;
+    size_t thread_counts[] = {1, 2, 3, 4, 8};
+    size_t morsel_sizes[] = {1, 7, 1000, 0};
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        for (size_t m = 0; m < sizeof(morsel_sizes) / sizeof(morsel_sizes[0]); m++) {
+            for (int ordered = 0; ordered < 2; ordered++) {
+                checks++;
+                if (!check_scan(ctx, plan, thread_counts[t], morsel_sizes[m], ordered, 0))
+                    failures++;
+            }
+            checks++;
+            if (!check_scan(ctx, plan, thread_counts[t], morsel_sizes[m], true, num_matches / 3 + 1))
+                failures++;
+        }
+    }
+    // an empty scan reports nothing
+    size_t all_rows = num_rows;
+    num_rows = 0;
+    checks++;
+    if (!check_scan(ctx, plan, 4, 7, true, 0))
+        failures++;
+    num_rows = all_rows;
+
+    // informational, whether it happens depends on the scheduling of the threads
+    printf("%zu slow rows fetched by other threads than the first\n", atomic_load(&slow_rows_elsewhere));
+    printf("%zu scans, %zu failures\n", checks, failures);
+    free(rows);
+    free(expected);
+    free(seen);
+    aml_pool_destroy(ctx->pool);
+    aml_pool_destroy(pool);
+    return failures ? 1 : 0;
+}
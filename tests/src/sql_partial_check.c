@@ -0,0 +1,190 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks sql_partial_eval against the WHERE clause it was built from.
+//
+//   sql_partial_check
+//
+// For each filter, each row, and each set of columns, the columns are bound to the row's values
+// and the residual is evaluated for the row.  It must match the row exactly when the filter does,
+// including rows with NULL columns and filters which look at a NULL result (IS NULL, IS NOT TRUE,
+// COALESCE, NOT).  Exits with 1 if any differ.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_partial.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    int tenant_id;
+    const char *region;  // NULL for NULL
+    double amount;
+    bool tenant_id_null;
+    bool amount_null;
+} check_row_t;
+
+static check_row_t rows[] = {
+    {7, "eu", 150, false, false},
+    {7, "us", 50, false, false},
+    {7, "ap", 0, false, true},
+    {7, NULL, 150, false, false},
+    {8, "eu", 150, false, false},
+    {8, "us", 0, false, true},
+    {0, "eu", 150, true, false},
+    {0, NULL, 0, true, true},
+};
+
+#define NUM_ROWS (sizeof(rows) / sizeof(rows[0]))
+#define NUM_COLUMNS 3
+
+static const char *filters[] = {
+    "tenant_id = 7 AND region IN ('eu', 'us') AND amount > 100",
+    "tenant_id = 7 AND (region = 'eu' OR amount > 100)",
+    "tenant_id = 7 OR amount > 100",
+    "(tenant_id = 7 OR amount > 100) IS NULL",
+    "(tenant_id = 7 OR amount > 100) IS NOT TRUE",
+    "(tenant_id = 7 AND amount > 100) IS NULL",
+    "(tenant_id <> 7 AND amount > 100) IS NOT FALSE",
+    "(tenant_id = 7 AND amount > 100) IS FALSE",
+    "COALESCE(tenant_id = 7 OR amount > 100, TRUE)",
+    "NOT (tenant_id = 7 OR amount > 100)",
+    "NOT (tenant_id = 7 AND region = 'eu')",
+    "region IS NULL OR tenant_id = 7",
+    "tenant_id = 7 AND amount > 100 AND amount < 50",
+};
+
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+static sql_node_t *get_tenant_id(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_int_init(ctx, row->tenant_id, row->tenant_id_null);
+}
+
+static sql_node_t *get_region(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_string_init(ctx, row->region, row->region == NULL);
+}
+
+static sql_node_t *get_amount(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_double_init(ctx, row->amount, row->amount_null);
+}
+
+static sql_ctx_column_t columns[NUM_COLUMNS] = {
+    {"tenant_id", SQL_TYPE_INT, get_tenant_id},
+    {"region", SQL_TYPE_STRING, get_region},
+    {"amount", SQL_TYPE_DOUBLE, get_amount},
+};
+
+static sql_node_t *compile_where(sql_ctx_t *ctx, const char *filter) {
+    char sql[512];
+    snprintf(sql, sizeof(sql), "SELECT * FROM t WHERE %s", filter);
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_ast_node_t *where = ast ? find_clause(ast, "WHERE") : NULL;
+    if (!where || !where->left)
+        return NULL;
+    sql_node_t *node = convert_ast_to_node(ctx, where->left);
+    apply_type_conversions(ctx, node);
+    sql_optimize(sql_optimizer_default(ctx), node);
+    return ctx->errors ? NULL : node;
+}
+
+static bool matches(sql_ctx_t *ctx, sql_node_t *node, check_row_t *row) {
+    sql_ctx_set_row(ctx, row);
+    sql_node_t *result = sql_eval(ctx, node);
+    return result && result->data_type == SQL_TYPE_BOOL && !result->is_null && result->value.bool_value;
+}
+
+// the value of a column of row, as a binding
+static sql_node_t *column_value(sql_ctx_t *ctx, size_t column, check_row_t *row) {
+    sql_ctx_set_row(ctx, row);
+    sql_node_t *value = columns[column].func(ctx, NULL);
+    sql_ctx_set_row(ctx, NULL);
+    return value;
+}
+
+int main(void) {
+    size_t failures = 0, checks = 0, pruned = 0;
+    for (size_t f = 0; f < NUM_FILTERS; f++) {
+        aml_pool_t *pool = aml_pool_init(64 * 1024);
+        sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+        ctx->pool = pool;
+        ctx->columns = columns;
+        ctx->column_count = NUM_COLUMNS;
+        register_ctx(ctx);
+
+        sql_node_t *where = compile_where(ctx, filters[f]);
+        if (!where) {
+            printf("%s => FAILED (compile)\n", filters[f]);
+            failures++;
+            aml_pool_destroy(pool);
+            continue;
+        }
+
+        size_t filter_failures = 0;
+        for (size_t b = 0; b < NUM_ROWS; b++) {
+            // every non empty set of columns, bound to the values of row b
+            for (unsigned mask = 1; mask < (1u << NUM_COLUMNS); mask++) {
+                sql_column_binding_t bindings[NUM_COLUMNS];
+                size_t num_bindings = 0;
+                for (size_t c = 0; c < NUM_COLUMNS; c++) {
+                    if (mask & (1u << c)) {
+                        bindings[num_bindings].name = columns[c].name;
+                        bindings[num_bindings].value = column_value(ctx, c, rows + b);
+                        num_bindings++;
+                    }
+                }
+                sql_node_t *residual = sql_partial_eval(ctx, where, bindings, num_bindings);
+                if (sql_is_bool_literal(residual, false))
+                    pruned++;
+
+                // the residual applies to the rows which have the bound values
+                for (size_t r = 0; r < NUM_ROWS; r++) {
+                    bool same = true;
+                    for (size_t c = 0; c < NUM_COLUMNS && same; c++) {
+                        if (!(mask & (1u << c)))
+                            continue;
+                        check_row_t *x = rows + r, *y = rows + b;
+                        if (c == 0)
+                            same = x->tenant_id_null == y->tenant_id_null &&
+                                   (x->tenant_id_null || x->tenant_id == y->tenant_id);
+                        else if (c == 1)
+                            same = (x->region == NULL) == (y->region == NULL) &&
+                                   (!x->region || !strcmp(x->region, y->region));
+                        else
+                            same = x->amount_null == y->amount_null &&
+                                   (x->amount_null || x->amount == y->amount);
+                    }
+                    if (!same)
+                        continue;
+                    checks++;
+                    bool expected = matches(ctx, where, rows + r);
+                    bool actual = matches(ctx, residual, rows + r);
+                    if (expected != actual) {
+                        if (!filter_failures)
+                            printf("%s => FAILED\n", filters[f]);
+                        printf("  row %zu with columns %x bound: expected %s, got %s\n", r, mask,
+                               expected ? "match" : "no match", actual ? "match" : "no match");
+                        print_node(ctx, residual, 2);
+                        filter_failures++;
+                    }
+                }
+            }
+        }
+        if (!filter_failures)
+            printf("%s => OK\n", filters[f]);
+        failures += filter_failures;
+        aml_pool_destroy(pool);
+    }
+
+    printf("%zu checks, %zu residuals pruned, %zu failures\n", checks, pruned, failures);
+    return failures ? 1 : 0;
+}
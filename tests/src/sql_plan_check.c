@@ -0,0 +1,238 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks that exec contexts sharing one plan don't affect each other.
+//
+//   sql_plan_check [rows] [threads]
+//
+// Each query (with subexpressions shared between the WHERE clause and the SELECT list, so the
+// memos are used) is first evaluated over every row with one exec context, which gives the
+// expected matches and projected values.  The rows are then evaluated again by two exec contexts
+// on one thread, interleaved so that one matches a row between the other's sql_exec_matches and
+// sql_exec_project, and by several threads at once, each with its own exec context, resetting it
+// after a varying number of rows.  Every row must give the expected result.  Exits with 1 if
+// anything differs.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_plan.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    const char *name;  // NULL for NULL
+    int quantity;
+    double amount;
+    bool quantity_null;
+} check_row_t;
+
+static const char *queries[] = {
+    "SELECT name, quantity * 2 + 1, UPPER(name), amount * quantity FROM t "
+    "WHERE (quantity * 2 + 1 > 20 OR UPPER(name) LIKE 'A%') AND amount * quantity < 5000",
+    "SELECT CONCAT(LOWER(name), '-', quantity), LENGTH(LOWER(name)), quantity IS NULL FROM t "
+    "WHERE LOWER(name) LIKE '%e%' OR quantity IS NULL",
+    "SELECT SUBSTR(name, 2, 3), TRIM(name), amount / quantity, ROUND(amount) FROM t",
+};
+
+#define NUM_QUERIES (sizeof(queries) / sizeof(queries[0]))
+#define RESULT_SIZE 256
+
+static sql_node_t *get_name(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_string_init(ctx, row->name, row->name == NULL);
+}
+
+static sql_node_t *get_quantity(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_int_init(ctx, row->quantity, row->quantity_null);
+}
+
+static sql_node_t *get_amount(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_double_init(ctx, row->amount, false);
+}
+
+static sql_ctx_column_t columns[] = {
+    {"name", SQL_TYPE_STRING, get_name},
+    {"quantity", SQL_TYPE_INT, get_quantity},
+    {"amount", SQL_TYPE_DOUBLE, get_amount},
+};
+
+static check_row_t *rows;
+static size_t num_rows;
+static sql_plan_t *plan;
+static char *expected;  // RESULT_SIZE bytes per row
+static atomic_size_t failures;
+
+static void print_failure(const char *how, size_t row, const char *expected_result, const char *result) {
+    if (atomic_fetch_add(&failures, 1) < 10)
+        printf("  %s, row %zu: expected %s, got %s\n", how, row, expected_result, result);
+}
+
+// the projected values of a matching row (or "-" if it doesn't match)
+static void format_result(sql_exec_t *exec, bool matched, char *result) {
+    if (!matched) {
+        strcpy(result, "-");
+        return;
+    }
+    sql_select_t *select = sql_plan_select(plan);
+    size_t num_items = sql_select_num_items(select);
+    sql_select_value_t values[8];
+    if (!sql_exec_project(exec, values)) {
+        strcpy(result, "(project failed)");
+        return;
+    }
+    char *p = result, *end = result + RESULT_SIZE;
+    for (size_t i = 0; i < num_items && p < end; i++) {
+        if (values[i].is_null) {
+            p += snprintf(p, end - p, "|NULL");
+            continue;
+        }
+        switch (sql_select_item_type(select, i)) {
+            case SQL_TYPE_BOOL:
+                p += snprintf(p, end - p, "|%s", values[i].value.bool_value ? "true" : "false");
+                break;
+            case SQL_TYPE_INT:
+                p += snprintf(p, end - p, "|%d", values[i].value.int_value);
+                break;
+            case SQL_TYPE_DOUBLE:
+                p += snprintf(p, end - p, "|%.17g", values[i].value.double_value);
+                break;
+            case SQL_TYPE_STRING:
+                p += snprintf(p, end - p, "|%s", values[i].value.string_value);
+                break;
+            default:
+                p += snprintf(p, end - p, "|?");
+                break;
+        }
+    }
+}
+
+static void evaluate(sql_exec_t *exec, size_t row, char *result) {
+    format_result(exec, sql_exec_matches(exec, rows + row), result);
+}
+
+typedef struct {
+    size_t thread;
+    size_t num_threads;
+} worker_t;
+
+// every row, starting at a different row in each thread, resetting every thread + 1 rows
+static void *worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    sql_exec_t *exec = sql_exec_init(plan);
+    char result[RESULT_SIZE];
+    for (size_t n = 0; n < num_rows; n++) {
+        size_t row = (n + w->thread * num_rows / w->num_threads) % num_rows;
+        evaluate(exec, row, result);
+        if (strcmp(result, expected + row * RESULT_SIZE))
+            print_failure("threads", row, expected + row * RESULT_SIZE, result);
+        if (n % (w->thread + 1) == 0)
+            sql_exec_reset(exec);
+    }
+    sql_exec_destroy(exec);
+    return NULL;
+}
+
+static bool check_query(sql_ctx_t *ctx, const char *sql, size_t num_threads) {
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    if (!plan) {
+        printf("%s => FAILED (compile)\n", sql);
+        sql_ctx_print_messages(ctx);
+        return false;
+    }
+    atomic_store(&failures, 0);
+
+    // the expected results, from one exec context
+    sql_exec_t *exec = sql_exec_init(plan);
+    for (size_t r = 0; r < num_rows; r++) {
+        evaluate(exec, r, expected + r * RESULT_SIZE);
+        sql_exec_reset(exec);
+    }
+    sql_exec_destroy(exec);
+
+    // two exec contexts on one thread, each matching a row before the other projects
+    sql_exec_t *a = sql_exec_init(plan), *b = sql_exec_init(plan);
+    char a_result[RESULT_SIZE], b_result[RESULT_SIZE];
+    for (size_t r = 0; r < num_rows; r++) {
+        size_t other = num_rows - 1 - r;
+        bool a_matched = sql_exec_matches(a, rows + r);
+        bool b_matched = sql_exec_matches(b, rows + other);
+        format_result(a, a_matched, a_result);
+        format_result(b, b_matched, b_result);
+        if (strcmp(a_result, expected + r * RESULT_SIZE))
+            print_failure("interleaved", r, expected + r * RESULT_SIZE, a_result);
+        if (strcmp(b_result, expected + other * RESULT_SIZE))
+            print_failure("interleaved", other, expected + other * RESULT_SIZE, b_result);
+        if (r % 7 == 0)
+            sql_exec_reset(a);
+        if (r % 11 == 0)
+            sql_exec_reset(b);
+    }
+    sql_exec_destroy(a);
+    sql_exec_destroy(b);
+
+    pthread_t threads[64];
+    worker_t workers[64];
+    for (size_t t = 0; t < num_threads; t++) {
+        workers[t].thread = t;
+        workers[t].num_threads = num_threads;
+        pthread_create(threads + t, NULL, worker, workers + t);
+    }
+    for (size_t t = 0; t < num_threads; t++)
+        pthread_join(threads[t], NULL);
+
+    size_t query_failures = atomic_load(&failures);
+    printf("%s => %s\n", sql, query_failures ? "FAILED" : "OK");
+    return !query_failures;
+}
+
+int main(int argc, char **argv) {
+    num_rows = argc > 1 ? strtoul(argv[1], NULL, 10) : 5000;
+    size_t num_threads = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    if (!num_rows || !num_threads || num_threads > 64) {
+        fprintf(stderr, "Usage: %s [rows] [threads (1 to 64)]\n", argv[0]);
+        return 1;
+    }
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    static const char *names[] = {"Alice", "bob", "  Eve ", "amy", "Zed", "", "peter", "ANNE"};
+    size_t num_names = sizeof(names) / sizeof(names[0]);
+    rows = (check_row_t *)malloc(num_rows * sizeof(check_row_t));
+    expected = (char *)malloc(num_rows * RESULT_SIZE);
+    srand(7);
+    for (size_t i = 0; i < num_rows; i++) {
+        size_t n = rand() % (num_names + 1);
+        rows[i].name = n < num_names ? names[n] : NULL;
+        rows[i].quantity = rand() % 40 - 5;
+        rows[i].quantity_null = rand() % 10 == 0;
+        rows[i].amount = (rand() % 100000) / 100.0;
+    }
+
+    size_t failed = 0;
+    for (size_t q = 0; q < NUM_QUERIES; q++) {
+        sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+        ctx->pool = aml_pool_init(64 * 1024);
+        ctx->columns = columns;
+        ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+        register_ctx(ctx);
+        if (!check_query(ctx, queries[q], num_threads))
+            failed++;
+        aml_pool_destroy(ctx->pool);
+    }
+
+    printf("%zu queries, %zu failed\n", NUM_QUERIES, failed);
+    free(rows);
+    free(expected);
+    aml_pool_destroy(pool);
+    return failed ? 1 : 0;
+}
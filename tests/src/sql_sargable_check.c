@@ -0,0 +1,278 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks sql_extract_sargable against the WHERE clause it was built from.
+//
+//   sql_sargable_check
+//
+// For each filter the constraints are described and compared with the expected description, then
+// every row must match the filter exactly when it meets all of the constraints and the residual
+// is TRUE for it (rows with NULL columns included).  Exits with 1 if anything differs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_partial.h"
+#include "sql-parser-library/sql_sargable.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    int id;
+    const char *name;  // NULL for NULL
+    double price;
+    bool id_null;
+    bool price_null;
+} check_row_t;
+
+static check_row_t rows[] = {
+    {1, "abc", 1.0, false, false},
+    {3, "x", 2.5, false, false},
+    {5, "Abcd", 9.99, false, false},
+    {6, "ABC", 10.0, false, false},
+    {9, "b", 0, false, true},
+    {10, "abacus", 3.0, false, false},
+    {12, "Cat", 12.5, false, false},
+    {15, "abXc", 2.0, false, false},
+    {20, "d", -1.0, false, false},
+    {21, NULL, 5.0, false, false},
+    {0, "abz", 4.0, true, false},
+    {0, NULL, 0, true, true},
+};
+
+#define NUM_ROWS (sizeof(rows) / sizeof(rows[0]))
+#define NUM_COLUMNS 3
+
+// the filter and its constraints as described by describe_sargable
+typedef struct {
+    const char *filter;
+    const char *expected;
+} check_filter_t;
+
+static check_filter_t filters[] = {
+    {"id BETWEEN 10 AND 20 AND name LIKE 'ab%' AND LENGTH(name) > 3",
+     "id: NOT NULL [10, 20]; name: NOT NULL prefix 'ab'; residual"},
+    {"id > 5 AND id <= 12", "id: NOT NULL [6, 12]"},
+    {"id > 5 AND id < 6", "always false"},
+    {"id IN (1, 5, 9) AND id > 3", "id: NOT NULL IN (5, 9)"},
+    {"id IN (1, 5) AND id IN (5, 9, 1)", "id: NOT NULL IN (1, 5)"},
+    {"id IS NULL", "id: NULL"},
+    {"id IS NULL AND id > 3", "id: NULL NOT NULL [4, inf) empty; always false"},
+    {"id IS NOT NULL AND name IS NULL", "id: NOT NULL; name: NULL"},
+    {"id = 5 OR price > 2", "residual"},
+    {"name LIKE 'ab%c'", "name: NOT NULL prefix 'ab'; residual"},
+    {"name LIKE 'abc'", "name: NOT NULL ['abc', 'abc']"},
+    {"name LIKE 'ab%' AND name LIKE 'ABC%'", "name: NOT NULL prefix 'ABC'"},
+    {"name LIKE 'ab%' AND name LIKE 'x%'", "name: NOT NULL prefix 'ab' empty; always false"},
+    {"name LIKE '%b'", "residual"},
+    {"price >= 2.5 AND price < 10 AND id IS NOT NULL", "price: NOT NULL [2.5, 10); id: NOT NULL"},
+    {"name >= 'B' AND name < 'd'", "name: NOT NULL ['B', 'd')"},
+    {"NOT (id < 5) AND name IS NOT NULL", "id: NOT NULL [5, inf); name: NOT NULL"},
+    {"id = 3 AND (name = 'x' OR price > 1)", "id: NOT NULL [3, 3]; residual"},
+    {"id > 5 AND 1 = 2", "always false"},
+    {"LENGTH(name) > 3 AND price * 2 > 5", "residual"},
+};
+
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+static sql_node_t *get_id(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_int_init(ctx, row->id, row->id_null);
+}
+
+static sql_node_t *get_name(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_string_init(ctx, row->name, row->name == NULL);
+}
+
+static sql_node_t *get_price(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_double_init(ctx, row->price, row->price_null);
+}
+
+static sql_ctx_column_t columns[NUM_COLUMNS] = {
+    {"id", SQL_TYPE_INT, get_id},
+    {"name", SQL_TYPE_STRING, get_name},
+    {"price", SQL_TYPE_DOUBLE, get_price},
+};
+
+static sql_node_t *compile_where(sql_ctx_t *ctx, const char *filter) {
+    char sql[512];
+    snprintf(sql, sizeof(sql), "SELECT * FROM t WHERE %s", filter);
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_ast_node_t *where = ast ? find_clause(ast, "WHERE") : NULL;
+    if (!where || !where->left)
+        return NULL;
+    sql_node_t *node = convert_ast_to_node(ctx, where->left);
+    apply_type_conversions(ctx, node);
+    sql_optimize(sql_optimizer_default(ctx), node);
+    return ctx->errors ? NULL : node;
+}
+
+static bool matches(sql_ctx_t *ctx, sql_node_t *node, check_row_t *row) {
+    sql_ctx_set_row(ctx, row);
+    sql_node_t *result = sql_eval(ctx, node);
+    sql_ctx_set_row(ctx, NULL);
+    return result && result->data_type == SQL_TYPE_BOOL && !result->is_null && result->value.bool_value;
+}
+
+static size_t describe_value(char *p, size_t size, sql_node_t *node) {
+    switch (node->data_type) {
+        case SQL_TYPE_INT:
+            return snprintf(p, size, "%d", node->value.int_value);
+        case SQL_TYPE_DOUBLE:
+            return snprintf(p, size, "%g", node->value.double_value);
+        case SQL_TYPE_STRING:
+            return snprintf(p, size, "'%s'", node->value.string_value);
+        default:
+            return snprintf(p, size, "?");
+    }
+}
+
+// name: [NULL] [NOT NULL] [range] [prefix 'p'] [empty]; ...; [residual]; [always false]
+static void describe_sargable(sql_sargable_t *s, char *buffer, size_t size) {
+    char *p = buffer, *end = buffer + size;
+    *p = '\0';
+    for (size_t i = 0; i < s->num_columns; i++) {
+        sql_column_constraint_t *c = s->columns + i;
+        p += snprintf(p, end - p, "%s%s:", i ? "; " : "", c->name);
+        if (c->is_null)
+            p += snprintf(p, end - p, " NULL");
+        if (c->is_not_null)
+            p += snprintf(p, end - p, " NOT NULL");
+        sql_range_t *r = &c->range;
+        if (c->has_range && !r->empty && r->values) {
+            p += snprintf(p, end - p, " IN (");
+            for (size_t j = 0; j < r->num_values; j++) {
+                p += snprintf(p, end - p, "%s", j ? ", " : "");
+                p += describe_value(p, end - p, r->values[j]);
+            }
+            p += snprintf(p, end - p, ")");
+        } else if (c->has_range && !r->empty && (r->lo || r->hi)) {
+            p += snprintf(p, end - p, " %s", r->lo_inclusive ? "[" : "(");
+            p += r->lo ? describe_value(p, end - p, r->lo) : (size_t)snprintf(p, end - p, "-inf");
+            p += snprintf(p, end - p, ", ");
+            p += r->hi ? describe_value(p, end - p, r->hi) : (size_t)snprintf(p, end - p, "inf");
+            p += snprintf(p, end - p, "%s", r->hi_inclusive ? "]" : ")");
+        }
+        if (c->prefix)
+            p += snprintf(p, end - p, " prefix '%s'", c->prefix);
+        if (c->empty)
+            p += snprintf(p, end - p, " empty");
+    }
+    if (!sql_is_bool_literal(s->residual, true))
+        p += snprintf(p, end - p, "%sresidual", p == buffer ? "" : "; ");
+    if (s->always_false)
+        snprintf(p, end - p, "%salways false", p == buffer ? "" : "; ");
+}
+
+// comparisons as in comparison.c (strings ignore case)
+static int compare_values(sql_node_t *a, sql_node_t *b) {
+    if (a->data_type == SQL_TYPE_STRING)
+        return strcasecmp(a->value.string_value, b->value.string_value);
+    double x = a->data_type == SQL_TYPE_INT ? a->value.int_value : a->value.double_value;
+    double y = b->data_type == SQL_TYPE_INT ? b->value.int_value : b->value.double_value;
+    return (x > y) - (x < y);
+}
+
+static bool meets_constraint(sql_ctx_t *ctx, sql_column_constraint_t *c, check_row_t *row) {
+    if (c->empty)
+        return false;
+    sql_node_t *value = NULL;
+    for (size_t i = 0; i < NUM_COLUMNS; i++) {
+        if (!strcasecmp(columns[i].name, c->name)) {
+            sql_ctx_set_row(ctx, row);
+            value = columns[i].func(ctx, NULL);
+            sql_ctx_set_row(ctx, NULL);
+        }
+    }
+    if (!value)
+        return false;
+    if (c->is_null && !value->is_null)
+        return false;
+    if (c->is_not_null && value->is_null)
+        return false;
+    if (value->is_null)
+        return !c->has_range && !c->prefix;
+
+    sql_range_t *r = &c->range;
+    if (c->has_range) {
+        if (r->empty)
+            return false;
+        if (r->lo && compare_values(value, r->lo) < (r->lo_inclusive ? 0 : 1))
+            return false;
+        if (r->hi && compare_values(value, r->hi) > (r->hi_inclusive ? 0 : -1))
+            return false;
+        if (r->values) {
+            bool found = false;
+            for (size_t j = 0; j < r->num_values && !found; j++)
+                found = compare_values(value, r->values[j]) == 0;
+            if (!found)
+                return false;
+        }
+    }
+    if (c->prefix && strncasecmp(value->value.string_value, c->prefix, strlen(c->prefix)))
+        return false;
+    return true;
+}
+
+int main(void) {
+    size_t failures = 0, checks = 0;
+    for (size_t f = 0; f < NUM_FILTERS; f++) {
+        aml_pool_t *pool = aml_pool_init(64 * 1024);
+        sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+        ctx->pool = pool;
+        ctx->columns = columns;
+        ctx->column_count = NUM_COLUMNS;
+        register_ctx(ctx);
+
+        const char *filter = filters[f].filter;
+        sql_node_t *where = compile_where(ctx, filter);
+        if (!where) {
+            printf("%s => FAILED (compile)\n", filter);
+            failures++;
+            aml_pool_destroy(pool);
+            continue;
+        }
+
+        size_t filter_failures = 0;
+        sql_sargable_t *s = sql_extract_sargable(ctx, where);
+        char description[512];
+        describe_sargable(s, description, sizeof(description));
+        checks++;
+        if (strcmp(description, filters[f].expected)) {
+            printf("%s => FAILED\n  expected %s\n  got      %s\n", filter, filters[f].expected, description);
+            filter_failures++;
+        }
+
+        // the constraints and the residual together match the same rows as the filter
+        for (size_t r = 0; r < NUM_ROWS; r++) {
+            bool actual = !s->always_false && matches(ctx, s->residual, rows + r);
+            for (size_t i = 0; i < s->num_columns && actual; i++)
+                actual = meets_constraint(ctx, s->columns + i, rows + r);
+            bool expected = matches(ctx, where, rows + r);
+            checks++;
+            if (actual != expected) {
+                if (!filter_failures)
+                    printf("%s => FAILED\n", filter);
+                printf("  row %zu: expected %s, got %s\n", r, expected ? "match" : "no match",
+                       actual ? "match" : "no match");
+                filter_failures++;
+            }
+        }
+        if (!filter_failures)
+            printf("%s => OK\n", filter);
+        failures += filter_failures;
+        aml_pool_destroy(pool);
+    }
+
+    printf("%zu checks, %zu failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Scaling of the parallel scan across thread counts.
+//
+//   sql_scan_bench [rows] [max_threads] [morsel_size]
+//
+// Evaluates the same WHERE clause over generated rows with 1, 2, 4, ... max_threads workers, with
+// the matches reported unordered and in row order, and prints the time, rows per second, speedup,
+// and efficiency (speedup / threads) of each run.
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_parallel_scan.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    const char *name;
+    int quantity;
+    double amount;
+} bench_row_t;
+
+static sql_node_t *get_name(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_string_init(ctx, ((bench_row_t *)ctx->row)->name, false);
+}
+
+static sql_node_t *get_quantity(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_int_init(ctx, ((bench_row_t *)ctx->row)->quantity, false);
+}
+
+static sql_node_t *get_amount(sql_ctx_t *ctx, sql_node_t *f) {
+    return sql_double_init(ctx, ((bench_row_t *)ctx->row)->amount, false);
+}
+
+static sql_ctx_column_t columns[] = {
+    {"name", SQL_TYPE_STRING, get_name},
+    {"quantity", SQL_TYPE_INT, get_quantity},
+    {"amount", SQL_TYPE_DOUBLE, get_amount},
+};
+
+static void *row_at(void *arg, size_t index) {
+    return (bench_row_t *)arg + index;
+}
+
+static atomic_size_t num_matches;
+static size_t last_match;
+
+static bool count_unordered(void *arg, sql_exec_t *exec, size_t index) {
+    atomic_fetch_add_explicit(&num_matches, 1, memory_order_relaxed);
+    return true;
+}
+
+// called one row at a time, checks the order
+static bool count_ordered(void *arg, sql_exec_t *exec, size_t index) {
+    if (atomic_load_explicit(&num_matches, memory_order_relaxed) && index <= last_match) {
+        fprintf(stderr, "row %zu reported after row %zu\n", index, last_match);
+        exit(1);
+    }
+    last_match = index;
+    atomic_fetch_add_explicit(&num_matches, 1, memory_order_relaxed);
+    return true;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t num_rows = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = argc > 2 ? strtoul(argv[2], NULL, 10) : (online > 0 ? (size_t)online : 1);
+    size_t morsel_size = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+    if (!num_rows || !max_threads) {
+        fprintf(stderr, "Usage: %s [rows] [max_threads] [morsel_size]\n", argv[0]);
+        return 1;
+    }
+
+    aml_pool_t *pool = aml_pool_init(1024 * 1024);
+    const size_t num_names = 1000;
+    char **names = (char **)aml_pool_alloc(pool, num_names * sizeof(char *));
+    for (size_t i = 0; i < num_names; i++)
+        names[i] = aml_pool_strdupf(pool, "Customer-%zu-%s", i, i % 3 ? "retail" : "Wholesale");
+
+    bench_row_t *rows = (bench_row_t *)malloc(num_rows * sizeof(bench_row_t));
+    srand(42);
+    for (size_t i = 0; i < num_rows; i++) {
+        rows[i].name = names[rand() % num_names];
+        rows[i].quantity = rand() % 100;
+        rows[i].amount = (rand() % 100000) / 100.0;
+    }
+
+    sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+    ctx->pool = aml_pool_init(4096);
+    ctx->columns = columns;
+    ctx->column_count = sizeof(columns) / sizeof(columns[0]);
+    register_ctx(ctx);
+
+    const char *sql = "SELECT name FROM t WHERE LOWER(name) LIKE '%wholesale%' AND quantity > 10 "
+                      "AND amount * 1.2 > 100";
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = build_ast(ctx, tokens, token_count);
+    sql_plan_t *plan = ast ? sql_plan_compile(ctx, ast) : NULL;
+    if (!plan) {
+        sql_ctx_print_messages(ctx);
+        return 1;
+    }
+    printf("%s\n%zu rows\n", sql, num_rows);
+
+    for (int ordered = 0; ordered < 2; ordered++) {
+        printf("\n%s\n", ordered ? "ordered" : "unordered");
+        printf("%8s %10s %14s %8s %10s\n", "threads", "seconds", "rows/sec", "speedup", "efficiency");
+        double base = 0.0;
+        for (size_t threads = 1;; threads *= 2) {
+            if (threads > max_threads)
+                threads = max_threads;
+            sql_parallel_scan_options_t options = {.num_threads = threads, .morsel_size = morsel_size,
+                                                   .ordered = ordered};
+            atomic_store(&num_matches, 0);
+            double start = now();
+            if (!sql_parallel_scan(ctx, plan, row_at, rows, num_rows,
+                                   ordered ? count_ordered : count_unordered, NULL, &options)) {
+                sql_ctx_print_messages(ctx);
+                return 1;
+            }
+            double seconds = now() - start;
+            if (threads == 1)
+                base = seconds;
+            double speedup = base / seconds;
+            printf("%8zu %10.3f %14.0f %8.2f %9.0f%%  (%zu matches)\n", threads, seconds, num_rows / seconds,
+                   speedup, 100.0 * speedup / threads, atomic_load(&num_matches));
+            if (threads >= max_threads)
+                break;
+        }
+    }
+
+    aml_pool_destroy(ctx->pool);
+    free(rows);
+    aml_pool_destroy(pool);
+    return 0;
+}
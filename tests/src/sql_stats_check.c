@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks sql_eval_stats against the rows the statistics were taken from.
+//
+//   sql_stats_check
+//
+// Every run of consecutive rows is a block.  For each filter and block, ALWAYS_FALSE must only be
+// returned when no row of the block matches and ALWAYS_TRUE only when the filter is TRUE (not NULL)
+// for every row.  Blocks with NULLs, and blocks where a column is only NULL, are included, so
+// NOT, IS NOT TRUE, NOT IN and the NULL-strict AND / OR are covered.  A few blocks are also checked
+// for the exact answer, to make sure they are skipped.  Exits with 1 if anything is wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "sql-parser-library/sql_tokenizer.h"
+#include "sql-parser-library/sql_ast.h"
+#include "sql-parser-library/sql_ctx.h"
+#include "sql-parser-library/sql_optimizer.h"
+#include "sql-parser-library/sql_stats.h"
+#include "a-memory-library/aml_pool.h"
+
+typedef struct {
+    int qty;
+    double price;
+    const char *name;  // NULL for NULL
+    bool qty_null;
+    bool price_null;
+} check_row_t;
+
+static check_row_t rows[] = {
+    {1, 10.0, "apple", false, false},
+    {5, 20.5, "Banana", false, false},
+    {9, 0, "cherry", false, true},
+    {0, 0, NULL, true, true},
+    {0, 5.0, NULL, true, false},
+    {12, 30.0, "date", false, false},
+    {12, 30.0, "Date", false, false},
+    {-3, -1.5, "elder", false, false},
+    {0, 0, NULL, true, true},
+    {20, 100.0, "fig", false, false},
+};
+
+#define NUM_ROWS (sizeof(rows) / sizeof(rows[0]))
+#define NUM_COLUMNS 3
+
+static const char *filters[] = {
+    "qty > 4",
+    "qty > 20",
+    "qty BETWEEN 2 AND 10",
+    "qty NOT BETWEEN 2 AND 10",
+    "qty IN (1, 12)",
+    "qty NOT IN (1, 12)",
+    "qty IS NULL",
+    "qty IS NOT NULL",
+    "NOT (qty > 4)",
+    "(qty > 4) IS NOT TRUE",
+    "(qty > 4) IS FALSE",
+    "(qty > 4) IS NOT FALSE",
+    "qty > 4 AND price < 25",
+    "qty > 4 OR price < 25",
+    "NOT (qty > 4 OR price < 25)",
+    "(qty > 4 OR price < 25) IS NULL",
+    "qty * 2 + 1 < 10",
+    "price / qty > 2",
+    "qty - 10 >= 0",
+    "name LIKE 'd%'",
+    "name NOT LIKE 'd%'",
+    "name = 'DATE'",
+    "name <> 'date'",
+    "UPPER(name) < 'C'",
+    "qty = 12 AND name = 'date'",
+};
+
+#define NUM_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+// blocks whose answer is exact (first and last row of the block)
+typedef struct {
+    const char *filter;
+    size_t first;
+    size_t last;
+    sql_stats_result_t expected;
+} check_expected_t;
+
+static check_expected_t expected_results[] = {
+    // only NULLs: the comparison, and NOT of it, are NULL for every row
+    {"qty > 4", 3, 3, SQL_STATS_ALWAYS_FALSE},
+    {"NOT (qty > 4)", 3, 3, SQL_STATS_ALWAYS_FALSE},
+    {"(qty > 4) IS NOT TRUE", 3, 3, SQL_STATS_ALWAYS_TRUE},
+    {"(qty > 4) IS NOT FALSE", 3, 4, SQL_STATS_ALWAYS_TRUE},
+    {"(qty > 4) IS FALSE", 3, 4, SQL_STATS_ALWAYS_FALSE},
+    {"qty IS NULL", 3, 4, SQL_STATS_ALWAYS_TRUE},
+    {"qty IS NOT NULL", 3, 4, SQL_STATS_ALWAYS_FALSE},
+    {"qty NOT IN (1, 12)", 3, 4, SQL_STATS_ALWAYS_TRUE},
+    {"qty > 4 OR price < 25", 3, 4, SQL_STATS_ALWAYS_FALSE},
+    {"(qty > 4 OR price < 25) IS NULL", 3, 4, SQL_STATS_ALWAYS_TRUE},
+    // a NULL in the block keeps the answer from being ALWAYS_TRUE
+    {"qty > 4", 2, 2, SQL_STATS_ALWAYS_TRUE},
+    {"qty > 4", 2, 3, SQL_STATS_MAYBE},
+    {"(qty > 4) IS NOT FALSE", 2, 3, SQL_STATS_ALWAYS_TRUE},
+    {"qty IS NULL", 0, 2, SQL_STATS_ALWAYS_FALSE},
+    {"qty IS NULL", 0, 3, SQL_STATS_MAYBE},
+    // bounds
+    {"qty > 20", 0, 2, SQL_STATS_ALWAYS_FALSE},
+    {"qty > 4", 0, 2, SQL_STATS_MAYBE},
+    {"qty > 4", 5, 6, SQL_STATS_ALWAYS_TRUE},
+    {"NOT (qty > 4)", 5, 6, SQL_STATS_ALWAYS_FALSE},
+    {"(qty > 4) IS FALSE", 0, 0, SQL_STATS_ALWAYS_TRUE},
+    {"qty IN (1, 12)", 5, 6, SQL_STATS_ALWAYS_TRUE},
+    {"qty IN (1, 12)", 7, 7, SQL_STATS_ALWAYS_FALSE},
+    {"qty NOT BETWEEN 2 AND 10", 5, 6, SQL_STATS_ALWAYS_TRUE},
+    {"qty BETWEEN 2 AND 10", 1, 2, SQL_STATS_ALWAYS_TRUE},
+    {"qty * 2 + 1 < 10", 0, 0, SQL_STATS_ALWAYS_TRUE},
+    {"qty * 2 + 1 < 10", 0, 1, SQL_STATS_MAYBE},
+    {"qty * 2 + 1 < 10", 5, 6, SQL_STATS_ALWAYS_FALSE},
+    {"qty - 10 >= 0", 5, 6, SQL_STATS_ALWAYS_TRUE},
+    {"qty > 4 AND price < 25", 5, 6, SQL_STATS_ALWAYS_FALSE},
+    {"qty > 4 AND price < 25", 1, 1, SQL_STATS_ALWAYS_TRUE},
+    // strings compare ignoring case
+    {"name = 'DATE'", 5, 6, SQL_STATS_ALWAYS_TRUE},
+    {"name <> 'date'", 5, 6, SQL_STATS_ALWAYS_FALSE},
+    {"name LIKE 'd%'", 0, 1, SQL_STATS_ALWAYS_FALSE},
+    {"name NOT LIKE 'd%'", 0, 1, SQL_STATS_ALWAYS_TRUE},
+    {"UPPER(name) < 'C'", 5, 7, SQL_STATS_ALWAYS_FALSE},
+    {"qty = 12 AND name = 'date'", 5, 6, SQL_STATS_ALWAYS_TRUE},
+};
+
+#define NUM_EXPECTED (sizeof(expected_results) / sizeof(expected_results[0]))
+
+static sql_node_t *get_qty(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_int_init(ctx, row->qty, row->qty_null);
+}
+
+static sql_node_t *get_price(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_double_init(ctx, row->price, row->price_null);
+}
+
+static sql_node_t *get_name(sql_ctx_t *ctx, sql_node_t *f) {
+    check_row_t *row = (check_row_t *)ctx->row;
+    return sql_string_init(ctx, row->name, row->name == NULL);
+}
+
+static sql_ctx_column_t columns[NUM_COLUMNS] = {
+    {"qty", SQL_TYPE_INT, get_qty},
+    {"price", SQL_TYPE_DOUBLE, get_price},
+    {"name", SQL_TYPE_STRING, get_name},
+};
+
+static sql_node_t *compile_where(sql_ctx_t *ctx, const char *filter) {
+    char sql[512];
+    snprintf(sql, sizeof(sql), "SELECT * FROM t WHERE %s", filter);
+    size_t token_count = 0;
+    sql_token_t **tokens = sql_tokenize(ctx, sql, &token_count);
+    sql_ast_node_t *ast = tokens ? build_ast(ctx, tokens, token_count) : NULL;
+    sql_ast_node_t *where = ast ? find_clause(ast, "WHERE") : NULL;
+    if (!where || !where->left)
+        return NULL;
+    sql_node_t *node = convert_ast_to_node(ctx, where->left);
+    apply_type_conversions(ctx, node);
+    sql_optimize(sql_optimizer_default(ctx), node);
+    return ctx->errors ? NULL : node;
+}
+
+// 1 for TRUE, 0 for FALSE, -1 for NULL
+static int eval_row(sql_ctx_t *ctx, sql_node_t *node, check_row_t *row) {
+    sql_ctx_set_row(ctx, row);
+    sql_node_t *result = sql_eval(ctx, node);
+    sql_ctx_set_row(ctx, NULL);
+    if (!result || result->data_type != SQL_TYPE_BOOL || result->is_null)
+        return -1;
+    return result->value.bool_value ? 1 : 0;
+}
+
+// min / max of the non-NULL values, strings ignoring case (as sql_column_stats_t requires)
+static void block_stats(sql_ctx_t *ctx, size_t first, size_t last, sql_column_stats_t *stats) {
+    for (size_t c = 0; c < NUM_COLUMNS; c++) {
+        sql_column_stats_t *cs = stats + c;
+        memset(cs, 0, sizeof(*cs));
+        cs->name = columns[c].name;
+        cs->row_count = last - first + 1;
+        for (size_t r = first; r <= last; r++) {
+            sql_ctx_set_row(ctx, rows + r);
+            sql_node_t *value = columns[c].func(ctx, NULL);
+            sql_ctx_set_row(ctx, NULL);
+            if (value->is_null) {
+                cs->null_count++;
+                continue;
+            }
+            if (!cs->min) {
+                cs->min = cs->max = value;
+            } else if (c == 0) {
+                if (value->value.int_value < cs->min->value.int_value)
+                    cs->min = value;
+                if (value->value.int_value > cs->max->value.int_value)
+                    cs->max = value;
+            } else if (c == 1) {
+                if (value->value.double_value < cs->min->value.double_value)
+                    cs->min = value;
+                if (value->value.double_value > cs->max->value.double_value)
+                    cs->max = value;
+            } else {
+                if (strcasecmp(value->value.string_value, cs->min->value.string_value) < 0)
+                    cs->min = value;
+                if (strcasecmp(value->value.string_value, cs->max->value.string_value) > 0)
+                    cs->max = value;
+            }
+        }
+    }
+}
+
+int main(void) {
+    size_t failures = 0, checks = 0, skipped = 0;
+    for (size_t f = 0; f < NUM_FILTERS; f++) {
+        aml_pool_t *pool = aml_pool_init(64 * 1024);
+        sql_ctx_t *ctx = (sql_ctx_t *)aml_pool_zalloc(pool, sizeof(sql_ctx_t));
+        ctx->pool = pool;
+        ctx->columns = columns;
+        ctx->column_count = NUM_COLUMNS;
+        register_ctx(ctx);
+
+        sql_node_t *where = compile_where(ctx, filters[f]);
+        if (!where) {
+            printf("%s => FAILED (compile)\n", filters[f]);
+            failures++;
+            aml_pool_destroy(pool);
+            continue;
+        }
+
+        size_t filter_failures = 0;
+        for (size_t first = 0; first < NUM_ROWS; first++) {
+            for (size_t last = first; last < NUM_ROWS; last++) {
+                sql_column_stats_t stats[NUM_COLUMNS];
+                block_stats(ctx, first, last, stats);
+                sql_stats_result_t result = sql_eval_stats(ctx, where, stats, NUM_COLUMNS);
+                if (result == SQL_STATS_ALWAYS_FALSE)
+                    skipped++;
+
+                bool any_true = false, all_true = true;
+                for (size_t r = first; r <= last; r++) {
+                    int value = eval_row(ctx, where, rows + r);
+                    any_true = any_true || value == 1;
+                    all_true = all_true && value == 1;
+                }
+                bool wrong = (result == SQL_STATS_ALWAYS_FALSE && any_true) ||
+                             (result == SQL_STATS_ALWAYS_TRUE && !all_true);
+                for (size_t e = 0; e < NUM_EXPECTED; e++) {
+                    check_expected_t *x = expected_results + e;
+                    if (x->first == first && x->last == last && !strcmp(x->filter, filters[f]))
+                        wrong = wrong || result != x->expected;
+                }
+                checks++;
+                if (wrong) {
+                    if (!filter_failures)
+                        printf("%s => FAILED\n", filters[f]);
+                    printf("  rows %zu to %zu: %s\n", first, last, sql_stats_result_name(result));
+                    filter_failures++;
+                }
+            }
+        }
+        if (!filter_failures)
+            printf("%s => OK\n", filters[f]);
+        failures += filter_failures;
+        aml_pool_destroy(pool);
+    }
+
+    printf("%zu checks, %zu blocks skipped, %zu failures\n", checks, skipped, failures);
+    return failures ? 1 : 0;
+}
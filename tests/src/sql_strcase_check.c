@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2025 Andy Curtis <contactandyc@gmail.com>
+// SPDX-FileCopyrightText: 2024–2025 Knode.ai — technical questions: contact Andy (above)
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks the case insensitive string kernels against the C library (in the C locale).
+//
+//   sql_strcase_check [strings_per_length]
+//
+// Strings of the lengths around the vector widths (0, 15, 16, 17, 31, 32, 33, ...) at every
+// alignment, made of letters of both cases, the bytes next to A-Z and a-z, and bytes with the high
+// bit set, are compared with strcasecmp / strncasecmp, searched with strncasecmp at each position,
+// and cased with tolower / toupper.  Each string is also compared with a copy which differs at one
+// position, in the vector part or the tail.  Exits with 1 if anything differs.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "sql-parser-library/sql_strcase.h"
+
+static size_t checks = 0, failures = 0;
+
+static const size_t lengths[] = {0, 1, 2, 7, 8, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65, 100};
+#define NUM_LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+#define MAX_LENGTH 100
+
+// letters of both cases and the bytes either side of A-Z and a-z, high bit bytes, no NUL
+static char random_byte(void) {
+    static const char bytes[] = "aAbBzZyYmM@[`{09 _-\x80\xc3\xa9\xff\xc0\xe0\xde\xfe";
+    return bytes[rand() % (sizeof(bytes) - 1)];
+}
+
+static int sign(int x) {
+    return (x > 0) - (x < 0);
+}
+
+static void fail(const char *what, const char *a, size_t a_length, const char *b, size_t b_length) {
+    if (failures++ < 20)
+        printf("%s(\"%.*s\", \"%.*s\") => FAILED\n", what, (int)a_length, a, (int)b_length, b);
+}
+
+// the first match of b in a (strcasestr isn't standard C or POSIX)
+static const char *find_reference(const char *a, size_t a_length, const char *b, size_t b_length) {
+    for (size_t i = 0; i + b_length <= a_length; i++) {
+        if (!strncasecmp(a + i, b, b_length))
+            return a + i;
+    }
+    return NULL;
+}
+
+// a and b are NUL terminated after their lengths
+static void check_pair(const char *a, size_t a_length, const char *b, size_t b_length) {
+    checks++;
+    if (sql_strcase_equal(a, a_length, b, b_length) != (a_length == b_length && !strcasecmp(a, b)))
+        fail("sql_strcase_equal", a, a_length, b, b_length);
+    if (sign(sql_strcase_compare(a, a_length, b, b_length)) != sign(strcasecmp(a, b)))
+        fail("sql_strcase_compare", a, a_length, b, b_length);
+    bool prefix = b_length <= a_length && !strncasecmp(a, b, b_length);
+    if (sql_strcase_prefix(a, a_length, b, b_length) != prefix)
+        fail("sql_strcase_prefix", a, a_length, b, b_length);
+    bool suffix = b_length <= a_length && !strcasecmp(a + a_length - b_length, b);
+    if (sql_strcase_suffix(a, a_length, b, b_length) != suffix)
+        fail("sql_strcase_suffix", a, a_length, b, b_length);
+    const char *found = sql_strcase_find(a, a_length, b, b_length);
+    const char *expected = find_reference(a, a_length, b, b_length);
+    if (found != expected)
+        fail("sql_strcase_find", a, a_length, b, b_length);
+}
+
+static void check_case(const char *s, size_t length) {
+    char lower[MAX_LENGTH + 1], upper[MAX_LENGTH + 1], in_place[MAX_LENGTH + 1];
+    checks++;
+    sql_ascii_lower(lower, s, length);
+    sql_ascii_upper(upper, s, length);
+    memcpy(in_place, s, length);
+    sql_ascii_lower(in_place, in_place, length);
+    for (size_t i = 0; i < length; i++) {
+        if (lower[i] != (char)tolower((unsigned char)s[i]) || in_place[i] != lower[i] ||
+            upper[i] != (char)toupper((unsigned char)s[i])) {
+            fail("sql_ascii_lower / upper", s, length, s, length);
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t per_length = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    // the buffers are offset by 0 to 31 bytes, so every alignment of the vector loads is used
+    char a_buffer[MAX_LENGTH + 64], b_buffer[MAX_LENGTH + 64];
+    srand(4567);
+
+    for (size_t l = 0; l < NUM_LENGTHS; l++) {
+        size_t length = lengths[l];
+        for (size_t n = 0; n < per_length; n++) {
+            char *a = a_buffer + n % 32;
+            char *b = b_buffer + (n * 7) % 32;
+            for (size_t i = 0; i < length; i++)
+                a[i] = random_byte();
+            a[length] = '\0';
+            check_case(a, length);
+
+            // the same string in other cases, then differing at each position
+            for (size_t i = 0; i < length; i++)
+                b[i] = rand() % 2 ? sql_ascii_toupper(a[i]) : sql_ascii_tolower(a[i]);
+            b[length] = '\0';
+            check_pair(a, length, b, length);
+            for (size_t i = 0; i < length; i++) {
+                char c = b[i];
+                b[i] = random_byte();
+                check_pair(a, length, b, length);
+                b[i] = c;
+            }
+
+            // every other length of b: prefixes, suffixes, substrings, and random strings
+            for (size_t m = 0; m < NUM_LENGTHS; m++) {
+                size_t b_length = lengths[m];
+                if (b_length <= length) {
+                    size_t start = length - b_length ? (size_t)rand() % (length - b_length + 1) : 0;
+                    for (size_t i = 0; i < b_length; i++)
+                        b[i] = rand() % 2 ? sql_ascii_toupper(a[start + i]) : a[start + i];
+                    b[b_length] = '\0';
+                    check_pair(a, length, b, b_length);
+                    if (b_length) {
+                        // the needle with its last byte changed, found only by chance
+                        b[b_length - 1] = random_byte();
+                        check_pair(a, length, b, b_length);
+                    }
+                }
+                for (size_t i = 0; i < b_length; i++)
+                    b[i] = random_byte();
+                b[b_length] = '\0';
+                check_pair(a, length, b, b_length);
+                check_pair(b, b_length, a, length);
+            }
+        }
+    }
+
+    printf("%zu checks, %zu failures\n", checks, failures);
+    return failures ? 1 : 0;
+}